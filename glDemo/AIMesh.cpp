@@ -1,90 +1,143 @@
 
 #include "AIMesh.h"
-#include "TextureLoader.h"
+#include "TextureCache.h"
+#include "GLState.h"
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include <chrono>
 
 using namespace std;
 using namespace glm;
 
 
-AIMesh::AIMesh(std::string _filename, GLuint _meshIndex)
+AIMesh::AIMesh(std::string _filename, GLuint _meshIndex, MeshImporter _importer)
 {
-	const struct aiScene* scene = aiImportFile(_filename.c_str(),
-		aiProcess_GenSmoothNormals |
-		aiProcess_CalcTangentSpace |
-		aiProcess_Triangulate |
-		aiProcess_JoinIdenticalVertices |
-		aiProcess_SortByPType);
+	Decode(_filename, _meshIndex, _importer);
+	Upload();
+}
 
-	if (!scene)
+AIMesh::~AIMesh()
+{
+	delete m_cacheFile;
+	if (m_inArena)
+	{
+		MeshArena::Remove(m_range);
+	}
+	if (m_textureCached)
+	{
+		TextureCache::Release(m_textureID);
+	}
+	if (m_normalMapCached)
+	{
+		TextureCache::Release(m_normalMapID);
+	}
+}
+
+bool AIMesh::Decode(const std::string& _filename, GLuint _meshIndex, MeshImporter _importer)
+{
+	auto start = chrono::high_resolution_clock::now();
+	unsigned int importFlags = _importer == IMPORTER_ASSIMP ? IMPORT_FLAGS : 0;
+
+	// Warm start, straight out of the cache
+	m_cacheFile = new MappedFile();
+	if (MeshCache::Open(_filename, _meshIndex, _importer, importFlags, *m_cacheFile))
+	{
+		m_decodedOK = true;
+		m_loadSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+		return true;
+	}
+	delete m_cacheFile;
+	m_cacheFile = nullptr;
+
+	// Cold start, import it and keep what comes out for next time
+	m_decodedOK = _importer == IMPORTER_OBJ ? ObjLoader::Load(_filename, _meshIndex, m_decoded) : Import(_filename, _meshIndex, m_decoded);
+	if (!m_decodedOK)
 	{
 		cout << "AIMesh failed to load : " << _filename << endl;
-		return;
+		return false;
 	}
+	MeshCache::Save(_filename, _meshIndex, _importer, importFlags, m_decoded);
 
-	aiMesh* mesh = scene->mMeshes[_meshIndex];
+	m_loadSeconds = chrono::duration<double>(chrono::high_resolution_clock::now() - start).count();
+	return true;
+}
 
-	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
-
-	// Setup VBO for vertex position data
-	glGenBuffers(1, &m_meshVertexPosBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_meshVertexPosBuffer);
-	glBufferData(GL_ARRAY_BUFFER, mesh->mNumVertices * sizeof(aiVector3D), mesh->mVertices, GL_STATIC_DRAW);
-	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
-	glEnableVertexAttribArray(0);
-
-	// Setup VBO for vertex normal data
-	glGenBuffers(1, &m_meshNormalBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_meshNormalBuffer);
-	glBufferData(GL_ARRAY_BUFFER, mesh->mNumVertices * sizeof(aiVector3D), mesh->mNormals, GL_STATIC_DRAW);
-	glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
-	glEnableVertexAttribArray(3);
-
-	// *** normal mapping *** Setup VBO for tangent and bi-tangent data
-	glGenBuffers(1, &m_meshTangentBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_meshTangentBuffer);
-	glBufferData(GL_ARRAY_BUFFER, mesh->mNumVertices * sizeof(aiVector3D), mesh->mTangents, GL_STATIC_DRAW);
-	glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
-	glEnableVertexAttribArray(4);
-
-	glGenBuffers(1, &m_meshBiTangentBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_meshBiTangentBuffer);
-	glBufferData(GL_ARRAY_BUFFER, mesh->mNumVertices * sizeof(aiVector3D), mesh->mBitangents, GL_STATIC_DRAW);
-	glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
-	glEnableVertexAttribArray(5);
-
-	if (mesh->mTextureCoords && mesh->mTextureCoords[0])
+void AIMesh::Upload()
+{
+	if (!m_decodedOK)
 	{
-		// Setup VBO for texture coordinate data (for now use uvw channel 0 only when accessing mesh->mTextureCoords)
-		glGenBuffers(1, &m_meshTexCoordBuffer);
-		glBindBuffer(GL_ARRAY_BUFFER, m_meshTexCoordBuffer);
-		glBufferData(GL_ARRAY_BUFFER, mesh->mNumVertices * sizeof(aiVector3D), mesh->mTextureCoords[0], GL_STATIC_DRAW);
-		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
-		glEnableVertexAttribArray(2);
+		return;
 	}
+	auto start = chrono::high_resolution_clock::now();
 
-	// Setup VBO for mesh index buffer (face index array)
+	bool hit = m_cacheFile != nullptr;
+	if (hit)
+	{
+		m_range = MeshCache::Add(*m_cacheFile, m_bounds, m_hasTexCoords);
+		delete m_cacheFile;
+		m_cacheFile = nullptr;
+	}
+	else
+	{
+		m_range = MeshArena::Add(m_decoded.m_vertices, m_decoded.m_indices);
+		m_bounds = m_decoded.m_bounds;
+		m_hasTexCoords = m_decoded.m_hasTexCoords;
+		m_decoded = MeshData();
+	}
+	m_inArena = true;
+	m_decodedOK = false;
 
-	m_numFaces = scene->mMeshes[_meshIndex]->mNumFaces;
+	MeshCache::Record(hit, m_loadSeconds + chrono::duration<double>(chrono::high_resolution_clock::now() - start).count());
+}
 
-	// Setup contiguous array
-	const GLuint numBytes = scene->mMeshes[_meshIndex]->mNumFaces * 3 * sizeof(GLuint);
-	GLuint* faceIndexArray = (GLuint*)malloc(numBytes);
+bool AIMesh::Import(const std::string& _filename, GLuint _meshIndex, MeshData& _mesh)
+{
+	const struct aiScene* scene = aiImportFile(_filename.c_str(), IMPORT_FLAGS);
 
-	GLuint* dstPtr = faceIndexArray;
-	for (unsigned int f = 0; f < scene->mMeshes[_meshIndex]->mNumFaces; ++f, dstPtr += 3)
+	if (!scene)
+	{
+		return false;
+	}
+	if (_meshIndex >= scene->mNumMeshes)
 	{
-		memcpy_s(dstPtr, 3 * sizeof(GLuint), scene->mMeshes[_meshIndex]->mFaces[f].mIndices, 3 * sizeof(GLuint));
+		aiReleaseImport(scene);
+		return false;
 	}
 
-	glGenBuffers(1, &m_meshFaceIndexBuffer);
-	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_meshFaceIndexBuffer);
-	glBufferData(GL_ELEMENT_ARRAY_BUFFER, numBytes, faceIndexArray, GL_STATIC_DRAW);
+	aiMesh* mesh = scene->mMeshes[_meshIndex];
 
-	glBindVertexArray(0);
+	// Interleave everything the way the shared arena stores it rather than giving each mesh its own VAO and buffers
+	// meshes without texture coordinates (and so no tangents) get zeros, as an unset attribute would have
+	_mesh.m_vertices.resize(mesh->mNumVertices);
+	_mesh.m_bounds = Bounds();
+	bool hasTexCoords = mesh->mTextureCoords && mesh->mTextureCoords[0];
+	for (unsigned int v = 0; v < mesh->mNumVertices; ++v)
+	{
+		ArenaVertex& vertex = _mesh.m_vertices[v];
+		vertex.m_pos = vec3(mesh->mVertices[v].x, mesh->mVertices[v].y, mesh->mVertices[v].z);
+		vertex.m_texCoord = hasTexCoords ? vec3(mesh->mTextureCoords[0][v].x, mesh->mTextureCoords[0][v].y, mesh->mTextureCoords[0][v].z) : vec3(0.0f);
+		vertex.m_normal = mesh->mNormals ? vec3(mesh->mNormals[v].x, mesh->mNormals[v].y, mesh->mNormals[v].z) : vec3(0.0f);
+		vertex.m_tangent = mesh->mTangents ? vec3(mesh->mTangents[v].x, mesh->mTangents[v].y, mesh->mTangents[v].z) : vec3(0.0f);
+		vertex.m_biTangent = mesh->mBitangents ? vec3(mesh->mBitangents[v].x, mesh->mBitangents[v].y, mesh->mBitangents[v].z) : vec3(0.0f);
+
+		// Bounding volumes for culling, worked out once here from the vertex positions
+		_mesh.m_bounds.Add(vertex.m_pos);
+	}
+	_mesh.m_bounds.FinishSphere();
+	_mesh.m_hasTexCoords = hasTexCoords;
+
+	// Face index array, everything is triangles thanks to aiProcess_Triangulate
+	_mesh.m_indices.resize(mesh->mNumFaces * 3);
+	GLuint* dstPtr = _mesh.m_indices.data();
+	for (unsigned int f = 0; f < mesh->mNumFaces; ++f, dstPtr += 3)
+	{
+		memcpy_s(dstPtr, 3 * sizeof(GLuint), mesh->mFaces[f].mIndices, 3 * sizeof(GLuint));
+	}
 
 	// Once done, release all resources associated with this import
 	aiReleaseImport(scene);
+	return true;
 }
 
 
@@ -92,23 +145,35 @@ AIMesh::AIMesh(std::string _filename, GLuint _meshIndex)
 
 void AIMesh::addTexture(GLuint _textureID)
 {
+	if (m_textureCached)
+	{
+		TextureCache::Release(m_textureID);
+		m_textureCached = false;
+	}
 	this->m_textureID = _textureID;
 }
 
 void AIMesh::addTexture(std::string _filename, FREE_IMAGE_FORMAT _format)
 {
-	m_textureID = loadTexture(_filename, _format);
+	addTexture(TextureCache::Acquire(_filename, _format));
+	m_textureCached = true;
 }
 
 // ***normal mapping*** - helper functions to add normal map image to the object
 void AIMesh::addNormalMap(GLuint _normalMapID)
 {
+	if (m_normalMapCached)
+	{
+		TextureCache::Release(m_normalMapID);
+		m_normalMapCached = false;
+	}
 	this->m_normalMapID = _normalMapID;
 }
 
 void AIMesh::addNormalMap(std::string _filename, FREE_IMAGE_FORMAT _format)
 {
-	m_normalMapID = loadTexture(_filename, _format);
+	addNormalMap(TextureCache::Acquire(_filename, _format));
+	m_normalMapCached = true;
 }
 
 
@@ -116,23 +181,21 @@ void AIMesh::addNormalMap(std::string _filename, FREE_IMAGE_FORMAT _format)
 
 void AIMesh::setupTextures()
 {
-	if (m_meshTexCoordBuffer != 0) {
+	if (m_hasTexCoords) {
 
 		if (m_textureID != 0) {
 
-			glEnable(GL_TEXTURE_2D);
+			GLState::Enable(GL_TEXTURE_2D);
 
-			glActiveTexture(GL_TEXTURE0);
-			glBindTexture(GL_TEXTURE_2D, m_textureID);
+			GLState::BindTexture(0, m_textureID);
 
 			//  *** normal mapping ***  check if normal map added - if so bind to texture unit 1
 			if (m_normalMapID != 0) {
 
-				glActiveTexture(GL_TEXTURE1);
-				glBindTexture(GL_TEXTURE_2D, m_normalMapID);
+				GLState::BindTexture(1, m_normalMapID);
 
 				// Restore default
-				glActiveTexture(GL_TEXTURE0);
+				GLState::ActiveTexture(0);
 			}
 		}
 	}
@@ -141,8 +204,6 @@ void AIMesh::setupTextures()
 
 void AIMesh::render()
 {
-
-	glBindVertexArray(m_vao);
-	glDrawElements(GL_TRIANGLES, m_numFaces * 3, GL_UNSIGNED_INT, (const GLvoid*)0);
+	MeshArena::Bind();
+	MeshArena::Draw(m_range);
 }
-
@@ -1,28 +1,50 @@
 #pragma once
 
 #include "core.h"
+#include "Bounds.h"
+#include "MeshArena.h"
+#include "MeshData.h"
+
+class MappedFile;
 
 class AIMesh {
 
-	GLuint				m_numFaces = 0;
+	MeshRange			m_range; // where my vertices and indices are in the shared MeshArena
+	bool				m_inArena = false; // so mine to Remove
+	bool				m_hasTexCoords = false;
 
-	GLuint				m_vao = 0;
+	GLuint				m_textureID = 0;
+	GLuint				m_normalMapID = 0;
+	bool				m_textureCached = false; // from the TextureCache by file name, so mine to Release
+	bool				m_normalMapCached = false;
 
-	GLuint				m_meshVertexPosBuffer = 0;
-	GLuint				m_meshTexCoordBuffer = 0;
+	Bounds				m_bounds; // model space box and sphere around every vertex
 
-	GLuint				m_meshNormalBuffer = 0; // surface basis z
-	GLuint				m_meshTangentBuffer = 0; // surface basis x (u aligned)
-	GLuint				m_meshBiTangentBuffer = 0; // surface basis y (v aligned)
+	// what Decode found, waiting for Upload
+	MappedFile*			m_cacheFile = nullptr; // the cache file, on a hit
+	MeshData			m_decoded; // the imported mesh, on a miss
+	bool				m_decodedOK = false;
+	double				m_loadSeconds = 0.0;
 
-	GLuint				m_meshFaceIndexBuffer = 0;
+public:
 
-	GLuint				m_textureID = 0;
-	GLuint				m_normalMapID = 0;
+	// what Assimp is asked to do to every mesh, part of what a MeshCache file has to match
+	static const unsigned int IMPORT_FLAGS = aiProcess_GenSmoothNormals | aiProcess_CalcTangentSpace | aiProcess_Triangulate | aiProcess_JoinIdenticalVertices | aiProcess_SortByPType;
 
-public:
+	// from the MeshCache if there's an up to date copy there, otherwise imported (with Assimp or the ObjLoader) and then cached
+	AIMesh(std::string _filename, GLuint _meshIndex = 0, MeshImporter _importer = IMPORTER_ASSIMP);
+
+	// the same in two halves, so the slow part can be done on another thread
+	// Decode reads the cache or imports the file (and writes the cache) and is thread safe, false if it couldn't be loaded
+	// Upload then puts the mesh into the MeshArena, which must only be done on one thread at a time
+	AIMesh() {}
+	bool Decode(const std::string& _filename, GLuint _meshIndex = 0, MeshImporter _importer = IMPORTER_ASSIMP);
+	void Upload();
+
+	~AIMesh();
 
-	AIMesh(std::string _filename, GLuint _meshIndex = 0);
+	// run Assimp on one mesh of a file, false if it couldn't be loaded
+	static bool Import(const std::string& _filename, GLuint _meshIndex, MeshData& _mesh);
 
 	void addTexture(GLuint _textureID);
 	void addTexture(std::string _filename, FREE_IMAGE_FORMAT _format);
@@ -32,4 +54,9 @@ public:
 
 	void setupTextures();
 	void render();
+
+	// for building multi draw commands, see MeshArena
+	const MeshRange& getRange() const { return m_range; }
+
+	const Bounds& getBounds() const { return m_bounds; }
 };
\ No newline at end of file
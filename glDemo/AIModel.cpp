@@ -16,13 +16,43 @@ AIModel::~AIModel()
 void AIModel::Load(ifstream& _file)
 {
 	Model::Load(_file);
-	string fileName;
-	StringHelp::String(_file, "FILE", fileName);
+	StringHelp::String(_file, "FILE", m_fileName);
 
-	m_AImesh = new AIMesh(fileName);
+	//LOADER: OBJ reads it with our own OBJ loader rather than Assimp
+	string loader;
+	if (StringHelp::OptionalString(_file, "LOADER", loader))
+	{
+		if (loader == "OBJ")
+		{
+			m_importer = IMPORTER_OBJ;
+		}
+		else if (loader != "ASSIMP")
+		{
+			printf("UNKNOWN MODEL LOADER: %s \n", loader.c_str());
+			assert(0);
+		}
+	}
+
+}
+
+void AIModel::Decode()
+{
+	m_AImesh = new AIMesh();
+	m_AImesh->Decode(m_fileName, 0, m_importer);
+}
+
+void AIModel::Upload()
+{
+	m_AImesh->Upload();
+	m_bounds = m_AImesh->getBounds();
 }
 
 void AIModel::Render()
 {
 	m_AImesh->render();
 }
+
+const MeshRange* AIModel::GetMeshRange()
+{
+	return &m_AImesh->getRange();
+}
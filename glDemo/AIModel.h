@@ -1,5 +1,6 @@
 #pragma once
 #include "Model.h"
+#include "MeshData.h"
 class AIMesh;
 
 //Uses ASSIMP to load/render in an obj model
@@ -12,9 +13,15 @@ public:
 	virtual ~AIModel();
 
 	void Load(ifstream& _file);
+	virtual void Decode();
+	virtual void Upload();
 	virtual void Render();
 
+	virtual const MeshRange* GetMeshRange();
+
 protected:
 	AIMesh* m_AImesh;
+	string m_fileName;
+	MeshImporter m_importer = IMPORTER_ASSIMP;
 };
 
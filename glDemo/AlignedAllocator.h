@@ -0,0 +1,45 @@
+#pragma once
+#include <stddef.h>
+#include <malloc.h>
+#include <new>
+#include <vector>
+
+//std::allocator replacement that lines the start of every allocation up on an ALIGN byte boundary
+//used for the big per-object arrays so each one starts on its own cache line and SIMD loads never split
+template<class T, size_t ALIGN = 64>
+struct AlignedAllocator
+{
+	typedef T value_type;
+
+	template<class U>
+	struct rebind { typedef AlignedAllocator<U, ALIGN> other; };
+
+	AlignedAllocator() {}
+	template<class U>
+	AlignedAllocator(const AlignedAllocator<U, ALIGN>&) {}
+
+	T* allocate(size_t _count)
+	{
+		void* mem = _aligned_malloc(_count * sizeof(T), ALIGN);
+		if (!mem)
+		{
+			throw std::bad_alloc();
+		}
+		return (T*)mem;
+	}
+
+	void deallocate(T* _mem, size_t)
+	{
+		_aligned_free(_mem);
+	}
+};
+
+template<class T, class U, size_t ALIGN>
+bool operator==(const AlignedAllocator<T, ALIGN>&, const AlignedAllocator<U, ALIGN>&) { return true; }
+
+template<class T, class U, size_t ALIGN>
+bool operator!=(const AlignedAllocator<T, ALIGN>&, const AlignedAllocator<U, ALIGN>&) { return false; }
+
+//shorthand for a cache line aligned std::vector
+template<class T>
+using AlignedVector = std::vector<T, AlignedAllocator<T>>;
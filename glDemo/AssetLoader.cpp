@@ -0,0 +1,98 @@
+#include "AssetLoader.h"
+#include "WorkerPool.h"
+#include <thread>
+#include <chrono>
+#include <stdio.h>
+
+//seconds since some point in the past
+static double Now()
+{
+	return chrono::duration<double>(chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+void AssetLoader::Add(const string& _name, function<void()> _decode, function<void()> _finish)
+{
+	Job job;
+	job.m_name = _name;
+	job.m_decode = _decode;
+	job.m_finish = _finish;
+	m_jobs.push_back(job);
+}
+
+void AssetLoader::Run()
+{
+	double start = Now();
+
+	for (Job& job : m_jobs)
+	{
+		job.m_decoded = !job.m_decode;
+		job.m_decodeSeconds = job.m_finishSeconds = 0.0;
+	}
+
+	//the pool's ParallelFor only returns when everything is decoded, so it is driven from its own thread
+	//leaving this one free to finish assets as they become ready
+	thread decoder([this]
+	{
+		WorkerPool::ParallelFor(m_pool, m_jobs.size(), 1, [this](size_t _begin, size_t _end, size_t)
+		{
+			for (size_t i = _begin; i < _end; i++)
+			{
+				Job& job = m_jobs[i];
+				if (!job.m_decode)
+				{
+					continue;
+				}
+
+				double decodeStart = Now();
+				job.m_decode();
+				double seconds = Now() - decodeStart;
+				{
+					lock_guard<mutex> lock(m_mutex);
+					job.m_decodeSeconds = seconds;
+					job.m_decoded = true;
+				}
+				m_decoded.notify_all();
+			}
+		});
+	});
+
+	for (Job& job : m_jobs)
+	{
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_decoded.wait(lock, [&job] { return job.m_decoded; });
+		}
+		if (job.m_finish)
+		{
+			double finishStart = Now();
+			job.m_finish();
+			job.m_finishSeconds = Now() - finishStart;
+		}
+	}
+
+	decoder.join();
+	m_runSeconds = Now() - start;
+}
+
+void AssetLoader::PrintStats() const
+{
+	double decodeTotal = 0.0;
+	double finishTotal = 0.0;
+	const Job* slowest = nullptr;
+	for (const Job& job : m_jobs)
+	{
+		decodeTotal += job.m_decodeSeconds;
+		finishTotal += job.m_finishSeconds;
+		if (!slowest || job.m_decodeSeconds + job.m_finishSeconds > slowest->m_decodeSeconds + slowest->m_finishSeconds)
+		{
+			slowest = &job;
+		}
+	}
+
+	printf("ASSETS : %zu loaded in %.2f ms (one after another would be %.2f ms decoding + %.2f ms on the GL thread", m_jobs.size(), m_runSeconds * 1000.0, decodeTotal * 1000.0, finishTotal * 1000.0);
+	if (slowest)
+	{
+		printf(", slowest %s %.2f ms", slowest->m_name.c_str(), (slowest->m_decodeSeconds + slowest->m_finishSeconds) * 1000.0);
+	}
+	printf(")\n");
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <string>
+#include <vector>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+class WorkerPool;
+
+//loads a batch of assets with the slow part of each spread across a WorkerPool
+//every asset has a decode step, which must not touch GL and runs on whichever worker gets to it,
+//and a finish step which runs on the thread calling Run (the one with the GL context) once its decode is done
+//finishes go in the order the assets were added, so anything they share (like the MeshArena) fills up the same way every time
+//while the workers decode, the calling thread finishes whatever is ready, so a load takes about as long as its slowest asset
+class AssetLoader
+{
+public:
+
+	//nullptr decodes everything on one background thread, still alongside the finishes
+	AssetLoader(WorkerPool* _pool) : m_pool(_pool) {}
+
+	//either step can be empty
+	void Add(const string& _name, function<void()> _decode, function<void()> _finish);
+
+	//decode and finish everything added, only returns once all of it is done
+	void Run();
+
+	size_t NumAssets() const { return m_jobs.size(); }
+
+	//how long the last Run took against how long every decode and finish took added together
+	void PrintStats() const;
+
+protected:
+
+	struct Job
+	{
+		string m_name;
+		function<void()> m_decode;
+		function<void()> m_finish;
+		bool m_decoded = false;
+		double m_decodeSeconds = 0.0;
+		double m_finishSeconds = 0.0;
+	};
+
+	WorkerPool* m_pool;
+	vector<Job> m_jobs;
+	double m_runSeconds = 0.0;
+
+	mutex m_mutex;
+	condition_variable m_decoded;	//another job's decode has finished
+};
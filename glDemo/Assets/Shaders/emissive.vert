@@ -1,18 +1,30 @@
-#version 330 core
+#version 450 core
 
 layout(location = 0) in vec3 position;
 layout(location = 1) in vec3 normal;
 layout(location = 2) in vec2 texCoord;
 
-uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 projMatrix;
+// per frame camera values, see FrameUniforms.h
+layout (std140, binding = 0) uniform CameraBlock {
+
+	mat4 viewMatrix;
+	mat4 projMatrix;
+	vec4 camPos;
+};
+
+// per object values, see FrameUniforms.h
+// normalMatrix is the inverse-transpose of the model matrix, worked out on the CPU once when the object moves
+layout (std140, binding = 1) uniform ObjectBlock {
+
+	mat4 modelMatrix;
+	mat3 normalMatrix;
+};
 
 out vec3 fragNormal;
 out vec2 fragTexCoord;
 
 void main() {
-    fragNormal = mat3(transpose(inverse(modelMatrix))) * normal;
+    fragNormal = normalMatrix * normal;
     fragTexCoord = texCoord;
     gl_Position = projMatrix * viewMatrix * modelMatrix * vec4(position, 1.0);
 }
@@ -1,8 +1,20 @@
 #version 450 core
 
-uniform mat4 modelMatrix;
-uniform mat4 viewMatrix;
-uniform mat4 projMatrix;
+// per frame camera values, see FrameUniforms.h
+layout (std140, binding = 0) uniform CameraBlock {
+
+	mat4 viewMatrix;
+	mat4 projMatrix;
+	vec4 camPos;
+};
+
+// per object values, see FrameUniforms.h
+// normalMatrix is the inverse-transpose of the model matrix, worked out on the CPU once when the object moves
+layout (std140, binding = 1) uniform ObjectBlock {
+
+	mat4 modelMatrix;
+	mat3 normalMatrix;
+};
 
 layout (location=0) in vec3 vertexPos;
 layout (location=2) in vec3 vertexTexCoord;
@@ -0,0 +1,44 @@
+#version 450 core
+
+// Instanced version of texture-directional.vert
+// the model and normal matrices come in per instance from the Scene's instance buffer instead of uniforms
+
+// per frame camera values, see FrameUniforms.h
+layout (std140, binding = 0) uniform CameraBlock {
+
+	mat4 viewMatrix;
+	mat4 projMatrix;
+	vec4 camPos;
+};
+
+layout (location=0) in vec3 vertexPos;
+layout (location=2) in vec3 vertexTexCoord;
+layout (location=3) in vec3 vertexNormal;
+
+// per instance, mat4 takes locations 6 to 9 and mat3 10 to 12
+layout (location=6) in mat4 instanceModelMatrix;
+layout (location=10) in mat3 instanceNormalMatrix;
+
+out SimplePacket {
+
+  vec3 surfaceWorldPos;
+  vec3 surfaceNormal;
+	vec2 texCoord;
+
+} outputVertex;
+
+
+void main(void) {
+
+	outputVertex.texCoord = vertexTexCoord.st;
+
+  // transform normal vector by inverse-transpose of the model matrix
+  outputVertex.surfaceNormal = instanceNormalMatrix * vertexNormal;
+
+  // take vertexPos into world coords and pass onto fragment shader
+  vec4 worldCoord = instanceModelMatrix * vec4(vertexPos, 1.0);
+  outputVertex.surfaceWorldPos = worldCoord.xyz; // don't need w element
+
+  // take worldCoord rest of the way into clip coords and set in gl_Position
+	gl_Position = projMatrix * viewMatrix * worldCoord;
+}
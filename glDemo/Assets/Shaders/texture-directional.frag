@@ -1,15 +1,33 @@
 #version 450 core
 
-// Diffuse texture - directional light
+// Diffuse texture - the lights in the scene's light buffer that reach each fragment
 
 // Texture sampler (for diffuse surface colour)
 layout(binding = 0) uniform sampler2D texture;
 
-// Directional light model
-uniform vec3 DIRDir;
-uniform vec3 DIRCol;
-uniform vec3 DIRAmb;
+// one light, see LightBuffer.h
+struct Light {
 
+	vec4 posType;	// xyz position, w 0 for a point light, 1 for a directional light
+	vec4 dirRange;	// xyz direction (directional lights), w range (point lights)
+	vec4 col;
+	vec4 amb;
+};
+
+layout(std430, binding = 2) readonly buffer LightBlock {
+
+	uvec4 lightCount;	// only x is used
+	Light lights[];
+};
+
+
+// which lights can reach where, see LightGrid in LightBuffer.h
+layout(std430, binding = 3) readonly buffer LightGridBlock {
+
+	vec4 gridMin;	// xyz corner of the grid, w 1 / cell size
+	uvec4 gridDims;	// xyz cells along each axis, w cells in total
+	uint gridData[];	// first and count per cell, one more pair for lights that reach everywhere, then the light indices
+};
 
 in SimplePacket {
 	
@@ -24,18 +42,55 @@ layout (location=0) out vec4 fragColour;
 
 void main(void) {
 
-	// calculate lambertian (l)
 	vec3 N = normalize(inputFragment.surfaceNormal);
-	float l = dot(N, DIRDir);
+
+	// add up the lambertian (l) diffuse and ambient contributions of the lights that can reach here
+	vec3 diffuse = vec3(0.0);
+	vec3 ambient = vec3(0.0);
+
+	// directional, reach everywhere
+	uint first = gridData[gridDims.w * 2];
+	uint count = gridData[gridDims.w * 2 + 1];
+	for (uint j = 0; j < count; j++) {
+
+		uint i = gridData[first + j];
+		float l = dot(N, lights[i].dirRange.xyz);
+		diffuse += lights[i].col.rgb * l;
+		ambient += lights[i].amb.rgb;
+	}
+
+	// point, only those listed for this fragment's cell (none outside the grid)
+	ivec3 cell = ivec3(floor((inputFragment.surfaceWorldPos - gridMin.xyz) * gridMin.w));
+	if (all(greaterThanEqual(cell, ivec3(0))) && all(lessThan(cell, ivec3(gridDims.xyz)))) {
+
+		uint index = (uint(cell.z) * gridDims.y + uint(cell.y)) * gridDims.x + uint(cell.x);
+		first = gridData[index * 2];
+		count = gridData[index * 2 + 1];
+		for (uint j = 0; j < count; j++) {
+
+			// fades out to nothing at its range
+			uint i = gridData[first + j];
+			vec3 toLight = lights[i].posType.xyz - inputFragment.surfaceWorldPos;
+			float d = length(toLight);
+			float range = lights[i].dirRange.w;
+			if (d < range) {
+
+				float fade = 1.0 - d / range;
+				fade *= fade;
+				float l = max(dot(N, toLight / d), 0.0);
+				diffuse += lights[i].col.rgb * l * fade;
+				ambient += lights[i].amb.rgb * fade;
+			}
+		}
+	}
 
 	// Calculate diffuse brightness / colour for fragment
 	vec4 surfaceColour = texture2D(texture, inputFragment.texCoord);
-	vec3 diffuseColour = surfaceColour.rgb * DIRCol * l;
+	vec3 diffuseColour = surfaceColour.rgb * diffuse;
 
 	// Set the alpha value for transparency (e.g., 0.5 for 50% transparency)
 	float alpha = 0.5;
 
 	// Combine ambient and diffuse components with transparency
-	fragColour = vec4(DIRAmb, 0.01) + vec4(diffuseColour, alpha);
+	fragColour = vec4(ambient, 0.01) + vec4(diffuseColour, alpha);
 }
-
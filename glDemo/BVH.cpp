@@ -0,0 +1,491 @@
+#include "BVH.h"
+#include <algorithm>
+
+//half the surface area of a box, all the SAH cares about is the ratio between boxes
+static inline float HalfArea(const vec3& _min, const vec3& _max)
+{
+	vec3 size = glm::max(_max - _min, vec3(0.0f));
+	return size.x * size.y + size.y * size.z + size.z * size.x;
+}
+
+BVH::BVH()
+{
+}
+
+BVH::~BVH()
+{
+}
+
+void BVH::ItemBounds(uint32_t _first, uint32_t _count, vec3& _min, vec3& _max) const
+{
+	_min = vec3(FLT_MAX);
+	_max = vec3(-FLT_MAX);
+	for (uint32_t i = _first; i < _first + _count; i++)
+	{
+		_min = glm::min(_min, m_bounds->GetMin(m_items[i]));
+		_max = glm::max(_max, m_bounds->GetMax(m_items[i]));
+	}
+}
+
+void BVH::Build(const WorldBounds* _bounds)
+{
+	m_bounds = _bounds;
+	const size_t count = m_bounds->Size();
+
+	m_items.clear();
+	m_unbounded.clear();
+	m_leafOf.assign(count, (uint32_t)NO_NODE);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (m_bounds->m_radius[i] >= WorldBounds::UNBOUNDED)
+		{
+			m_unbounded.push_back((uint32_t)i);
+		}
+		else
+		{
+			m_items.push_back((uint32_t)i);
+		}
+	}
+
+	//box centres, in the same order as m_items while building
+	vector<vec3> centres(m_items.size());
+	for (size_t i = 0; i < m_items.size(); i++)
+	{
+		centres[i] = vec3(m_bounds->m_boxX[m_items[i]], m_bounds->m_boxY[m_items[i]], m_bounds->m_boxZ[m_items[i]]);
+	}
+
+	m_nodes.clear();
+	m_nodes.reserve(2 * m_items.size() / LEAF_SIZE + 1);
+
+	Node root;
+	root.m_first = 0;
+	root.m_count = (uint32_t)m_items.size();
+	root.m_left = 0;
+	root.m_parent = NO_NODE;
+	ItemBounds(0, root.m_count, root.m_min, root.m_max);
+	m_nodes.push_back(root);
+
+	//split nodes until everything is a leaf, depth first so each node's children sit next to each other
+	//nothing goes deeper than MAX_DEPTH so the queries can use a fixed size stack
+	vector<pair<uint32_t, int>> stack;
+	stack.push_back(make_pair(0u, 0));
+	while (!stack.empty())
+	{
+		uint32_t index = stack.back().first;
+		int depth = stack.back().second;
+		stack.pop_back();
+
+		if (depth < MAX_DEPTH - 2 && Split(index, centres))
+		{
+			stack.push_back(make_pair(m_nodes[index].m_left + 1, depth + 1));
+			stack.push_back(make_pair(m_nodes[index].m_left, depth + 1));
+		}
+		else
+		{
+			for (uint32_t i = m_nodes[index].m_first; i < m_nodes[index].m_first + m_nodes[index].m_count; i++)
+			{
+				m_leafOf[m_items[i]] = index;
+			}
+		}
+	}
+
+	m_refit.assign(m_nodes.size(), 0);
+	m_cost = m_buildCost = CalculateCost();
+}
+
+bool BVH::Split(uint32_t _index, vector<vec3>& _centres)
+{
+	const Node node = m_nodes[_index];
+	if (node.m_count <= LEAF_SIZE)
+	{
+		return false;
+	}
+
+	//pick the longest axis of the box around the centres
+	vec3 centreMin(FLT_MAX), centreMax(-FLT_MAX);
+	for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+	{
+		centreMin = glm::min(centreMin, _centres[i]);
+		centreMax = glm::max(centreMax, _centres[i]);
+	}
+	vec3 spread = centreMax - centreMin;
+	int axis = spread.x > spread.y ? (spread.x > spread.z ? 0 : 2) : (spread.y > spread.z ? 1 : 2);
+	if (spread[axis] <= 0.0f)
+	{
+		//everything is in the same place, no split will help
+		return false;
+	}
+
+	//drop every item into a bin along that axis
+	struct Bin
+	{
+		vec3 m_min = vec3(FLT_MAX);
+		vec3 m_max = vec3(-FLT_MAX);
+		uint32_t m_count = 0;
+	};
+	Bin bins[SAH_BINS];
+	const float binScale = SAH_BINS / spread[axis] * 0.9999f;
+	for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+	{
+		int b = (int)((_centres[i][axis] - centreMin[axis]) * binScale);
+		bins[b].m_count++;
+		bins[b].m_min = glm::min(bins[b].m_min, m_bounds->GetMin(m_items[i]));
+		bins[b].m_max = glm::max(bins[b].m_max, m_bounds->GetMax(m_items[i]));
+	}
+
+	//sweep from both ends to get the cost of splitting after each bin
+	float leftArea[SAH_BINS - 1];
+	uint32_t leftCount[SAH_BINS - 1];
+	vec3 boxMin(FLT_MAX), boxMax(-FLT_MAX);
+	uint32_t sum = 0;
+	for (int b = 0; b < SAH_BINS - 1; b++)
+	{
+		sum += bins[b].m_count;
+		boxMin = glm::min(boxMin, bins[b].m_min);
+		boxMax = glm::max(boxMax, bins[b].m_max);
+		leftCount[b] = sum;
+		leftArea[b] = sum ? HalfArea(boxMin, boxMax) : 0.0f;
+	}
+
+	float bestCost = FLT_MAX;
+	int bestSplit = -1;
+	boxMin = vec3(FLT_MAX);
+	boxMax = vec3(-FLT_MAX);
+	sum = 0;
+	for (int b = SAH_BINS - 1; b > 0; b--)
+	{
+		sum += bins[b].m_count;
+		boxMin = glm::min(boxMin, bins[b].m_min);
+		boxMax = glm::max(boxMax, bins[b].m_max);
+		if (sum == 0 || leftCount[b - 1] == 0)
+		{
+			continue;
+		}
+
+		float cost = leftArea[b - 1] * leftCount[b - 1] + HalfArea(boxMin, boxMax) * sum;
+		if (cost < bestCost)
+		{
+			bestCost = cost;
+			bestSplit = b;
+		}
+	}
+
+	if (bestSplit < 0)
+	{
+		return false;
+	}
+
+	//partition the items (and their centres) so the left child's come first
+	uint32_t mid = node.m_first;
+	for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+	{
+		int b = (int)((_centres[i][axis] - centreMin[axis]) * binScale);
+		if (b < bestSplit)
+		{
+			std::swap(m_items[i], m_items[mid]);
+			std::swap(_centres[i], _centres[mid]);
+			mid++;
+		}
+	}
+
+	uint32_t left = (uint32_t)m_nodes.size();
+	m_nodes[_index].m_left = left;
+
+	Node child;
+	child.m_left = 0;
+	child.m_parent = _index;
+
+	child.m_first = node.m_first;
+	child.m_count = mid - node.m_first;
+	ItemBounds(child.m_first, child.m_count, child.m_min, child.m_max);
+	m_nodes.push_back(child);
+
+	child.m_first = mid;
+	child.m_count = node.m_first + node.m_count - mid;
+	ItemBounds(child.m_first, child.m_count, child.m_min, child.m_max);
+	m_nodes.push_back(child);
+
+	return true;
+}
+
+void BVH::Refit(const uint8_t* _moved)
+{
+	if (m_nodes.empty())
+	{
+		return;
+	}
+
+	//flag the leaves holding anything that moved, and everything above them
+	bool any = false;
+	for (size_t i = 0; i < m_leafOf.size(); i++)
+	{
+		if ((!_moved || _moved[i]) && m_leafOf[i] != NO_NODE)
+		{
+			for (uint32_t node = m_leafOf[i]; node != NO_NODE && !m_refit[node]; node = m_nodes[node].m_parent)
+			{
+				m_refit[node] = 1;
+			}
+			any = true;
+		}
+	}
+
+	if (!any)
+	{
+		return;
+	}
+
+	//children always come after their parents, so going backwards does them first
+	for (size_t n = m_nodes.size(); n-- > 0;)
+	{
+		if (!m_refit[n])
+		{
+			continue;
+		}
+
+		Node& node = m_nodes[n];
+		if (node.IsLeaf())
+		{
+			ItemBounds(node.m_first, node.m_count, node.m_min, node.m_max);
+		}
+		else
+		{
+			node.m_min = glm::min(m_nodes[node.m_left].m_min, m_nodes[node.m_left + 1].m_min);
+			node.m_max = glm::max(m_nodes[node.m_left].m_max, m_nodes[node.m_left + 1].m_max);
+		}
+		m_refit[n] = 0;
+	}
+
+	m_cost = CalculateCost();
+}
+
+bool BVH::NeedsRebuild() const
+{
+	return m_cost > m_buildCost * REBUILD_RATIO;
+}
+
+float BVH::CalculateCost() const
+{
+	if (m_nodes.empty())
+	{
+		return 0.0f;
+	}
+
+	float rootArea = HalfArea(m_nodes[0].m_min, m_nodes[0].m_max);
+	if (rootArea <= 0.0f)
+	{
+		return 0.0f;
+	}
+
+	//inner nodes cost a box test, leaves cost one test per item
+	float cost = 0.0f;
+	for (size_t n = 0; n < m_nodes.size(); n++)
+	{
+		const Node& node = m_nodes[n];
+		cost += HalfArea(node.m_min, node.m_max) * (node.IsLeaf() ? (float)node.m_count : 1.0f);
+	}
+	return cost / rootArea;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Queries
+/////////////////////////////////////////////////////////////////////////////////////
+
+void BVH::QueryFrustum(const Frustum& _frustum, std::vector<uint32_t>& _out) const
+{
+	_out.insert(_out.end(), m_unbounded.begin(), m_unbounded.end());
+	if (m_nodes.empty() || m_items.empty())
+	{
+		return;
+	}
+
+	//each entry carries which planes still need testing
+	//once a box is completely inside a plane nothing under it can be outside that plane
+	const int allPlanes = (1 << Frustum::PLANE_COUNT) - 1;
+	struct Entry { uint32_t m_node; int m_planes; };
+	Entry stack[MAX_DEPTH];
+	int top = 0;
+	stack[top++] = { 0, allPlanes };
+
+	while (top > 0)
+	{
+		Entry entry = stack[--top];
+		const Node& node = m_nodes[entry.m_node];
+		m_nodesVisited++;
+
+		vec3 centre = 0.5f * (node.m_min + node.m_max);
+		vec3 extent = 0.5f * (node.m_max - node.m_min);
+
+		bool outside = false;
+		int planes = entry.m_planes;
+		for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+		{
+			if (!(planes & (1 << p)))
+			{
+				continue;
+			}
+
+			const vec4& plane = _frustum.GetPlane(p);
+			float dist = glm::dot(vec3(plane), centre) + plane.w;
+			float reach = glm::dot(glm::abs(vec3(plane)), extent);
+			if (dist < -reach)
+			{
+				outside = true;
+				break;
+			}
+			if (dist >= reach)
+			{
+				planes &= ~(1 << p);
+			}
+		}
+
+		if (outside)
+		{
+			continue;
+		}
+
+		if (planes == 0)
+		{
+			//all the way inside, take the whole lot without looking any further
+			_out.insert(_out.end(), m_items.begin() + node.m_first, m_items.begin() + node.m_first + node.m_count);
+		}
+		else if (node.IsLeaf())
+		{
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+			{
+				uint32_t id = m_items[i];
+				if (_frustum.TestSphere(vec3(m_bounds->m_sphereX[id], m_bounds->m_sphereY[id], m_bounds->m_sphereZ[id]), m_bounds->m_radius[id])
+					&& _frustum.TestBox(vec3(m_bounds->m_boxX[id], m_bounds->m_boxY[id], m_bounds->m_boxZ[id]), vec3(m_bounds->m_extentX[id], m_bounds->m_extentY[id], m_bounds->m_extentZ[id])))
+				{
+					_out.push_back(id);
+				}
+			}
+		}
+		else
+		{
+			stack[top++] = { node.m_left + 1, planes };
+			stack[top++] = { node.m_left, planes };
+		}
+	}
+}
+
+void BVH::QuerySphere(const vec3& _centre, float _radius, std::vector<uint32_t>& _out) const
+{
+	if (m_nodes.empty() || m_items.empty())
+	{
+		return;
+	}
+
+	const float radius2 = _radius * _radius;
+
+	uint32_t stack[MAX_DEPTH];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = m_nodes[stack[--top]];
+		m_nodesVisited++;
+
+		//closest point in the box to the centre
+		vec3 closest = glm::clamp(_centre, node.m_min, node.m_max);
+		if (glm::dot(closest - _centre, closest - _centre) > radius2)
+		{
+			continue;
+		}
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+			{
+				vec3 itemClosest = glm::clamp(_centre, m_bounds->GetMin(m_items[i]), m_bounds->GetMax(m_items[i]));
+				if (glm::dot(itemClosest - _centre, itemClosest - _centre) <= radius2)
+				{
+					_out.push_back(m_items[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[top++] = node.m_left + 1;
+			stack[top++] = node.m_left;
+		}
+	}
+}
+
+//where a ray enters a box (slab test), FLT_MAX if it misses or only hits beyond _maxT
+static inline float RayBox(const vec3& _origin, const vec3& _invDir, float _maxT, const vec3& _min, const vec3& _max)
+{
+	vec3 t0 = (_min - _origin) * _invDir;
+	vec3 t1 = (_max - _origin) * _invDir;
+	vec3 tNear = glm::min(t0, t1);
+	vec3 tFar = glm::max(t0, t1);
+	float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+	float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, _maxT));
+	return enter <= exit ? enter : FLT_MAX;
+}
+
+bool BVH::RayCast(const vec3& _origin, const vec3& _dir, float _maxDist, uint32_t& _hitItem, float& _hitT) const
+{
+	if (m_nodes.empty() || m_items.empty())
+	{
+		return false;
+	}
+
+	//1 / 0 gives infinity, which the slab test copes with fine
+	const vec3 invDir = 1.0f / _dir;
+	float best = _maxDist;
+	bool hit = false;
+
+	if (RayBox(_origin, invDir, best, m_nodes[0].m_min, m_nodes[0].m_max) == FLT_MAX)
+	{
+		return false;
+	}
+
+	uint32_t stack[MAX_DEPTH];
+	int top = 0;
+	stack[top++] = 0;
+
+	while (top > 0)
+	{
+		const Node& node = m_nodes[stack[--top]];
+		m_nodesVisited++;
+
+		if (node.IsLeaf())
+		{
+			for (uint32_t i = node.m_first; i < node.m_first + node.m_count; i++)
+			{
+				float t = RayBox(_origin, invDir, best, m_bounds->GetMin(m_items[i]), m_bounds->GetMax(m_items[i]));
+				if (t != FLT_MAX && (t < best || !hit))
+				{
+					best = t;
+					_hitItem = m_items[i];
+					hit = true;
+				}
+			}
+			continue;
+		}
+
+		//visit the nearer child first so the further one can often be skipped
+		//(not called near and far, windows.h still #defines those)
+		uint32_t closer = node.m_left;
+		uint32_t further = node.m_left + 1;
+		float tCloser = RayBox(_origin, invDir, best, m_nodes[closer].m_min, m_nodes[closer].m_max);
+		float tFurther = RayBox(_origin, invDir, best, m_nodes[further].m_min, m_nodes[further].m_max);
+		if (tFurther < tCloser)
+		{
+			std::swap(closer, further);
+			std::swap(tCloser, tFurther);
+		}
+		if (tFurther != FLT_MAX)
+		{
+			stack[top++] = further;
+		}
+		if (tCloser != FLT_MAX)
+		{
+			stack[top++] = closer;
+		}
+	}
+
+	_hitT = best;
+	return hit;
+}
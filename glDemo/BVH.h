@@ -0,0 +1,102 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include <vector>
+#include "Bounds.h"
+#include "Frustum.h"
+
+using namespace std;
+using namespace glm;
+
+//bounding volume hierarchy over the world space boxes in a WorldBounds (i.e. every transform in the TransformStore)
+//built top down with a binned surface area heuristic, then refitted bottom up as things move
+//the tree shape is kept until refitting has made it too much worse than when it was built, then it is rebuilt
+//this lets culling and spatial queries skip whole groups of objects at a time rather than testing every one
+class BVH
+{
+public:
+	BVH();
+	~BVH();
+
+	//build a fresh tree over everything in _bounds that has bounds (unbounded things are kept to one side)
+	//_bounds must stay alive, queries read the item boxes straight out of it
+	void Build(const WorldBounds* _bounds);
+
+	//bring the node boxes back up to date after items have moved, keeping the same tree
+	//_moved[i] non-zero means item i has new bounds, nullptr means assume everything moved
+	void Refit(const uint8_t* _moved);
+
+	//has refitting made the tree bad enough that it is worth building it again?
+	bool NeedsRebuild() const;
+
+	//every item that might be in the frustum, plus everything unbounded
+	void QueryFrustum(const Frustum& _frustum, std::vector<uint32_t>& _out) const;
+
+	//every item whose box touches the sphere
+	void QuerySphere(const vec3& _centre, float _radius, std::vector<uint32_t>& _out) const;
+
+	//nearest item whose box the ray hits within _maxDist, _dir doesn't have to be normalised (_hitT is in multiples of it)
+	//returns false if nothing was hit
+	bool RayCast(const vec3& _origin, const vec3& _dir, float _maxDist, uint32_t& _hitItem, float& _hitT) const;
+
+	size_t NumNodes() const { return m_nodes.size(); }
+	size_t NumItems() const { return m_items.size() + m_unbounded.size(); }
+
+	//surface area heuristic cost now and straight after the last Build, lower is better
+	float GetCost() const { return m_cost; }
+	float GetBuildCost() const { return m_buildCost; }
+
+	//how many nodes the queries have looked at since this was last reset, to see how much work they are doing
+	int GetNodesVisited() const { return m_nodesVisited; }
+	void ResetNodesVisited() { m_nodesVisited = 0; }
+
+protected:
+
+	//max items in a leaf, and how many buckets the SAH sorts centres into when picking a split
+	static const uint32_t LEAF_SIZE = 4;
+	static const int SAH_BINS = 12;
+
+	//deepest the tree can go, the query stacks are this big
+	static const int MAX_DEPTH = 64;
+
+	//rebuild once refitting has made the SAH cost this much worse than it was when built
+	static constexpr float REBUILD_RATIO = 1.5f;
+
+	static const uint32_t NO_NODE = 0xffffffff;
+
+	//m_items[m_first] to m_items[m_first + m_count - 1] are under this node
+	//for an inner node the children are m_left and m_left + 1, leaves have m_left == 0 (the root is never anyone's child)
+	struct Node
+	{
+		vec3 m_min;
+		vec3 m_max;
+		uint32_t m_first;
+		uint32_t m_count;
+		uint32_t m_left;
+		uint32_t m_parent;
+
+		bool IsLeaf() const { return m_left == 0; }
+	};
+
+	//split node _index in two if that is worth it, returns false if it should stay a leaf
+	bool Split(uint32_t _index, vector<vec3>& _centres);
+
+	//box around items _first to _first + _count - 1
+	void ItemBounds(uint32_t _first, uint32_t _count, vec3& _min, vec3& _max) const;
+
+	//sum of (node area * cost of visiting it) / root area
+	float CalculateCost() const;
+
+	const WorldBounds* m_bounds = nullptr;
+
+	std::vector<Node> m_nodes;				//parents always come before their children
+	std::vector<uint32_t> m_items;			//item indices, in leaf order
+	std::vector<uint32_t> m_unbounded;		//items with no bounds, never culled
+	std::vector<uint32_t> m_leafOf;			//item -> the leaf holding it (or NO_NODE)
+	std::vector<uint8_t> m_refit;			//nodes waiting for Refit to look at them
+
+	float m_cost = 0.0f;
+	float m_buildCost = 0.0f;
+
+	mutable int m_nodesVisited = 0;
+};
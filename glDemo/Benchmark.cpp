@@ -0,0 +1,902 @@
+#include "Benchmark.h"
+#include "core.h"
+#include "TransformKernels.h"
+#include "AlignedAllocator.h"
+#include "TransformStore.h"
+#include "WorkerPool.h"
+#include "Frustum.h"
+#include "BVH.h"
+#include "ExampleGO.h"
+#include "RenderQueue.h"
+#include "InstanceData.h"
+#include "ECSSystems.h"
+#include "SceneArena.h"
+#include "Light.h"
+#include "DirectionLight.h"
+#include "Camera.h"
+#include "AIMesh.h"
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "LightBuffer.h"
+#include <list>
+#include <fstream>
+#include <string.h>
+#include <chrono>
+
+using namespace std;
+using namespace glm;
+
+//seconds since some point in the past
+static double Now()
+{
+	return chrono::duration<double>(chrono::high_resolution_clock::now().time_since_epoch()).count();
+}
+
+void Benchmark::RunAll()
+{
+	cout << "==== BENCHMARKS ====" << endl << endl;
+
+	TransformCompose();
+	SceneUpdate();
+	SpatialQueries();
+	EntityUpdate();
+	SceneReload();
+	MeshLoad();
+	ObjLoad();
+	LightCulling();
+
+	cout << "==== DONE ====" << endl;
+}
+
+void Benchmark::TransformCompose()
+{
+	cout << "---- World matrix composition (ns per object, best of 5) ----" << endl;
+	cout << "best kernel on this CPU : " << TransformKernels::PathName(TransformKernels::BestPath()) << endl;
+
+	const size_t sizes[] = { 1000, 10000, 100000 };
+	mt19937 rng(1234);
+	uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+	uniform_real_distribution<float> rotDist(-360.0f, 360.0f);
+	uniform_real_distribution<float> scaleDist(0.1f, 4.0f);
+
+	for (size_t count : sizes)
+	{
+		AlignedVector<vec3> pos(count), rot(count), scale(count);
+		AlignedVector<mat4> world(count), check(count);
+
+		for (size_t i = 0; i < count; i++)
+		{
+			pos[i] = vec3(posDist(rng), posDist(rng), posDist(rng));
+			rot[i] = vec3(rotDist(rng), rotDist(rng), rotDist(rng));
+			scale[i] = vec3(scaleDist(rng), scaleDist(rng), scaleDist(rng));
+		}
+
+		//roughly the same amount of total work at every size
+		const int reps = (int)(2000000 / count) + 1;
+
+		//-1 is the original glm::translate/rotate/rotate/rotate/scale path
+		double reference = 0.0;
+		for (int path = -1; path < TransformKernels::PATH_COUNT; path++)
+		{
+			if (path > TransformKernels::BestPath())
+			{
+				continue;
+			}
+
+			double best = 1e30;
+			for (int run = 0; run < 5; run++)
+			{
+				double start = Now();
+				for (int r = 0; r < reps; r++)
+				{
+					if (path < 0)
+					{
+						TransformKernels::ComposeTRSReference(pos.data(), rot.data(), scale.data(), world.data(), count);
+					}
+					else
+					{
+						TransformKernels::ComposeTRS((TransformKernels::Path)path, pos.data(), rot.data(), scale.data(), world.data(), count);
+					}
+				}
+				best = std::min(best, Now() - start);
+			}
+
+			double nsPerObject = best * 1e9 / ((double)reps * count);
+			const char* name = path < 0 ? "PER-OBJECT GLM" : TransformKernels::PathName((TransformKernels::Path)path);
+
+			if (path < 0)
+			{
+				reference = nsPerObject;
+				check = world;
+				printf("%7zu objects  %-15s %8.2f ns\n", count, name, nsPerObject);
+			}
+			else
+			{
+				//make sure we are still building the same matrices
+				float maxError = 0.0f;
+				for (size_t i = 0; i < count; i++)
+				{
+					for (int c = 0; c < 4; c++)
+					{
+						vec4 diff = abs(world[i][c] - check[i][c]);
+						maxError = std::max(maxError, std::max(std::max(diff.x, diff.y), std::max(diff.z, diff.w)));
+					}
+				}
+				printf("%7zu objects  %-15s %8.2f ns  x%5.2f  (max error %g)\n", count, name, nsPerObject, reference / nsPerObject, maxError);
+			}
+		}
+		cout << endl;
+	}
+}
+
+//100k objects, every one spinning, every fourth one attached to the one before it
+static void MakeStressStore(TransformStore& _store, size_t _count)
+{
+	mt19937 rng(5678);
+	uniform_real_distribution<float> posDist(-100.0f, 100.0f);
+	uniform_real_distribution<float> rotDist(-360.0f, 360.0f);
+	uniform_real_distribution<float> spinDist(-2.0f, 2.0f);
+
+	_store.Clear();
+	_store.Reserve(_count);
+	for (size_t i = 0; i < _count; i++)
+	{
+		TransformID id = _store.Add();
+		_store.SetPos(id, vec3(posDist(rng), posDist(rng), posDist(rng)));
+		_store.SetRot(id, vec3(rotDist(rng), rotDist(rng), rotDist(rng)));
+		_store.SetRotIncr(id, vec3(spinDist(rng), spinDist(rng), spinDist(rng)));
+		if (i % 4 == 3)
+		{
+			_store.SetParent(id, id - 1);
+		}
+	}
+}
+
+void Benchmark::SceneUpdate()
+{
+	const size_t count = 100000;
+	const int frames = 50;
+
+	cout << "---- Scene update, " << count << " spinning objects (ms per frame, best of 5) ----" << endl;
+
+	//the single threaded result everything else has to match
+	TransformStore serial;
+	MakeStressStore(serial, count);
+	for (int f = 0; f < frames; f++)
+	{
+		serial.Update();
+	}
+
+	//1, 2, 4... and the full thread count if that isn't a power of two
+	vector<int> threadCounts;
+	for (int threads = 1; threads < WorkerPool::HardwareThreads(); threads *= 2)
+	{
+		threadCounts.push_back(threads);
+	}
+	threadCounts.push_back(WorkerPool::HardwareThreads());
+
+	double reference = 0.0;
+	for (int threads : threadCounts)
+	{
+		WorkerPool pool(threads);
+		WorkerPool* usePool = threads > 1 ? &pool : nullptr;
+
+		TransformStore store;
+		double best = 1e30;
+		for (int run = 0; run < 5; run++)
+		{
+			MakeStressStore(store, count);
+			double start = Now();
+			for (int f = 0; f < frames; f++)
+			{
+				store.Update(usePool);
+			}
+			best = std::min(best, Now() - start);
+		}
+
+		double msPerFrame = best * 1000.0 / frames;
+		if (threads == 1)
+		{
+			reference = msPerFrame;
+		}
+
+		bool same = memcmp(store.WorldMatrices(), serial.WorldMatrices(), count * sizeof(mat4)) == 0;
+		printf("%3d threads  %8.3f ms  x%5.2f  %s\n", threads, msPerFrame, reference / msPerFrame, same ? "identical" : "DIFFERENT FROM SERIAL");
+	}
+	cout << endl;
+}
+
+//time one call of _fn, best of _runs, in microseconds
+template<class F>
+static double BestMicroseconds(int _runs, F _fn)
+{
+	double best = 1e30;
+	for (int run = 0; run < _runs; run++)
+	{
+		double start = Now();
+		_fn();
+		best = std::min(best, Now() - start);
+	}
+	return best * 1e6;
+}
+
+void Benchmark::SpatialQueries()
+{
+	cout << "---- BVH against brute force (microseconds, best of 5) ----" << endl;
+
+	const size_t sizes[] = { 1000, 10000, 100000 };
+	const int numQueries = 100;
+
+	for (size_t count : sizes)
+	{
+		//same density of objects at every size, so a query covers about the same number of them
+		const float side = 100.0f * cbrtf((float)count / 1000.0f);
+		mt19937 rng(91011);
+		uniform_real_distribution<float> posDist(-side * 0.5f, side * 0.5f);
+		uniform_real_distribution<float> rotDist(0.0f, 6.283f);
+		uniform_real_distribution<float> scaleDist(0.5f, 2.0f);
+		uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+		Bounds local;
+		local.Add(vec3(-1.0f));
+		local.Add(vec3(1.0f));
+		local.FinishSphere();
+
+		WorldBounds bounds;
+		bounds.Resize(count);
+		for (size_t i = 0; i < count; i++)
+		{
+			mat4 world = glm::translate(mat4(1.0f), vec3(posDist(rng), posDist(rng), posDist(rng)));
+			world = glm::rotate(world, rotDist(rng), glm::normalize(vec3(unit(rng), unit(rng), 1.0f)));
+			bounds.Set(i, local, glm::scale(world, vec3(scaleDist(rng))));
+		}
+
+		BVH bvh;
+		double buildTime = BestMicroseconds(5, [&] { bvh.Build(&bounds); });
+
+		//a camera at one corner of the scene looking in, it only reaches 100 units whatever the size
+		Frustum frustum;
+		frustum.Extract(glm::perspective(glm::radians(45.0f), 1.0f, 0.5f, 100.0f) * glm::lookAt(vec3(-side * 0.5f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f)));
+
+		vector<uint8_t> visible(count);
+		vector<uint32_t> results;
+		int bruteVisible = 0;
+		double bruteFrustum = BestMicroseconds(5, [&] { bruteVisible = frustum.Cull(bounds, 0, count, visible.data()); });
+		double bvhFrustum = BestMicroseconds(5, [&] { results.clear(); bvh.QueryFrustum(frustum, results); });
+		printf("%7zu objects  frustum  brute %9.1f  bvh %9.1f  x%6.1f  (%d / %zu visible)\n", count, bruteFrustum, bvhFrustum, bruteFrustum / bvhFrustum, bruteVisible, results.size());
+
+		//spheres and rays from random places
+		vector<vec3> centres(numQueries), dirs(numQueries);
+		for (int q = 0; q < numQueries; q++)
+		{
+			centres[q] = vec3(posDist(rng), posDist(rng), posDist(rng));
+			dirs[q] = glm::normalize(vec3(unit(rng), unit(rng), unit(rng)));
+		}
+
+		size_t bruteHits = 0, bvhHits = 0;
+		double bruteSphere = BestMicroseconds(5, [&]
+		{
+			bruteHits = 0;
+			for (int q = 0; q < numQueries; q++)
+			{
+				for (size_t i = 0; i < count; i++)
+				{
+					vec3 closest = glm::clamp(centres[q], bounds.GetMin(i), bounds.GetMax(i));
+					bruteHits += glm::dot(closest - centres[q], closest - centres[q]) <= 25.0f ? 1 : 0;
+				}
+			}
+		});
+		double bvhSphere = BestMicroseconds(5, [&]
+		{
+			bvhHits = 0;
+			for (int q = 0; q < numQueries; q++)
+			{
+				results.clear();
+				bvh.QuerySphere(centres[q], 5.0f, results);
+				bvhHits += results.size();
+			}
+		});
+		printf("%7zu objects  sphere   brute %9.1f  bvh %9.1f  x%6.1f  (%zu / %zu found, %d queries)\n", count, bruteSphere, bvhSphere, bruteSphere / bvhSphere, bruteHits, bvhHits, numQueries);
+
+		//nearest hit for every ray both ways, they should pick the same object
+		vector<int> bruteHit(numQueries), bvhHit(numQueries);
+		double bruteRay = BestMicroseconds(5, [&]
+		{
+			for (int q = 0; q < numQueries; q++)
+			{
+				float best = 1000.0f;
+				bruteHit[q] = -1;
+				for (size_t i = 0; i < count; i++)
+				{
+					vec3 t0 = (bounds.GetMin(i) - centres[q]) / dirs[q];
+					vec3 t1 = (bounds.GetMax(i) - centres[q]) / dirs[q];
+					vec3 tNear = glm::min(t0, t1);
+					vec3 tFar = glm::max(t0, t1);
+					float enter = glm::max(glm::max(tNear.x, tNear.y), glm::max(tNear.z, 0.0f));
+					float exit = glm::min(glm::min(tFar.x, tFar.y), glm::min(tFar.z, best));
+					if (enter <= exit && (enter < best || bruteHit[q] < 0))
+					{
+						best = enter;
+						bruteHit[q] = (int)i;
+					}
+				}
+			}
+		});
+		double bvhRay = BestMicroseconds(5, [&]
+		{
+			for (int q = 0; q < numQueries; q++)
+			{
+				uint32_t hit;
+				float t;
+				bvhHit[q] = bvh.RayCast(centres[q], dirs[q], 1000.0f, hit, t) ? (int)hit : -1;
+			}
+		});
+		int rayAgree = 0;
+		for (int q = 0; q < numQueries; q++)
+		{
+			rayAgree += bruteHit[q] == bvhHit[q] ? 1 : 0;
+		}
+		printf("%7zu objects  ray      brute %9.1f  bvh %9.1f  x%6.1f  (%d / %d rays agree)\n", count, bruteRay, bvhRay, bruteRay / bvhRay, rayAgree, numQueries);
+
+		//move a tenth of the objects a little and refit, against building again
+		vector<uint8_t> moved(count, 0);
+		for (size_t i = 0; i < count; i += 10)
+		{
+			moved[i] = 1;
+			mat4 world = glm::translate(mat4(1.0f), vec3(bounds.m_boxX[i], bounds.m_boxY[i], bounds.m_boxZ[i]) + vec3(unit(rng), unit(rng), unit(rng)));
+			bounds.Set(i, local, world);
+		}
+		double refitTime = BestMicroseconds(5, [&] { bvh.Refit(moved.data()); });
+		printf("%7zu objects  build %9.1f  refit 10%% %9.1f  (%zu nodes, SAH cost %.1f -> %.1f)\n", count, buildTime, refitTime, bvh.NumNodes(), bvh.GetBuildCost(), bvh.GetCost());
+		cout << endl;
+	}
+}
+
+void Benchmark::EntityUpdate()
+{
+	const size_t count = 100000;
+	const int frames = 20;
+
+	cout << "---- GameObjects against ECS, " << count << " spinning objects (ms per frame, best of 5) ----" << endl;
+
+	const mat4 view = glm::lookAt(vec3(0.0f, 0.0f, 150.0f), vec3(0.0f), vec3(0.0f, 1.0f, 0.0f));
+	const float farPlane = 500.0f;
+
+	//the same objects both ways, every fourth one attached to the one before it as in MakeStressStore
+	TransformStore store;
+	MakeStressStore(store, count);
+
+	list<GameObject*> GOs;
+	for (size_t i = 0; i < count; i++)
+	{
+		GameObject* GO = new ExampleGO();
+		GO->SetTransform(&store, (TransformID)i);
+		GOs.push_back(GO);
+	}
+
+	World world;
+	vector<Entity> entities(count);
+	for (size_t i = 0; i < count; i++)
+	{
+		TransformID id = (TransformID)i;
+		ComponentMask mask = ECSSystems::TRANSFORM_MASK | COMPONENT_BIT(COMP_SPIN) | COMPONENT_BIT(COMP_RENDERABLE);
+		if (store.GetParent(id) != INVALID_TRANSFORM)
+		{
+			mask |= COMPONENT_BIT(COMP_PARENT);
+		}
+
+		Entity entity = world.Create(mask);
+		world.Get<PositionComponent>(entity)->m_pos = store.GetPos(id);
+		world.Get<RotationComponent>(entity)->m_rot = store.GetRot(id);
+		world.Get<ScaleComponent>(entity)->m_scale = store.GetScale(id);
+		world.Get<SpinComponent>(entity)->m_rotInc = store.GetRotIncr(id);
+		world.Get<RenderableComponent>(entity)->m_RP = RP_OPAQUE;
+		if (mask & COMPONENT_BIT(COMP_PARENT))
+		{
+			ECSSystems::SetParent(world, entity, entities[store.GetParent(id)]);
+		}
+		entities[i] = entity;
+	}
+
+	vector<uint64_t> keys;
+	vector<InstanceData> instances;
+	keys.reserve(count);
+	instances.reserve(count);
+
+	//what the Scene does for each of them every frame: Tick, the TransformStore update, then key and copy out the matrices
+	double hierarchyUpdate = 1e30, hierarchyPrep = 1e30;
+	for (int run = 0; run < 5; run++)
+	{
+		double update = 0.0, prep = 0.0;
+		for (int f = 0; f < frames; f++)
+		{
+			double start = Now();
+			for (list<GameObject*>::iterator it = GOs.begin(); it != GOs.end(); it++)
+			{
+				(*it)->Tick(1.0f / 60.0f);
+			}
+			store.Update();
+			double mid = Now();
+
+			keys.clear();
+			instances.clear();
+			for (list<GameObject*>::iterator it = GOs.begin(); it != GOs.end(); it++)
+			{
+				if ((*it)->GetRP() & RP_OPAQUE)
+				{
+					TransformID id = (*it)->GetTransformID();
+					const mat4& m = store.GetWorld(id);
+					float depth = -(view[0][2] * m[3][0] + view[1][2] * m[3][1] + view[2][2] * m[3][2] + view[3][2]);
+					keys.push_back(RenderQueue::MakeKey(0, (*it)->GetShaderHandle().m_index, (*it)->GetTextureHandle().m_index, (*it)->GetModelHandle().m_index, depth / farPlane));
+
+					InstanceData data;
+					data.m_model = m;
+					data.m_normal = store.GetNormalMatrix(id);
+					instances.push_back(data);
+				}
+			}
+			prep += Now() - mid;
+			update += mid - start;
+		}
+		hierarchyUpdate = std::min(hierarchyUpdate, update);
+		hierarchyPrep = std::min(hierarchyPrep, prep);
+	}
+
+	//and the same through the systems
+	double ecsUpdate = 1e30, ecsPrep = 1e30;
+	for (int run = 0; run < 5; run++)
+	{
+		double update = 0.0, prep = 0.0;
+		for (int f = 0; f < frames; f++)
+		{
+			double start = Now();
+			ECSSystems::Spin(world);
+			ECSSystems::Transforms(world);
+			double mid = Now();
+			ECSSystems::RenderPrep(world, view, farPlane, keys, instances);
+			prep += Now() - mid;
+			update += mid - start;
+		}
+		ecsUpdate = std::min(ecsUpdate, update);
+		ecsPrep = std::min(ecsPrep, prep);
+	}
+
+	//both have spun the same number of times, so should have the same matrices
+	float maxError = 0.0f;
+	for (size_t i = 0; i < count; i++)
+	{
+		const mat4& a = store.GetWorld((TransformID)i);
+		const mat4& b = world.Get<WorldComponent>(entities[i])->m_world;
+		for (int c = 0; c < 4; c++)
+		{
+			vec4 diff = abs(a[c] - b[c]);
+			maxError = std::max(maxError, std::max(std::max(diff.x, diff.y), std::max(diff.z, diff.w)));
+		}
+	}
+
+	const double toMs = 1000.0 / frames;
+	printf("GAMEOBJECTS  update %8.3f ms  render prep %8.3f ms\n", hierarchyUpdate * toMs, hierarchyPrep * toMs);
+	printf("ECS          update %8.3f ms  render prep %8.3f ms  x%5.2f / x%5.2f  (%zu archetypes, max error %g)\n", ecsUpdate * toMs, ecsPrep * toMs,
+		hierarchyUpdate / ecsUpdate, hierarchyPrep / ecsPrep, world.NumArchetypes(), maxError);
+
+	//and the demo's own manifest loaded into a World, with every system run once a frame as the Scene's update and snapshot would
+	ifstream manifest("manifest.txt");
+	if (manifest.is_open())
+	{
+		World scene;
+		double loadStart = Now();
+		ECSSystems::LoadManifest(scene, manifest);
+		double loadTime = Now() - loadStart;
+
+		vector<LightData> lights;
+		double manifestFrame = 1e30;
+		for (int run = 0; run < 5; run++)
+		{
+			double start = Now();
+			for (int f = 0; f < frames; f++)
+			{
+				ECSSystems::Spin(scene);
+				ECSSystems::Transforms(scene);
+				ECSSystems::RenderPrep(scene, view, farPlane, keys, instances);
+				ECSSystems::GatherLights(scene, lights);
+			}
+			manifestFrame = std::min(manifestFrame, Now() - start);
+		}
+
+		//every entity loaded is either a light or a GameObject with a transform
+		size_t numTransforms = 0;
+		scene.ForEachChunk(ECSSystems::TRANSFORM_MASK, 0, [&numTransforms](Chunk& _chunk) { numTransforms += _chunk.Size(); });
+		printf("MANIFEST     load %8.3f ms  frame %8.3f ms  (%zu entities: %zu lights gathered, %zu with a transform, %zu drawn opaque, %s)\n", loadTime * 1000.0, manifestFrame * toMs,
+			scene.NumEntities(), lights.size(), numTransforms, instances.size(), lights.size() + numTransforms == scene.NumEntities() ? "all accounted for" : "ENTITIES MISSING");
+	}
+	else
+	{
+		printf("MANIFEST     couldn't open manifest.txt\n");
+	}
+	cout << endl;
+
+	for (list<GameObject*>::iterator it = GOs.begin(); it != GOs.end(); it++)
+	{
+		delete *it;
+	}
+}
+
+void Benchmark::SceneReload()
+{
+	const size_t numGOs = 100000;
+	const size_t numLights = 10000;
+	const size_t numCameras = 1000;
+	const int loads = 10;
+
+	cout << "---- Scene reload, " << numGOs << " GameObjects " << numLights << " lights " << numCameras << " cameras (ms per load + unload, best of " << loads << ") ----" << endl;
+
+	//everything a load makes, the factories' output is kept to free again at the end
+	vector<GameObject*> GOs(numGOs);
+	vector<Light*> lights(numLights);
+	vector<Camera*> cameras(numCameras);
+
+	//as the factories used to, new each one and delete each one
+	double heap = 1e30;
+	for (int load = 0; load < loads; load++)
+	{
+		double start = Now();
+		for (size_t i = 0; i < numGOs; i++)
+		{
+			GOs[i] = new ExampleGO();
+		}
+		for (size_t i = 0; i < numLights; i++)
+		{
+			lights[i] = i % 2 ? new DirectionLight() : new Light();
+		}
+		for (size_t i = 0; i < numCameras; i++)
+		{
+			cameras[i] = new Camera();
+		}
+		for (size_t i = 0; i < numGOs; i++)
+		{
+			delete GOs[i];
+		}
+		for (size_t i = 0; i < numLights; i++)
+		{
+			delete lights[i];
+		}
+		for (size_t i = 0; i < numCameras; i++)
+		{
+			delete cameras[i];
+		}
+		heap = std::min(heap, Now() - start);
+	}
+
+	//into an arena as the factories now do (without them printing every object), freed with one Clear
+	SceneArena arena;
+	double pooled = 1e30;
+	size_t firstBytes = 0;
+	bool steady = true;
+	for (int load = 0; load < loads; load++)
+	{
+		double start = Now();
+		for (size_t i = 0; i < numGOs; i++)
+		{
+			GOs[i] = arena.New<ExampleGO>();
+		}
+		for (size_t i = 0; i < numLights; i++)
+		{
+			lights[i] = i % 2 ? (Light*)arena.New<DirectionLight>() : arena.New<Light>();
+		}
+		for (size_t i = 0; i < numCameras; i++)
+		{
+			cameras[i] = arena.New<Camera>();
+		}
+		if (load == loads - 1)
+		{
+			arena.PrintStats();
+		}
+		arena.Clear();
+		pooled = std::min(pooled, Now() - start);
+
+		//after the first load nothing more should be allocated
+		if (load == 0)
+		{
+			firstBytes = arena.GetBytes();
+		}
+		steady = steady && arena.GetBytes() == firstBytes;
+	}
+
+	printf("NEW / DELETE  %8.3f ms\n", heap * 1000.0);
+	printf("SCENE ARENA   %8.3f ms  x%5.2f  (%zu KB held, %s)\n", pooled * 1000.0, heap / pooled, arena.GetBytes() / 1024, steady ? "same every load" : "GREW BETWEEN LOADS");
+
+	//and the manifest's models, whose geometry goes into the MeshArena and has to come out again when they go
+	//half are swapped out and back in between full loads, so later ones go into gaps rather than onto the end
+	const char* files[] = { "Assets\\beast\\beast.obj", "Assets\\gsphere.obj", "Assets\\Wall\\Cube1.obj", "Assets\\Ghost\\Ghost.obj", "Assets\\Crystal\\Crystal.obj" };
+	const size_t numFiles = sizeof(files) / sizeof(files[0]);
+	bool wasEnabled = MeshCache::IsEnabled();
+	MeshCache::SetEnabled(true);
+
+	size_t before = MeshArena::NumVertices();
+	size_t loadedVertices = 0;
+	bool meshesSteady = true;
+	double meshTime = 1e30;
+	vector<AIMesh*> meshes(numFiles);
+	for (int load = 0; load < loads; load++)
+	{
+		double start = Now();
+		for (size_t i = 0; i < numFiles; i++)
+		{
+			meshes[i] = new AIMesh(files[i]);
+		}
+		for (size_t i = 0; i < numFiles; i += 2)
+		{
+			delete meshes[i];
+			meshes[i] = new AIMesh(files[i]);
+		}
+		size_t loaded = MeshArena::NumVertices();
+		for (size_t i = 0; i < numFiles; i++)
+		{
+			delete meshes[i];
+		}
+		meshTime = std::min(meshTime, Now() - start);
+
+		if (load == 0)
+		{
+			loadedVertices = loaded;
+		}
+		meshesSteady = meshesSteady && loaded == loadedVertices && MeshArena::NumVertices() == before;
+	}
+	MeshCache::ResetStats();
+	MeshCache::SetEnabled(wasEnabled);
+
+	printf("MODELS        %8.3f ms  (%zu vertices in the MeshArena loaded, %zu after unloading, %s)\n", meshTime * 1000.0, loadedVertices - before, MeshArena::NumVertices() - before,
+		meshesSteady ? "same every load" : "GREW BETWEEN LOADS");
+	cout << endl;
+}
+
+void Benchmark::MeshLoad()
+{
+	//the models the manifest loads
+	const char* files[] = { "Assets\\beast\\beast.obj", "Assets\\gsphere.obj", "Assets\\Wall\\Cube1.obj", "Assets\\Ghost\\Ghost.obj", "Assets\\Crystal\\Crystal.obj" };
+	const int runs = 3;
+
+	cout << "---- Mesh load, cold (Assimp + write cache) against warm (from cache) (ms, best of " << runs << ") ----" << endl;
+
+	bool wasEnabled = MeshCache::IsEnabled();
+	MeshCache::SetEnabled(true);
+
+	double totalCold = 0.0;
+	double totalWarm = 0.0;
+	for (const char* file : files)
+	{
+		string cachePath = MeshCache::CachePath(file, 0);
+
+		double cold = 1e30;
+		double warm = 1e30;
+		MeshRange coldRange, warmRange;
+		Bounds coldBounds, warmBounds;
+		bool same = true;
+		for (int run = 0; run < runs; run++)
+		{
+			MeshArena::Release();
+
+			DeleteFileA(cachePath.c_str());
+			double start = Now();
+			AIMesh coldMesh(file);
+			cold = std::min(cold, Now() - start);
+
+			start = Now();
+			AIMesh warmMesh(file);
+			warm = std::min(warm, Now() - start);
+
+			//both copies are in the arena now (still waiting to be uploaded, there's no GL here), they should match exactly
+			coldRange = coldMesh.getRange();
+			warmRange = warmMesh.getRange();
+			coldBounds = coldMesh.getBounds();
+			warmBounds = warmMesh.getBounds();
+			const ArenaVertex* coldVertices = nullptr;
+			const ArenaVertex* warmVertices = nullptr;
+			const GLuint* coldIndices = nullptr;
+			const GLuint* warmIndices = nullptr;
+			size_t numVertices = warmRange.m_baseVertex - coldRange.m_baseVertex;
+			same = same && coldRange.m_indexCount > 0 && coldRange.m_indexCount == warmRange.m_indexCount &&
+				MeshArena::NumVertices() == 2 * numVertices &&
+				MeshArena::GetPending(coldRange, coldVertices, coldIndices) && MeshArena::GetPending(warmRange, warmVertices, warmIndices) &&
+				memcmp(coldVertices, warmVertices, numVertices * sizeof(ArenaVertex)) == 0 &&
+				memcmp(coldIndices, warmIndices, coldRange.m_indexCount * sizeof(GLuint)) == 0 &&
+				coldBounds.m_min == warmBounds.m_min && coldBounds.m_max == warmBounds.m_max && coldBounds.m_radius == warmBounds.m_radius;
+		}
+		MeshArena::Release();
+
+		totalCold += cold;
+		totalWarm += warm;
+		printf("%-28s %7u verts  cold %8.3f ms  warm %7.3f ms  x%6.1f  %s\n", file, (unsigned)(warmRange.m_baseVertex - coldRange.m_baseVertex), cold * 1000.0, warm * 1000.0, cold / warm, same ? "same" : "MISMATCH");
+	}
+	printf("%-28s %13s  cold %8.3f ms  warm %7.3f ms  x%6.1f\n", "ALL", "", totalCold * 1000.0, totalWarm * 1000.0, totalCold / totalWarm);
+
+	MeshCache::ResetStats();
+	MeshCache::SetEnabled(wasEnabled);
+	cout << endl;
+}
+
+void Benchmark::ObjLoad()
+{
+	const char* files[] = { "Assets\\sphere.obj", "Assets\\gsphere.obj", "Assets\\Wall\\cube1.obj", "Assets\\beast\\beast.obj", "Assets\\duck\\rubber_duck_toy_4k.obj", "Assets\\Crystal\\Crystal.obj", "Assets\\Ghost\\Ghost.obj" };
+	const int runs = 3;
+
+	WorkerPool single(1);
+	WorkerPool* all = ObjLoader::GetPool();
+
+	cout << "---- OBJ import, Assimp against the ObjLoader on 1 and " << all->NumThreads() << " threads (MB/s, best of " << runs << ") ----" << endl;
+
+	double totalBytes = 0.0;
+	double totalAssimp = 0.0;
+	double totalSingle = 0.0;
+	double totalAll = 0.0;
+	for (const char* file : files)
+	{
+		WIN32_FILE_ATTRIBUTE_DATA attributes;
+		if (!GetFileAttributesExA(file, GetFileExInfoStandard, &attributes))
+		{
+			printf("%-36s missing\n", file);
+			continue;
+		}
+		double megabytes = (double)attributes.nFileSizeLow / (1024.0 * 1024.0);
+
+		MeshData assimp, obj;
+		double assimpTime = 1e30;
+		double singleTime = 1e30;
+		double allTime = 1e30;
+		bool loaded = true;
+		for (int run = 0; run < runs; run++)
+		{
+			double start = Now();
+			loaded = AIMesh::Import(file, 0, assimp) && loaded;
+			assimpTime = std::min(assimpTime, Now() - start);
+
+			start = Now();
+			loaded = ObjLoader::Load(file, 0, obj, &single) && loaded;
+			singleTime = std::min(singleTime, Now() - start);
+
+			start = Now();
+			loaded = ObjLoader::Load(file, 0, obj, all) && loaded;
+			allTime = std::min(allTime, Now() - start);
+		}
+
+		//same vertices in the same order, to within float parsing and the normal / tangent generation
+		float positionError = 0.0f;
+		float normalError = 0.0f;
+		bool same = loaded && assimp.m_vertices.size() == obj.m_vertices.size() && assimp.m_indices == obj.m_indices;
+		if (same)
+		{
+			for (size_t i = 0; i < obj.m_vertices.size(); i++)
+			{
+				positionError = std::max(positionError, length(obj.m_vertices[i].m_pos - assimp.m_vertices[i].m_pos));
+				normalError = std::max(normalError, length(obj.m_vertices[i].m_normal - assimp.m_vertices[i].m_normal));
+			}
+		}
+
+		totalBytes += megabytes;
+		totalAssimp += assimpTime;
+		totalSingle += singleTime;
+		totalAll += allTime;
+		printf("%-36s %6.2f MB  ASSIMP %7.1f  OBJ x1 %7.1f  OBJ x%d %7.1f MB/s  x%5.1f  ", file, megabytes, megabytes / assimpTime, megabytes / singleTime, all->NumThreads(), megabytes / allTime, assimpTime / allTime);
+		if (same)
+		{
+			printf("same mesh (position error %g normal error %g)\n", positionError, normalError);
+		}
+		else
+		{
+			printf("DIFFERENT (%zu / %zu vertices, %zu / %zu indices)\n", assimp.m_vertices.size(), obj.m_vertices.size(), assimp.m_indices.size(), obj.m_indices.size());
+		}
+	}
+	printf("%-36s %6.2f MB  ASSIMP %7.1f  OBJ x1 %7.1f  OBJ x%d %7.1f MB/s  x%5.1f\n", "ALL", totalBytes, totalBytes / totalAssimp, totalBytes / totalSingle, all->NumThreads(), totalBytes / totalAll, totalAssimp / totalAll);
+	cout << endl;
+}
+
+//diffuse plus ambient at _pos from the lights listed in _indices, or all of them if that's null, as texture-directional.frag adds them up
+static vec3 ShadePoint(const vector<LightData>& _lights, const GLuint* _indices, GLuint _count, const vec3& _pos, const vec3& _normal)
+{
+	vec3 total(0.0f);
+	for (GLuint j = 0; j < _count; j++)
+	{
+		const LightData& light = _lights[_indices ? _indices[j] : j];
+		if (light.m_posType.w != (float)LIGHT_POINT)
+		{
+			total += vec3(light.m_col) * dot(_normal, vec3(light.m_dirRange)) + vec3(light.m_amb);
+			continue;
+		}
+		vec3 toLight = vec3(light.m_posType) - _pos;
+		float d = length(toLight);
+		float range = light.m_dirRange.w;
+		if (d < range)
+		{
+			float fade = 1.0f - d / range;
+			fade *= fade;
+			total += (vec3(light.m_col) * std::max(dot(_normal, toLight / d), 0.0f) + vec3(light.m_amb)) * fade;
+		}
+	}
+	return total;
+}
+
+void Benchmark::LightCulling()
+{
+	cout << "---- Light culling (1 directional light plus point lights, 100k points lit) ----" << endl;
+
+	const int counts[] = { 100, 1000, 4000 };
+	const size_t numPoints = 100000;
+	const float spread = 20.0f;
+	const float range = 5.0f;
+
+	for (int count : counts)
+	{
+		//placed just as Scene::AddPointLights does
+		vector<LightData> lights(count + 1);
+		DirectionLight sun;
+		sun.GetLightData(lights[0]);
+		mt19937 lightRng(count);
+		uniform_real_distribution<float> place(-spread, spread);
+		uniform_real_distribution<float> colour(0.0f, 1.0f);
+		for (int i = 0; i < count; i++)
+		{
+			Light light;
+			light.SetPos(vec3(place(lightRng), place(lightRng), place(lightRng)));
+			light.SetCol(vec3(colour(lightRng), colour(lightRng), colour(lightRng)));
+			light.SetAmb(vec3(0.0f));
+			light.SetRange(range);
+			light.GetLightData(lights[i + 1]);
+		}
+
+		LightGrid grid;
+		double buildTime = 1e30;
+		for (int run = 0; run < 5; run++)
+		{
+			double start = Now();
+			grid.Build(lights);
+			buildTime = std::min(buildTime, Now() - start);
+		}
+
+		//points spread a little wider than the lights, so some are outside the grid
+		vector<vec3> points(numPoints), normals(numPoints);
+		mt19937 rng(99);
+		uniform_real_distribution<float> where(-spread * 1.25f, spread * 1.25f);
+		uniform_real_distribution<float> axis(-1.0f, 1.0f);
+		for (size_t i = 0; i < numPoints; i++)
+		{
+			points[i] = vec3(where(rng), where(rng), where(rng));
+			normals[i] = normalize(vec3(axis(rng), axis(rng), axis(rng)) + vec3(0.0f, 0.0f, 1e-3f));
+		}
+
+		vector<vec3> all(numPoints), culled(numPoints);
+		double start = Now();
+		for (size_t i = 0; i < numPoints; i++)
+		{
+			all[i] = ShadePoint(lights, nullptr, (GLuint)lights.size(), points[i], normals[i]);
+		}
+		double allTime = Now() - start;
+
+		size_t tested = 0;
+		size_t maxTested = 0;
+		start = Now();
+		for (size_t i = 0; i < numPoints; i++)
+		{
+			const GLuint* global;
+			const GLuint* near;
+			GLuint numGlobal, numNear;
+			grid.GlobalLights(global, numGlobal);
+			grid.PointLightsAt(points[i], near, numNear);
+			culled[i] = ShadePoint(lights, global, numGlobal, points[i], normals[i]) + ShadePoint(lights, near, numNear, points[i], normals[i]);
+			tested += numGlobal + numNear;
+			maxTested = std::max(maxTested, (size_t)(numGlobal + numNear));
+		}
+		double culledTime = Now() - start;
+
+		float error = 0.0f;
+		for (size_t i = 0; i < numPoints; i++)
+		{
+			error = std::max(error, length(all[i] - culled[i]));
+		}
+
+		printf("%5d lights  grid %ux%ux%u %zu entries built in %.3f ms  lights per point ALL %d GRID %.1f (most %zu)  ns per point ALL %.0f GRID %.0f  x%.1f  %s (error %g)\n",
+			count, grid.m_dims.x, grid.m_dims.y, grid.m_dims.z, grid.m_data.size() - (grid.m_dims.w + 1) * 2, buildTime * 1e3,
+			count + 1, (double)tested / numPoints, maxTested, allTime * 1e9 / numPoints, culledTime * 1e9 / numPoints, allTime / culledTime,
+			error < 1e-3f ? "same light" : "DIFFERENT", error);
+	}
+	cout << endl;
+}
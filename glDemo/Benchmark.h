@@ -0,0 +1,45 @@
+#pragma once
+
+//micro benchmarks for the hot paths in the scene code
+//run with glDemo.exe -bench, results are printed to the console and the program exits
+class Benchmark
+{
+public:
+
+	//run everything below
+	static void RunAll();
+
+	//batched TRS kernels against the original per-object glm path at 1k, 10k and 100k objects
+	static void TransformCompose();
+
+	//TransformStore::Update on 100k spinning objects (some parented) at different thread counts
+	//checks every thread count builds exactly the same matrices as the single threaded update
+	static void SceneUpdate();
+
+	//BVH frustum, sphere and ray queries against testing every object, at 1k, 10k and 100k objects
+	//plus how long building and refitting the tree takes
+	static void SpatialQueries();
+
+	//update and render prep for 100k spinning objects as ExampleGOs in a list (the way the Scene holds them) against entities in an ECS World
+	//checks both build the same world matrices
+	//then loads manifest.txt into a World with ECSSystems::LoadManifest and times a frame of every system over it, lights included
+	static void EntityUpdate();
+
+	//allocating and freeing 100k GameObjects (plus lights and cameras) over and over, as loading and unloading a big manifest does
+	//one new / delete per object against a SceneArena, and checks the arena's memory stays the same from one load to the next
+	//then loads and unloads the manifest's models, checking the MeshArena gets all their vertices back each time
+	static void SceneReload();
+
+	//loading the manifest's models cold (Assimp import, then writing the MeshCache file) against warm (from the MeshCache file)
+	//checks the warm load puts exactly the same vertices, indices and bounds into the MeshArena
+	static void MeshLoad();
+
+	//every OBJ in Assets read by Assimp against the ObjLoader on one thread and on all of them, in MB of file a second
+	//checks the ObjLoader comes up with the same mesh as Assimp
+	static void ObjLoad();
+
+	//lighting points in a scene of 1k point lights (as -lights 1000 places them) plus a directional one, the way texture-directional.frag does
+	//every light for every point against just the LightGrid's list for its cell, plus how long building the grid takes
+	//checks both come to the same light, this is the CPU doing the shader's sums so it can't say how the GPU's frame times move
+	static void LightCulling();
+};
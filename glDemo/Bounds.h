@@ -0,0 +1,115 @@
+#pragma once
+#include "core.h"
+#include <float.h>
+#include "AlignedAllocator.h"
+
+using namespace glm;
+
+//bounding volumes for a mesh (or a whole model) in its own model space
+//both an axis aligned box and a sphere are kept, the sphere is cheaper to test but the box is usually tighter
+struct Bounds
+{
+	vec3 m_min = vec3(FLT_MAX);
+	vec3 m_max = vec3(-FLT_MAX);
+	vec3 m_centre = vec3(0.0f);		//of the sphere
+	float m_radius = 0.0f;
+
+	//nothing has been added yet, things without bounds are never culled
+	bool IsValid() const { return m_min.x <= m_max.x; }
+
+	//grow the box to include this point, call FinishSphere once they have all been added
+	void Add(const vec3& _point)
+	{
+		m_min = glm::min(m_min, _point);
+		m_max = glm::max(m_max, _point);
+	}
+
+	//grow the box to include all of another one
+	void Add(const Bounds& _other)
+	{
+		if (_other.IsValid())
+		{
+			Add(_other.m_min);
+			Add(_other.m_max);
+		}
+	}
+
+	//sphere around the middle of the box, just touching its corners
+	void FinishSphere()
+	{
+		m_centre = 0.5f * (m_min + m_max);
+		m_radius = IsValid() ? glm::length(m_max - m_centre) : 0.0f;
+	}
+};
+
+//world space bounds for every transform in a TransformStore
+//one array per component so the frustum test can load four or eight objects at a time
+struct WorldBounds
+{
+	//how big the bounds are for things with no bounds, huge but finite so 0 * it is still 0
+	static constexpr float UNBOUNDED = 1e30f;
+
+	//bounding sphere
+	AlignedVector<float> m_sphereX, m_sphereY, m_sphereZ, m_radius;
+
+	//bounding box as a centre and half size
+	AlignedVector<float> m_boxX, m_boxY, m_boxZ;
+	AlignedVector<float> m_extentX, m_extentY, m_extentZ;
+
+	size_t Size() const { return m_radius.size(); }
+
+	void Resize(size_t _count)
+	{
+		AlignedVector<float>* arrays[] = { &m_sphereX, &m_sphereY, &m_sphereZ, &m_radius, &m_boxX, &m_boxY, &m_boxZ, &m_extentX, &m_extentY, &m_extentZ };
+		for (AlignedVector<float>* a : arrays)
+		{
+			a->resize(_count, 0.0f);
+		}
+	}
+
+	void Reserve(size_t _count)
+	{
+		AlignedVector<float>* arrays[] = { &m_sphereX, &m_sphereY, &m_sphereZ, &m_radius, &m_boxX, &m_boxY, &m_boxZ, &m_extentX, &m_extentY, &m_extentZ };
+		for (AlignedVector<float>* a : arrays)
+		{
+			a->reserve(_count);
+		}
+	}
+
+	//take _local through _world and store the result in slot _i
+	void Set(size_t _i, const Bounds& _local, const mat4& _world)
+	{
+		if (!_local.IsValid())
+		{
+			vec3 pos = vec3(_world[3]);
+			m_sphereX[_i] = m_boxX[_i] = pos.x;
+			m_sphereY[_i] = m_boxY[_i] = pos.y;
+			m_sphereZ[_i] = m_boxZ[_i] = pos.z;
+			m_radius[_i] = m_extentX[_i] = m_extentY[_i] = m_extentZ[_i] = UNBOUNDED;
+			return;
+		}
+
+		//sphere, the radius grows by the biggest scale on any axis
+		vec3 centre = vec3(_world * vec4(_local.m_centre, 1.0f));
+		float scale2 = glm::max(glm::max(glm::dot(vec3(_world[0]), vec3(_world[0])), glm::dot(vec3(_world[1]), vec3(_world[1]))), glm::dot(vec3(_world[2]), vec3(_world[2])));
+		m_sphereX[_i] = centre.x;
+		m_sphereY[_i] = centre.y;
+		m_sphereZ[_i] = centre.z;
+		m_radius[_i] = _local.m_radius * sqrtf(scale2);
+
+		//box, the new half size along each world axis is |rotation and scale| * the old half size (Arvo)
+		vec3 boxCentre = vec3(_world * vec4(0.5f * (_local.m_min + _local.m_max), 1.0f));
+		vec3 halfSize = 0.5f * (_local.m_max - _local.m_min);
+		vec3 extent = glm::abs(vec3(_world[0])) * halfSize.x + glm::abs(vec3(_world[1])) * halfSize.y + glm::abs(vec3(_world[2])) * halfSize.z;
+		m_boxX[_i] = boxCentre.x;
+		m_boxY[_i] = boxCentre.y;
+		m_boxZ[_i] = boxCentre.z;
+		m_extentX[_i] = extent.x;
+		m_extentY[_i] = extent.y;
+		m_extentZ[_i] = extent.z;
+	}
+
+	//the box in slot _i as min / max corners
+	vec3 GetMin(size_t _i) const { return vec3(m_boxX[_i] - m_extentX[_i], m_boxY[_i] - m_extentY[_i], m_boxZ[_i] - m_extentZ[_i]); }
+	vec3 GetMax(size_t _i) const { return vec3(m_boxX[_i] + m_extentX[_i], m_boxY[_i] + m_extentY[_i], m_boxZ[_i] + m_extentZ[_i]); }
+};
@@ -3,6 +3,9 @@
 #include <fstream>
 #include <iostream>
 #include "stringHelp.h"
+#include "Scene.h"
+#include "GameObject.h"
+#include "FrameUniforms.h"
 #include <glm/gtc/matrix_transform.hpp>
 #include <glm/gtc/type_ptr.hpp>
 #include <glm/gtc/constants.hpp>
@@ -30,17 +33,26 @@ Camera::~Camera()
 /////////////////////////////////////////////////////////////////////////////////////
 void Camera::Init(float _screenWidth, float _screenHeight, Scene* _scene)
 {
+    // hook myself up to the GameObject I am attached to
+    if (!m_parentName.empty())
+    {
+        m_parent = _scene->GetGameObject(m_parentName);
+    }
+
     float aspect_ratio = _screenWidth / _screenHeight;
     m_projectionMatrix = glm::perspective(glm::radians(m_fov), aspect_ratio, m_near, m_far);
     UpdateViewMatrix();
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
-// Tick() - Update the camera's view matrix
+// Tick() - Update the camera's view matrix, but only if something has moved
 /////////////////////////////////////////////////////////////////////////////////////
 void Camera::Tick(float _dt)
 {
-    UpdateViewMatrix();
+    if (IsDirty())
+    {
+        UpdateViewMatrix();
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -54,26 +66,25 @@ void Camera::Load(ifstream& _file)
     StringHelp::Float(_file, "FOV", m_fov);
     StringHelp::Float(_file, "NEAR", m_near);
     StringHelp::Float(_file, "FAR", m_far);
+    StringHelp::OptionalString(_file, "PARENT", m_parentName);
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
-// SetRenderValues() - Set the camera's uniform values in the shader
+// IsDirty() - Does the view matrix need rebuilding?
 /////////////////////////////////////////////////////////////////////////////////////
-void Camera::SetRenderValues(unsigned int _prog)
+bool Camera::IsDirty()
 {
-    GLint loc;
-
-    // Matrix for the view transform
-    if (Helper::SetUniformLocation(_prog, "viewMatrix", &loc))
-        glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(GetView()));
-
-    // Matrix for the projection transform
-    if (Helper::SetUniformLocation(_prog, "projMatrix", &loc))
-        glUniformMatrix4fv(loc, 1, GL_FALSE, glm::value_ptr(GetProj()));
+    // if the GameObject I'm attached to moved this frame so have I
+    return m_viewDirty || (m_parent && m_parent->TransformChanged());
+}
 
-    // The current camera position
-    if (Helper::SetUniformLocation(_prog, "camPos", &loc))
-        glUniform3fv(loc, 1, glm::value_ptr(GetPos()));
+/////////////////////////////////////////////////////////////////////////////////////
+// SetRenderValues() - Set the camera's values in the camera uniform block
+/////////////////////////////////////////////////////////////////////////////////////
+void Camera::SetRenderValues()
+{
+    // view and projection transforms and the current camera position, all in one go
+    FrameUniforms::SetCamera(GetView(), GetProj(), GetWorldPos());
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -84,7 +95,7 @@ void Camera::MoveForward(float deltaTime)
     glm::vec3 forward = glm::normalize(m_lookAt - m_pos);
     m_pos += forward * movementSpeed * deltaTime;
     m_lookAt += forward * movementSpeed * deltaTime;
-    UpdateViewMatrix();
+    m_viewDirty = true;
 }
 
 void Camera::MoveBackward(float deltaTime)
@@ -92,7 +103,7 @@ void Camera::MoveBackward(float deltaTime)
     glm::vec3 backward = glm::normalize(m_pos - m_lookAt);
     m_pos += backward * movementSpeed * deltaTime;
     m_lookAt += backward * movementSpeed * deltaTime;
-    UpdateViewMatrix();
+    m_viewDirty = true;
 }
 
 void Camera::MoveLeft(float deltaTime)
@@ -101,7 +112,7 @@ void Camera::MoveLeft(float deltaTime)
     glm::vec3 left = glm::normalize(glm::cross(glm::vec3(0.0f, 1.0f, 0.0f), forward));
     m_pos += left * movementSpeed * deltaTime;
     m_lookAt += left * movementSpeed * deltaTime;
-    UpdateViewMatrix();
+    m_viewDirty = true;
 }
 
 void Camera::MoveRight(float deltaTime)
@@ -110,7 +121,7 @@ void Camera::MoveRight(float deltaTime)
     glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.0f, 1.0f, 0.0f)));
     m_pos += right * movementSpeed * deltaTime;
     m_lookAt += right * movementSpeed * deltaTime;
-    UpdateViewMatrix();
+    m_viewDirty = true;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -134,7 +145,7 @@ void Camera::Rotate(float xOffset, float yOffset)
     direction.z = sin(glm::radians(yaw)) * cos(glm::radians(pitch));
     m_lookAt = m_pos + glm::normalize(direction);
 
-    UpdateViewMatrix();
+    m_viewDirty = true;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -142,5 +153,20 @@ void Camera::Rotate(float xOffset, float yOffset)
 /////////////////////////////////////////////////////////////////////////////////////
 void Camera::UpdateViewMatrix()
 {
-    m_viewMatrix = glm::lookAt(m_pos, m_lookAt, glm::vec3(0.0f, 1.0f, 0.0f));
+    glm::vec3 target = m_lookAt;
+    glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f);
+    m_worldPos = m_pos;
+
+    // attached cameras are positioned relative to their parent, so take everything into world space
+    if (m_parent)
+    {
+        const glm::mat4& world = m_parent->GetWorldMatrix();
+        m_worldPos = glm::vec3(world * glm::vec4(m_pos, 1.0f));
+        target = glm::vec3(world * glm::vec4(m_lookAt, 1.0f));
+        up = glm::normalize(glm::vec3(world * glm::vec4(up, 0.0f)));
+    }
+
+    m_viewMatrix = glm::lookAt(m_worldPos, target, up);
+    m_viewDirty = false;
+    m_version++;
 }
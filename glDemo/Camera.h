@@ -14,6 +14,7 @@ using namespace glm;
 class cTransform;
 class Light;
 class Scene;
+class GameObject;
 
 // Base class for a camera
 class Camera
@@ -36,6 +37,7 @@ public:
     glm::mat4 GetProj() { return m_projectionMatrix; }
     glm::mat4 GetView() { return m_viewMatrix; }
     glm::vec3 GetPos() { return m_pos; }
+    glm::vec3 GetWorldPos() { return m_worldPos; }
     float GetFOV() { return m_fov; }
     float GetNear() { return m_near; }
     float GetFar() { return m_far; }
@@ -53,10 +55,23 @@ public:
 
     // Set the camera's look-at position
     vec3 GetLookAt() { return m_lookAt; }
-    void SetLookAt(vec3 _pos) { m_lookAt = _pos; UpdateViewMatrix(); }
+    void SetLookAt(vec3 _pos) { m_lookAt = _pos; m_viewDirty = true; }
 
-    // Set up shader values for rendering
-    virtual void SetRenderValues(unsigned int _prog);
+    // Has anything moved since the view matrix was last built?
+    // (including the GameObject I am attached to, if there is one)
+    bool IsDirty();
+
+    // Attach me to a GameObject, POS and LOOKAT are then relative to it and I move with it
+    void SetParent(GameObject* _parent) { m_parent = _parent; m_viewDirty = true; }
+    GameObject* GetParent() { return m_parent; }
+    string GetParentName() { return m_parentName; }
+
+    // Goes up every time the view or projection matrix changes
+    // so anything caching values derived from them knows when to refresh
+    unsigned int GetVersion() { return m_version; }
+
+    // Set up shader values for rendering, written to the camera uniform block every shader shares
+    virtual void SetRenderValues();
 
 protected:
     // Update the view matrix based on position and orientation
@@ -69,6 +84,11 @@ protected:
     // Camera position and orientation
     glm::vec3 m_pos;               // Camera position
     glm::vec3 m_lookAt;            // Look-at position
+    glm::vec3 m_worldPos;          // m_pos taken through the parent's world matrix (same as m_pos without a parent)
+
+    // Optional GameObject this camera is attached to
+    string m_parentName;
+    GameObject* m_parent = nullptr;
 
     // Camera properties
     float m_fov;                   // Field of view
@@ -81,6 +101,10 @@ protected:
     float yaw = -90.0f;            // Yaw angle (rotation around Y-axis)
     float pitch = 0.0f;            // Pitch angle (rotation around X-axis)
 
+    // Change tracking
+    bool m_viewDirty = true;       // view matrix needs rebuilding on the next Tick
+    unsigned int m_version = 0;    // bumped whenever the view or projection matrix changes
+
     // Metadata
     string m_name;
     string m_type;
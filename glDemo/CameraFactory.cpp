@@ -1,15 +1,16 @@
 #include "CameraFactory.h"
 #include "Camera.h"
+#include "SceneArena.h"
 #include <assert.h>
 
 using std::string;
 
-Camera* CameraFactory::makeNewCam(string _type)
+Camera* CameraFactory::makeNewCam(string _type, SceneArena& _arena)
 {
 	printf("CAM TYPE: %s \n", _type.c_str());
 	if (_type == "CAMERA")
 	{
-		return new Camera();
+		return _arena.New<Camera>();
 	}
 	else
 	{
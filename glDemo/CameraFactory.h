@@ -1,11 +1,12 @@
 #pragma once
 #include <string>
 class Camera;
+class SceneArena;
 //A rather simple Factory using the base class Camera
-//generates a Camera based on its type
+//generates a Camera based on its type, allocated out of _arena
 class CameraFactory
 {
 public:
 
-	static Camera* makeNewCam(std::string type);
+	static Camera* makeNewCam(std::string type, SceneArena& _arena);
 };
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include "Cube.h"
+#include "GLState.h"
 
 
 using namespace std;
@@ -71,18 +72,18 @@ Cube::Cube() {
 	m_numFaces = 6 * 2;
 
 	glGenVertexArrays(1, &m_vao);
-	glBindVertexArray(m_vao);
+	GLState::BindVertexArray(m_vao);
 
 	// setup vbo for position attribute
 	glGenBuffers(1, &m_vertexBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_vertexBuffer);
 	glBufferData(GL_ARRAY_BUFFER, 32 * sizeof(float), positionArray, GL_STATIC_DRAW);
 	glVertexAttribPointer(0, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
 	glEnableVertexAttribArray(0);
 
 	// setup vbo for colour attribute
 	glGenBuffers(1, &m_colourBuffer);
-	glBindBuffer(GL_ARRAY_BUFFER, m_colourBuffer);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, m_colourBuffer);
 	glBufferData(GL_ARRAY_BUFFER, 32 * sizeof(float), colourArray, GL_STATIC_DRAW); 
 	glVertexAttribPointer(4, 4, GL_FLOAT, GL_FALSE, 0, (const GLvoid*)0);
 	glEnableVertexAttribArray(4);
@@ -92,22 +93,28 @@ Cube::Cube() {
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, m_indexBuffer);
 	glBufferData(GL_ELEMENT_ARRAY_BUFFER, 36 * sizeof(unsigned int), indexArray, GL_STATIC_DRAW);
 
-	glBindVertexArray(0);
+	GLState::BindVertexArray(0);
 }
 
 
 Cube::~Cube() {
 
-	glBindBuffer(GL_ARRAY_BUFFER, 0);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, 0);
 	glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
 
+	//so the shadow doesn't think a name GL hands out again is still bound
+	GLState::ForgetBuffer(m_vertexBuffer);
+	GLState::ForgetBuffer(m_colourBuffer);
+	GLState::ForgetBuffer(m_indexBuffer);
 	glDeleteBuffers(1, &m_vertexBuffer);
 	glDeleteBuffers(1, &m_colourBuffer);
 	glDeleteBuffers(1, &m_indexBuffer);
+	GLState::ForgetVertexArray(m_vao);
+	glDeleteVertexArrays(1, &m_vao);
 }
 
 
 void Cube::render() {
-	glBindVertexArray(m_vao);
+	GLState::BindVertexArray(m_vao);
 	glDrawElements(GL_TRIANGLES, m_numFaces * 3 , GL_UNSIGNED_INT, (const GLvoid*)0);
 }
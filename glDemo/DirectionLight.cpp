@@ -18,16 +18,15 @@ void DirectionLight::Load(ifstream& _file)
 {
 	Light::Load(_file);
 	StringHelp::Float3(_file, "DIRECTION", m_direction.x, m_direction.y, m_direction.z);
+	m_version++;
 }
 
-void DirectionLight::SetRenderValues(unsigned int _prog)
+void DirectionLight::GetLightData(LightData& _out)
 {
 	//still need to tell the shader about the basic light data
-	Light::SetRenderValues(_prog);
+	Light::GetLightData(_out);
 
-	GLint loc;
-	string dirString = m_name + "Dir";//only thing I add is a direction
-
-	if (Helper::SetUniformLocation(_prog, dirString.c_str(), &loc))
-		glUniform3fv(loc, 1, glm::value_ptr(m_direction));
+	//only thing I add is a direction
+	_out.m_posType.w = (float)LIGHT_DIRECTION;
+	_out.m_dirRange = vec4(m_direction, 0.0f);
 }
@@ -13,8 +13,8 @@ public:
 	//load from manifest
 	virtual void Load(ifstream& _file);
 
-	//set render values
-	virtual void SetRenderValues(unsigned int _prog);
+	//same as a point light but with a direction, and no range as it reaches everywhere
+	virtual void GetLightData(LightData& _out);
 
 	//TODO: We don't have our own tick
 	// a nice feature would be a day / night cycle effect 
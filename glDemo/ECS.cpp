@@ -0,0 +1,201 @@
+#include "ECS.h"
+#include <string.h>
+#include <assert.h>
+
+//sizes of each component, in ComponentID order
+static const size_t s_componentSizes[NUM_COMPONENTS] =
+{
+	sizeof(PositionComponent),
+	sizeof(RotationComponent),
+	sizeof(ScaleComponent),
+	sizeof(WorldComponent),
+	sizeof(NormalComponent),
+	sizeof(ParentComponent),
+	sizeof(SpinComponent),
+	sizeof(RenderableComponent),
+	sizeof(LightComponent),
+};
+
+//every array in a chunk starts on its own cache line
+static size_t AlignUp(size_t _bytes)
+{
+	return (_bytes + 63) & ~(size_t)63;
+}
+
+uint32_t World::FindArchetype(ComponentMask _mask)
+{
+	for (size_t a = 0; a < m_archetypes.size(); a++)
+	{
+		if (m_archetypes[a]->m_mask == _mask)
+		{
+			return (uint32_t)a;
+		}
+	}
+
+	//work out how many entities fit in a chunk, allowing for the padding between arrays
+	size_t perEntity = sizeof(Entity);
+	size_t padding = 64;
+	for (int c = 0; c < NUM_COMPONENTS; c++)
+	{
+		if (_mask & COMPONENT_BIT(c))
+		{
+			perEntity += s_componentSizes[c];
+			padding += 64;
+		}
+	}
+
+	Archetype* archetype = new Archetype;
+	archetype->m_mask = _mask;
+	archetype->m_capacity = CHUNK_BYTES > padding + perEntity ? (CHUNK_BYTES - padding) / perEntity : 1;
+	m_archetypes.push_back(archetype);
+	return (uint32_t)(m_archetypes.size() - 1);
+}
+
+Chunk* World::NewChunk(const Archetype& _archetype)
+{
+	Chunk* chunk = new Chunk;
+
+	//entity ids first, then an array per component
+	size_t offset = AlignUp(_archetype.m_capacity * sizeof(Entity));
+	for (int c = 0; c < NUM_COMPONENTS; c++)
+	{
+		if (_archetype.m_mask & COMPONENT_BIT(c))
+		{
+			chunk->m_offsets[c] = offset;
+			offset += AlignUp(_archetype.m_capacity * s_componentSizes[c]);
+		}
+		else
+		{
+			chunk->m_offsets[c] = Chunk::NO_COMPONENT;
+		}
+	}
+	chunk->m_data.resize(offset);
+	return chunk;
+}
+
+Entity World::Create(ComponentMask _mask)
+{
+	uint32_t a = FindArchetype(_mask);
+	Archetype& archetype = *m_archetypes[a];
+
+	//a chunk with room left by something destroyed, or a new one if they are all full
+	if (archetype.m_open.empty())
+	{
+		archetype.m_chunks.push_back(NewChunk(archetype));
+		archetype.m_open.push_back((uint32_t)(archetype.m_chunks.size() - 1));
+	}
+	uint32_t c = archetype.m_open.back();
+	Chunk& chunk = *archetype.m_chunks[c];
+	uint32_t row = (uint32_t)chunk.m_count++;
+	if (chunk.m_count == archetype.m_capacity)
+	{
+		archetype.m_open.pop_back();
+	}
+
+	uint32_t index;
+	if (!m_free.empty())
+	{
+		index = m_free.back();
+		m_free.pop_back();
+	}
+	else
+	{
+		index = (uint32_t)m_locations.size();
+		m_locations.push_back(Location());
+		m_locations[index].m_generation = 0;
+	}
+	Location& location = m_locations[index];
+	location.m_archetype = a;
+	location.m_chunk = c;
+	location.m_row = row;
+	Entity entity = ((Entity)location.m_generation << 32) | index;
+	m_numAlive++;
+
+	chunk.GetEntities()[row] = entity;
+	for (int comp = 0; comp < NUM_COMPONENTS; comp++)
+	{
+		if (chunk.m_offsets[comp] != Chunk::NO_COMPONENT)
+		{
+			memset(chunk.m_data.data() + chunk.m_offsets[comp] + row * s_componentSizes[comp], 0, s_componentSizes[comp]);
+		}
+	}
+	return entity;
+}
+
+void World::Destroy(Entity _entity)
+{
+	if (!IsAlive(_entity))
+	{
+		printf("DESTROYING AN ENTITY THAT DOESN'T EXIST: %u (generation %u) \n", EntityIndex(_entity), EntityGeneration(_entity));
+		assert(0);
+		return;
+	}
+
+	uint32_t index = EntityIndex(_entity);
+	Location location = m_locations[index];
+	Archetype& archetype = *m_archetypes[location.m_archetype];
+	Chunk& chunk = *archetype.m_chunks[location.m_chunk];
+
+	//fill the gap with the last entity in this chunk
+	size_t last = chunk.m_count - 1;
+	if (location.m_row != last)
+	{
+		Entity moved = chunk.GetEntities()[last];
+		chunk.GetEntities()[location.m_row] = moved;
+		for (int comp = 0; comp < NUM_COMPONENTS; comp++)
+		{
+			if (chunk.m_offsets[comp] != Chunk::NO_COMPONENT)
+			{
+				unsigned char* array = chunk.m_data.data() + chunk.m_offsets[comp];
+				memcpy(array + location.m_row * s_componentSizes[comp], array + last * s_componentSizes[comp], s_componentSizes[comp]);
+			}
+		}
+		m_locations[EntityIndex(moved)].m_row = location.m_row;
+	}
+
+	//it has room again, so goes back on the list to fill
+	if (chunk.m_count == archetype.m_capacity)
+	{
+		archetype.m_open.push_back(location.m_chunk);
+	}
+	chunk.m_count--;
+
+	m_locations[index].m_archetype = INVALID_ARCHETYPE;
+	m_locations[index].m_generation++;
+	m_free.push_back(index);
+	m_numAlive--;
+
+	//it may have been something's parent, there's no list of children to check so just have them all looked at
+	if (!m_hierarchyChanged)
+	{
+		for (size_t a = 0; a < m_archetypes.size(); a++)
+		{
+			if (m_archetypes[a]->m_mask & COMPONENT_BIT(COMP_PARENT))
+			{
+				m_hierarchyChanged = true;
+				break;
+			}
+		}
+	}
+}
+
+void World::Clear()
+{
+	for (size_t a = 0; a < m_archetypes.size(); a++)
+	{
+		for (size_t c = 0; c < m_archetypes[a]->m_chunks.size(); c++)
+		{
+			delete m_archetypes[a]->m_chunks[c];
+		}
+		delete m_archetypes[a];
+	}
+	m_archetypes.clear();
+	m_locations.clear();
+	m_free.clear();
+	m_numAlive = 0;
+	m_hierarchyChanged = false;
+
+	m_models.Clear();
+	m_textures.Clear();
+	m_shaders.Clear();
+}
@@ -0,0 +1,247 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include <vector>
+#include <assert.h>
+#include "AlignedAllocator.h"
+#include "NameRegistry.h"
+#include "RenderPass.h"
+#include "LightBuffer.h"
+
+using namespace std;
+using namespace glm;
+
+class Model;
+class Texture;
+class Shader;
+
+//entity-component storage, a data oriented alternative to the GameObject class hierarchy
+//an entity is just an id, everything about it lives in components (plain structs, no virtuals)
+//entities with exactly the same set of components share an archetype, which keeps them in fixed size chunks
+//each chunk holds an array per component, so a system can run through one component of every entity in a tight loop
+//see ECSSystems.h for the systems and for loading the manifest into a World
+
+//the low half is the slot its Location lives in, the high half how many times that slot had been reused when it was made
+//so a handle kept after its entity was destroyed never refers to whatever is made in the slot next
+typedef uint64_t Entity;
+const Entity INVALID_ENTITY = 0xffffffffffffffffull;
+
+inline uint32_t EntityIndex(Entity _entity) { return (uint32_t)_entity; }
+inline uint32_t EntityGeneration(Entity _entity) { return (uint32_t)(_entity >> 32); }
+
+enum ComponentID
+{
+	COMP_POSITION = 0,
+	COMP_ROTATION,
+	COMP_SCALE,
+	COMP_WORLD,
+	COMP_NORMAL,
+	COMP_PARENT,
+	COMP_SPIN,
+	COMP_RENDERABLE,
+	COMP_LIGHT,
+	NUM_COMPONENTS
+};
+
+//which components an entity has, a bit per ComponentID
+typedef uint32_t ComponentMask;
+#define COMPONENT_BIT(_id) (1u << (_id))
+
+//the transform is split over several components so each chunk holds plain vec3 / mat4 arrays
+//which the TransformKernels can build world matrices from directly
+struct PositionComponent
+{
+	static const ComponentID ID = COMP_POSITION;
+	vec3 m_pos;
+};
+
+struct RotationComponent
+{
+	static const ComponentID ID = COMP_ROTATION;
+	vec3 m_rot;		//Euler angles in degrees
+};
+
+struct ScaleComponent
+{
+	static const ComponentID ID = COMP_SCALE;
+	vec3 m_scale;
+};
+
+struct WorldComponent
+{
+	static const ComponentID ID = COMP_WORLD;
+	mat4 m_world;
+};
+
+//inverse transpose of the world matrix for lighting
+struct NormalComponent
+{
+	static const ComponentID ID = COMP_NORMAL;
+	mat3 m_normal;
+};
+
+//position, rotation and scale are relative to this entity, set both with ECSSystems::SetParent
+//if the parent is destroyed m_parent becomes INVALID_ENTITY and m_depth 0, leaving it a root that keeps its local transform
+struct ParentComponent
+{
+	static const ComponentID ID = COMP_PARENT;
+	Entity m_parent;
+	uint32_t m_depth;	//1 under an entity with no parent, one more for each level below that
+};
+
+//degrees a second to add to the rotation
+struct SpinComponent
+{
+	static const ComponentID ID = COMP_SPIN;
+	vec3 m_rotInc;
+};
+
+//what it is drawn with and in which pass
+struct RenderableComponent
+{
+	static const ComponentID ID = COMP_RENDERABLE;
+	Handle<Shader> m_shader;
+	Handle<Texture> m_texture;
+	Handle<Model> m_model;
+	RenderPass m_RP;
+};
+
+//a light, already packed the way the shaders' light buffer wants it
+struct LightComponent
+{
+	static const ComponentID ID = COMP_LIGHT;
+	LightData m_data;
+};
+
+//the component arrays for up to m_capacity entities of one archetype
+class Chunk
+{
+public:
+
+	Chunk() {}
+
+	size_t Size() const { return m_count; }
+
+	//start of the array for component T, nullptr if this archetype doesn't have it
+	template<class T>
+	T* Get() { return m_offsets[T::ID] == NO_COMPONENT ? nullptr : (T*)(m_data.data() + m_offsets[T::ID]); }
+
+	Entity* GetEntities() { return (Entity*)m_data.data(); }
+
+protected:
+
+	friend class World;
+
+	Chunk(const Chunk&) = delete;
+	Chunk& operator=(const Chunk&) = delete;
+
+	static const size_t NO_COMPONENT = (size_t)-1;
+
+	AlignedVector<unsigned char> m_data;
+	size_t m_offsets[NUM_COMPONENTS];
+	size_t m_count = 0;
+};
+
+//every entity with one particular set of components
+struct Archetype
+{
+	ComponentMask m_mask;
+	size_t m_capacity;		//entities per chunk
+	vector<Chunk*> m_chunks;
+	vector<uint32_t> m_open;	//chunks with room for another entity, the last one is filled first
+};
+
+class World
+{
+public:
+
+	//bytes in each chunk, each archetype fits as many entities into that as it can
+	static const size_t CHUNK_BYTES = 16 * 1024;
+
+	World() {}
+	~World() { Clear(); }
+
+	//a new entity with these components (all zeroed), in the first room going in a chunk its archetype already has
+	Entity Create(ComponentMask _mask);
+
+	//remove an entity, the last one in its chunk moves into its place
+	//anything parented to it is only let go of by the next ECSSystems::Transforms, so until then don't Get its parent without checking IsAlive
+	void Destroy(Entity _entity);
+
+	//false for an entity since destroyed, even once its slot has gone to another one
+	bool IsAlive(Entity _entity) const
+	{
+		uint32_t index = EntityIndex(_entity);
+		return index < m_locations.size() && m_locations[index].m_archetype != INVALID_ARCHETYPE && m_locations[index].m_generation == EntityGeneration(_entity);
+	}
+	ComponentMask GetMask(Entity _entity) const { return m_archetypes[m_locations[EntityIndex(_entity)].m_archetype]->m_mask; }
+
+	//one component of one entity, nullptr if it doesn't have it
+	template<class T>
+	T* Get(Entity _entity)
+	{
+		assert(IsAlive(_entity));
+		const Location& location = m_locations[EntityIndex(_entity)];
+		T* array = m_archetypes[location.m_archetype]->m_chunks[location.m_chunk]->Get<T>();
+		return array ? array + location.m_row : nullptr;
+	}
+
+	//call _fn(Chunk&) for every chunk of every archetype with all of _required and none of _excluded
+	template<class F>
+	void ForEachChunk(ComponentMask _required, ComponentMask _excluded, F _fn)
+	{
+		for (size_t a = 0; a < m_archetypes.size(); a++)
+		{
+			Archetype* archetype = m_archetypes[a];
+			if ((archetype->m_mask & _required) != _required || (archetype->m_mask & _excluded))
+			{
+				continue;
+			}
+			for (size_t c = 0; c < archetype->m_chunks.size(); c++)
+			{
+				if (archetype->m_chunks[c]->m_count)
+				{
+					_fn(*archetype->m_chunks[c]);
+				}
+			}
+		}
+	}
+
+	size_t NumEntities() const { return m_numAlive; }
+	size_t NumArchetypes() const { return m_archetypes.size(); }
+
+	void Clear();
+
+	//names from the manifest, interned in the same order the Scene loads them
+	//so these handles are the same as the Scene's for the same manifest
+	NameRegistry<Model> m_models;
+	NameRegistry<Texture> m_textures;
+	NameRegistry<Shader> m_shaders;
+
+	//set by Destroy and ECSSystems::SetParent when the depths in the ParentComponents may be wrong
+	//ECSSystems::Transforms works them all out again before using them and clears it
+	bool m_hierarchyChanged = false;
+
+protected:
+
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
+
+	static const uint32_t INVALID_ARCHETYPE = 0xffffffff;
+
+	struct Location
+	{
+		uint32_t m_archetype;
+		uint32_t m_chunk;
+		uint32_t m_row;
+		uint32_t m_generation;	//goes up each time the entity in this slot is destroyed
+	};
+
+	uint32_t FindArchetype(ComponentMask _mask);
+	Chunk* NewChunk(const Archetype& _archetype);
+
+	vector<Archetype*> m_archetypes;
+	vector<Location> m_locations;	//EntityIndex -> where its components are
+	vector<uint32_t> m_free;		//slots of destroyed entities to hand out again
+	size_t m_numAlive = 0;
+};
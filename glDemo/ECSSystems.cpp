@@ -0,0 +1,289 @@
+#include "ECSSystems.h"
+#include "TransformKernels.h"
+#include "RenderQueue.h"
+#include "TransformStore.h"
+#include "GameObjectFactory.h"
+#include "ExampleGO.h"
+#include "LightFactory.h"
+#include "Light.h"
+#include "stringHelp.h"
+#include "SceneArena.h"
+#include <unordered_map>
+#include <algorithm>
+#include <assert.h>
+
+void ECSSystems::Spin(World& _world)
+{
+	_world.ForEachChunk(COMPONENT_BIT(COMP_ROTATION) | COMPONENT_BIT(COMP_SPIN), 0, [](Chunk& _chunk)
+	{
+		RotationComponent* rot = _chunk.Get<RotationComponent>();
+		const SpinComponent* spin = _chunk.Get<SpinComponent>();
+		for (size_t i = 0; i < _chunk.Size(); i++)
+		{
+			rot[i].m_rot += spin[i].m_rotInc;
+		}
+	});
+}
+
+//the normal matrices to go with a chunk's world matrices
+static void BuildNormals(Chunk& _chunk)
+{
+	const WorldComponent* world = _chunk.Get<WorldComponent>();
+	NormalComponent* normal = _chunk.Get<NormalComponent>();
+	for (size_t i = 0; i < _chunk.Size(); i++)
+	{
+		normal[i].m_normal = glm::transpose(glm::inverse(mat3(world[i].m_world)));
+	}
+}
+
+//work out every child's depth again by counting its parents, and let go of any whose parent has been destroyed
+//only run when SetParent or World::Destroy has changed the hierarchy, this goes up every chain so costs more than a frame's transforms
+static void UpdateDepths(World& _world)
+{
+	_world.ForEachChunk(COMPONENT_BIT(COMP_PARENT), 0, [&_world](Chunk& _chunk)
+	{
+		ParentComponent* parent = _chunk.Get<ParentComponent>();
+		for (size_t i = 0; i < _chunk.Size(); i++)
+		{
+			//never given a parent, or already let go of it
+			if (parent[i].m_depth == 0)
+			{
+				continue;
+			}
+			if (!_world.IsAlive(parent[i].m_parent))
+			{
+				parent[i].m_parent = INVALID_ENTITY;
+				parent[i].m_depth = 0;
+				continue;
+			}
+
+			uint32_t depth = 1;
+			const ParentComponent* above = _world.Get<ParentComponent>(parent[i].m_parent);
+			while (above && above->m_depth && _world.IsAlive(above->m_parent))
+			{
+				depth++;
+				above = _world.Get<ParentComponent>(above->m_parent);
+				assert(depth < 0xffff);	//an entity can't be its own ancestor
+			}
+			parent[i].m_depth = depth;
+		}
+	});
+	_world.m_hierarchyChanged = false;
+}
+
+void ECSSystems::Transforms(World& _world)
+{
+	//the components are single vec3s and mat4s, so a chunk's arrays can go straight into the SIMD kernels
+	static_assert(sizeof(PositionComponent) == sizeof(vec3) && sizeof(RotationComponent) == sizeof(vec3) && sizeof(ScaleComponent) == sizeof(vec3), "transform components must be bare vec3s");
+	static_assert(sizeof(WorldComponent) == sizeof(mat4), "world component must be a bare mat4");
+
+	//everything without a parent first
+	_world.ForEachChunk(TRANSFORM_MASK, COMPONENT_BIT(COMP_PARENT), [](Chunk& _chunk)
+	{
+		TransformKernels::ComposeTRS((const vec3*)_chunk.Get<PositionComponent>(), (const vec3*)_chunk.Get<RotationComponent>(), (const vec3*)_chunk.Get<ScaleComponent>(),
+			(mat4*)_chunk.Get<WorldComponent>(), _chunk.Size());
+		BuildNormals(_chunk);
+	});
+
+	if (_world.m_hierarchyChanged)
+	{
+		UpdateDepths(_world);
+	}
+
+	//then the children's local matrices, those at depth 0 have lost their parent so this is their world matrix
+	const ComponentMask childMask = TRANSFORM_MASK | COMPONENT_BIT(COMP_PARENT);
+	uint32_t maxDepth = 0;
+	_world.ForEachChunk(childMask, 0, [&maxDepth](Chunk& _chunk)
+	{
+		TransformKernels::ComposeTRS((const vec3*)_chunk.Get<PositionComponent>(), (const vec3*)_chunk.Get<RotationComponent>(), (const vec3*)_chunk.Get<ScaleComponent>(),
+			(mat4*)_chunk.Get<WorldComponent>(), _chunk.Size());
+		const ParentComponent* parent = _chunk.Get<ParentComponent>();
+		for (size_t i = 0; i < _chunk.Size(); i++)
+		{
+			maxDepth = std::max(maxDepth, parent[i].m_depth);
+		}
+	});
+
+	//and onto their parents' a level at a time, so every parent is finished before anything below it reads it
+	for (uint32_t depth = 1; depth <= maxDepth; depth++)
+	{
+		_world.ForEachChunk(childMask, 0, [&_world, depth](Chunk& _chunk)
+		{
+			WorldComponent* world = _chunk.Get<WorldComponent>();
+			const ParentComponent* parent = _chunk.Get<ParentComponent>();
+			for (size_t i = 0; i < _chunk.Size(); i++)
+			{
+				if (parent[i].m_depth == depth)
+				{
+					world[i].m_world = _world.Get<WorldComponent>(parent[i].m_parent)->m_world * world[i].m_world;
+				}
+			}
+		});
+	}
+	_world.ForEachChunk(childMask, 0, [](Chunk& _chunk)
+	{
+		BuildNormals(_chunk);
+	});
+}
+
+void ECSSystems::SetParent(World& _world, Entity _child, Entity _parent)
+{
+	ParentComponent* link = _world.Get<ParentComponent>(_child);
+	assert(link);
+	const ParentComponent* above = _world.Get<ParentComponent>(_parent);
+	link->m_parent = _parent;
+	link->m_depth = above ? above->m_depth + 1 : 1;
+
+	//anything already below _child is now at the wrong depth
+	_world.m_hierarchyChanged = true;
+}
+
+void ECSSystems::RenderPrep(World& _world, const mat4& _view, float _farPlane, vector<uint64_t>& _keys, vector<InstanceData>& _instances)
+{
+	_keys.clear();
+	_instances.clear();
+	_world.ForEachChunk(COMPONENT_BIT(COMP_RENDERABLE) | COMPONENT_BIT(COMP_WORLD) | COMPONENT_BIT(COMP_NORMAL), 0, [&](Chunk& _chunk)
+	{
+		const RenderableComponent* renderable = _chunk.Get<RenderableComponent>();
+		const WorldComponent* world = _chunk.Get<WorldComponent>();
+		const NormalComponent* normal = _chunk.Get<NormalComponent>();
+		for (size_t i = 0; i < _chunk.Size(); i++)
+		{
+			if (!(renderable[i].m_RP & RP_OPAQUE))
+			{
+				continue;
+			}
+
+			//distance in front of the camera of the entity's origin
+			const mat4& m = world[i].m_world;
+			float depth = -(_view[0][2] * m[3][0] + _view[1][2] * m[3][1] + _view[2][2] * m[3][2] + _view[3][2]);
+			_keys.push_back(RenderQueue::MakeKey(0, renderable[i].m_shader.m_index, renderable[i].m_texture.m_index, renderable[i].m_model.m_index, depth / _farPlane));
+
+			InstanceData data;
+			data.m_model = m;
+			data.m_normal = normal[i].m_normal;
+			_instances.push_back(data);
+		}
+	});
+}
+
+void ECSSystems::GatherLights(World& _world, vector<LightData>& _out)
+{
+	_out.clear();
+	_world.ForEachChunk(COMPONENT_BIT(COMP_LIGHT), 0, [&_out](Chunk& _chunk)
+	{
+		const LightComponent* light = _chunk.Get<LightComponent>();
+		for (size_t i = 0; i < _chunk.Size(); i++)
+		{
+			_out.push_back(light[i].m_data);
+		}
+	});
+}
+
+void ECSSystems::LoadManifest(World& _world, ifstream& _file)
+{
+	//cameras aren't entities (yet)
+	int numCameras = StringHelp::SectionCount(_file);
+	for (int i = 0; i < numCameras; i++)
+	{
+		StringHelp::SkipEntry(_file);
+	}
+
+	//the lights and GameObjects are read in by the same classes the Scene uses, then copied out into components
+	//they are only needed while loading so all come out of an arena thrown away at the end
+	SceneArena scratchArena;
+
+	//lights are packed into a light component
+	int numLights = StringHelp::SectionCount(_file);
+	for (int i = 0; i < numLights; i++)
+	{
+		Light* light = LightFactory::makeNewLight(StringHelp::EntryType(_file), scratchArena);
+		light->Load(_file);
+
+		Entity entity = _world.Create(COMPONENT_BIT(COMP_LIGHT));
+		light->GetLightData(_world.Get<LightComponent>(entity)->m_data);
+
+		_file.ignore(256, '\n');
+	}
+
+	//only the names of these are needed, in the same order as Scene::Load registers them
+	int numModels = StringHelp::SectionCount(_file);
+	for (int i = 0; i < numModels; i++)
+	{
+		_world.m_models.Add(StringHelp::SkipEntry(_file), nullptr);
+	}
+	int numTextures = StringHelp::SectionCount(_file);
+	for (int i = 0; i < numTextures; i++)
+	{
+		_world.m_textures.Add(StringHelp::SkipEntry(_file), nullptr);
+	}
+	int numShaders = StringHelp::SectionCount(_file);
+	for (int i = 0; i < numShaders; i++)
+	{
+		_world.m_shaders.Add(StringHelp::SkipEntry(_file), nullptr);
+	}
+
+	//GameObjects are loaded into a scratch TransformStore first
+	TransformStore scratch;
+	unordered_map<string, Entity> entities;
+	int numGameObjects = StringHelp::SectionCount(_file);
+	for (int i = 0; i < numGameObjects; i++)
+	{
+		GameObject* GO = GameObjectFactory::makeNewGO(StringHelp::EntryType(_file), scratchArena);
+		TransformID id = scratch.Add();
+		GO->SetTransform(&scratch, id);
+		GO->Load(_file);
+
+		ComponentMask mask = TRANSFORM_MASK;
+		if (scratch.GetRotIncr(id) != vec3(0.0f))
+		{
+			mask |= COMPONENT_BIT(COMP_SPIN);
+		}
+
+		Entity parent = INVALID_ENTITY;
+		if (!GO->GetParentName().empty())
+		{
+			auto it = entities.find(GO->GetParentName());
+			if (it != entities.end())
+			{
+				parent = it->second;
+				mask |= COMPONENT_BIT(COMP_PARENT);
+			}
+			else
+			{
+				printf("PARENT %s OF %s HAS TO COME BEFORE IT IN THE MANIFEST \n", GO->GetParentName().c_str(), GO->GetName().c_str());
+			}
+		}
+
+		ExampleGO* example = dynamic_cast<ExampleGO*>(GO);
+		if (example)
+		{
+			mask |= COMPONENT_BIT(COMP_RENDERABLE);
+		}
+
+		Entity entity = _world.Create(mask);
+		_world.Get<PositionComponent>(entity)->m_pos = scratch.GetPos(id);
+		_world.Get<RotationComponent>(entity)->m_rot = scratch.GetRot(id);
+		_world.Get<ScaleComponent>(entity)->m_scale = scratch.GetScale(id);
+		if (mask & COMPONENT_BIT(COMP_SPIN))
+		{
+			_world.Get<SpinComponent>(entity)->m_rotInc = scratch.GetRotIncr(id);
+		}
+		if (parent != INVALID_ENTITY)
+		{
+			SetParent(_world, entity, parent);
+		}
+		if (example)
+		{
+			RenderableComponent* renderable = _world.Get<RenderableComponent>(entity);
+			renderable->m_model = _world.m_models.Find(example->GetModelName());
+			renderable->m_texture = _world.m_textures.Find(example->GetTextureName());
+			renderable->m_shader = _world.m_shaders.Find(example->GetShaderName());
+			renderable->m_RP = GO->GetRP();
+		}
+
+		entities[GO->GetName()] = entity;
+
+		_file.ignore(256, '\n');
+	}
+}
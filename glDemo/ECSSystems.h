@@ -0,0 +1,37 @@
+#pragma once
+#include "ECS.h"
+#include "InstanceData.h"
+#include <fstream>
+
+//the systems that run over a World, each one a loop over the chunks that have the components it needs
+//these do what Scene::Update and Scene::BuildSnapshot do for GameObjects, without a virtual call or pointer chase per object
+class ECSSystems
+{
+public:
+
+	//add every spinning entity's rotation increment to its rotation, once per update like TransformStore does
+	static void Spin(World& _world);
+
+	//build world and normal matrices for everything with a transform, parents before their children
+	//children go a level of depth at a time, as the TransformStore orders them, since the chunks hold them in no particular order
+	//unlike the TransformStore nothing is tracked as dirty, every matrix is rebuilt every time
+	static void Transforms(World& _world);
+
+	//make _child's transform relative to _parent, _child needs a ParentComponent
+	//parents can be set in any order, the depths below _child are worked out again by the next Transforms
+	static void SetParent(World& _world, Entity _child, Entity _parent);
+
+	//sort key and matrices of every renderable entity in the opaque pass
+	//keyed the same way as the Scene's opaque queue, _keys[i] goes with _instances[i]
+	static void RenderPrep(World& _world, const mat4& _view, float _farPlane, vector<uint64_t>& _keys, vector<InstanceData>& _instances);
+
+	//every light, packed up for the light buffer
+	static void GatherLights(World& _world, vector<LightData>& _out);
+
+	//load the lights and GameObjects out of a manifest (in the same format Scene::Load reads) as entities
+	//cameras are skipped, models, textures and shaders only have their names interned so renderables can refer to them
+	static void LoadManifest(World& _world, ifstream& _file);
+
+	//the components an entity loaded from a GameObject gets
+	static const ComponentMask TRANSFORM_MASK = COMPONENT_BIT(COMP_POSITION) | COMPONENT_BIT(COMP_ROTATION) | COMPONENT_BIT(COMP_SCALE) | COMPONENT_BIT(COMP_WORLD) | COMPONENT_BIT(COMP_NORMAL);
+};
@@ -4,6 +4,8 @@
 #include "Scene.h"
 #include "Shader.h"
 #include "Texture.h"
+#include "GLState.h"
+#include "SceneArena.h"
 
 ExampleGO::ExampleGO()
 {
@@ -31,12 +33,16 @@ void ExampleGO::PreRender()
 {
 	GameObject::PreRender();
 
-	//only thing I need to do is tell the shader about my texture
+	SetupMaterial();
+}
 
-	glEnable(GL_TEXTURE_2D);
+void ExampleGO::SetupMaterial()
+{
+	//only thing I need to do is tell the shader about my texture
 
-	glActiveTexture(GL_TEXTURE0);
-	glBindTexture(GL_TEXTURE_2D, m_texture);
+	//GLState drops these if the last object already set them up the same way
+	GLState::Enable(GL_TEXTURE_2D);
+	GLState::BindTexture(0, m_texture);
 
 	//TODO: this does sort of replicate stuff in the AIMesh class, could we make them more compatible.
 
@@ -48,9 +54,34 @@ void ExampleGO::Render()
 	m_model->Render();
 }
 
+GameObject* ExampleGO::Clone(SceneArena& _arena)
+{
+	return _arena.New<ExampleGO>(*this);
+}
+
+const MeshRange* ExampleGO::GetMeshRange()
+{
+	return m_model ? m_model->GetMeshRange() : nullptr;
+}
+
+const Bounds* ExampleGO::GetLocalBounds()
+{
+	return m_model ? &m_model->GetBounds() : nullptr;
+}
+
 void ExampleGO::Init(Scene* _scene)
 {
 	m_ShaderProg = _scene->GetShader(m_ShaderName)->GetProg();
 	m_texture = _scene->GetTexture(m_TexName)->GetTexID();
 	m_model = _scene->GetModel(m_ModelName);
+
+	//only worth having if both my shader and my model have an instanced version
+	if (m_model && m_model->GetMeshRange())
+	{
+		m_instancedProg = _scene->GetShader(m_ShaderName)->GetInstancedProg();
+	}
+
+	m_shaderHandle = _scene->FindShader(m_ShaderName);
+	m_textureHandle = _scene->FindTexture(m_TexName);
+	m_modelHandle = _scene->FindModel(m_ModelName);
 }
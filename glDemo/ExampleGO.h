@@ -22,13 +22,27 @@ public:
 	virtual void PreRender();
 	virtual void Render();
 
+	virtual GLuint GetInstancedShaderProg() { return m_instancedProg; }
+	virtual void SetupMaterial();
+	virtual const MeshRange* GetMeshRange();
+
+	virtual GameObject* Clone(SceneArena& _arena);
+
 	virtual void Init(Scene* _scene);
 
+	virtual const Bounds* GetLocalBounds();
+
+	//names of what I'm drawn with, as given in the manifest
+	const string& GetModelName() const { return m_ModelName; }
+	const string& GetTextureName() const { return m_TexName; }
+	const string& GetShaderName() const { return m_ShaderName; }
+
 protected:
 
 	string m_ShaderName, m_TexName, m_ModelName;
 
 	GLuint m_texture;
-	Model* m_model;
+	GLuint m_instancedProg = 0;
+	Model* m_model = nullptr;
 };
 
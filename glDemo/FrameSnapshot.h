@@ -0,0 +1,44 @@
+#pragma once
+#include "core.h"
+#include <vector>
+#include "InstanceData.h"
+#include "LightBuffer.h"
+#include "SceneStats.h"
+
+using namespace std;
+using namespace glm;
+
+class GameObject;
+
+//something to draw and where it was when the snapshot was taken
+struct SnapshotItem
+{
+	GameObject* m_GO;
+	InstanceData m_transform;
+};
+
+//everything needed to draw one frame of a Scene, filled in by Scene::BuildSnapshot and drawn by Scene::RenderSnapshot
+//anything the simulation changes is copied in, so it can be drawn on another thread while the next frame is being updated
+//the GameObjects themselves are only asked what they are drawn with (shader, texture, model), none of which changes once they are initialised
+struct FrameSnapshot
+{
+	//the camera
+	mat4 m_view;
+	mat4 m_proj;
+	vec3 m_camPos;
+
+	//size of the window's framebuffer, the viewport is set to match when it changes (0 leaves it alone)
+	int m_width = 0;
+	int m_height = 0;
+
+	//opaque objects in draw order, then see-through ones back to front
+	vector<SnapshotItem> m_opaque;
+	vector<SnapshotItem> m_transparent;
+
+	//every light, only recopied when the Scene's lights have changed since this snapshot last had them
+	vector<LightData> m_lights;
+	unsigned int m_lightsVersion = 0;
+
+	//what the Scene did building this snapshot, RenderSnapshot adds what it did drawing it
+	SceneStats m_stats;
+};
@@ -0,0 +1,164 @@
+#include "FrameUniforms.h"
+#include <string.h>
+#include "GLState.h"
+
+//room for this many object blocks a frame to start with, the ring doubles whenever a frame needs more
+static const size_t INITIAL_BLOCKS = 1024;
+
+GLuint FrameUniforms::s_buffer = 0;
+unsigned char* FrameUniforms::s_mapped = nullptr;
+size_t FrameUniforms::s_alignment = 256;
+size_t FrameUniforms::s_frameBytes = 0;
+int FrameUniforms::s_frame = 0;
+size_t FrameUniforms::s_offset = 0;
+size_t FrameUniforms::s_end = 0;
+GLsync FrameUniforms::s_fences[FrameUniforms::FRAMES_IN_FLIGHT] = {};
+CameraBlock FrameUniforms::s_camera;
+int FrameUniforms::s_blocksWritten = 0;
+
+void FrameUniforms::Create(size_t _frameBytes)
+{
+	GLint alignment = 0;
+	glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &alignment);
+	s_alignment = alignment > 0 ? (size_t)alignment : 256;
+	s_frameBytes = Aligned(_frameBytes);
+
+	//mapped once for good, coherent so what we memcpy in is visible without any flushing
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &s_buffer);
+	GLState::BindBuffer(GL_UNIFORM_BUFFER, s_buffer);
+	glBufferStorage(GL_UNIFORM_BUFFER, s_frameBytes * FRAMES_IN_FLIGHT, nullptr, flags);
+	s_mapped = (unsigned char*)glMapBufferRange(GL_UNIFORM_BUFFER, 0, s_frameBytes * FRAMES_IN_FLIGHT, flags);
+
+	for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+	{
+		s_fences[i] = 0;
+	}
+	s_frame = 0;
+	s_offset = 0;
+	s_end = s_frameBytes;
+}
+
+void FrameUniforms::BeginFrame()
+{
+	if (!s_buffer)
+	{
+		Create(Aligned(sizeof(CameraBlock)) + INITIAL_BLOCKS * Aligned(sizeof(ObjectBlock)));
+	}
+
+	s_frame = (s_frame + 1) % FRAMES_IN_FLIGHT;
+
+	//the GPU may still be drawing with what we wrote here FRAMES_IN_FLIGHT frames ago
+	if (s_fences[s_frame])
+	{
+		while (glClientWaitSync(s_fences[s_frame], GL_SYNC_FLUSH_COMMANDS_BIT, 1000000) == GL_TIMEOUT_EXPIRED)
+		{
+		}
+		glDeleteSync(s_fences[s_frame]);
+		s_fences[s_frame] = 0;
+	}
+
+	s_offset = s_frame * s_frameBytes;
+	s_end = s_offset + s_frameBytes;
+	s_blocksWritten = 0;
+}
+
+void FrameUniforms::EndFrame()
+{
+	if (s_buffer)
+	{
+		s_fences[s_frame] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	}
+}
+
+void FrameUniforms::MakeRoom(size_t _bytes, GLuint _binding)
+{
+	if (s_offset + _bytes > s_end)
+	{
+		//out of room this frame, swap in a ring at least twice the size
+		//GL keeps the old buffer alive until the draws already using it are done
+		//but deleting it unbinds it, so the camera block has to go into the new one too
+		size_t frameBytes = s_frameBytes * 2;
+		while (frameBytes < Aligned(sizeof(CameraBlock)) + _bytes)
+		{
+			frameBytes *= 2;
+		}
+		Release();
+		Create(frameBytes);
+		if (_binding != CAMERA_BLOCK_BINDING)
+		{
+			Write(CAMERA_BLOCK_BINDING, &s_camera, sizeof(CameraBlock));
+		}
+	}
+}
+
+void FrameUniforms::Write(GLuint _binding, const void* _data, size_t _size)
+{
+	MakeRoom(Aligned(_size), _binding);
+
+	memcpy(s_mapped + s_offset, _data, _size);
+	GLState::BindBufferRange(GL_UNIFORM_BUFFER, _binding, s_buffer, s_offset, _size);
+	s_offset += Aligned(_size);
+	s_blocksWritten++;
+}
+
+void FrameUniforms::SetCamera(const mat4& _view, const mat4& _proj, const vec3& _camPos)
+{
+	s_camera.m_view = _view;
+	s_camera.m_proj = _proj;
+	s_camera.m_camPos = vec4(_camPos, 1.0f);
+	Write(CAMERA_BLOCK_BINDING, &s_camera, sizeof(CameraBlock));
+}
+
+void FrameUniforms::SetObject(const mat4& _model, const mat3& _normal)
+{
+	size_t offset = ReserveObjects(1);
+	WriteObject(offset, _model, _normal);
+	BindObject(offset);
+}
+
+size_t FrameUniforms::ReserveObjects(size_t _count)
+{
+	MakeRoom(_count * ObjectStride(), OBJECT_BLOCK_BINDING);
+
+	size_t offset = s_offset;
+	s_offset += _count * ObjectStride();
+	s_blocksWritten += (int)_count;
+	return offset;
+}
+
+void FrameUniforms::WriteObject(size_t _offset, const mat4& _model, const mat3& _normal)
+{
+	ObjectBlock* block = (ObjectBlock*)(s_mapped + _offset);
+	block->m_model = _model;
+	for (int c = 0; c < 3; c++)
+	{
+		block->m_normal[c] = vec4(_normal[c], 0.0f);
+	}
+}
+
+void FrameUniforms::BindObject(size_t _offset)
+{
+	GLState::BindBufferRange(GL_UNIFORM_BUFFER, OBJECT_BLOCK_BINDING, s_buffer, _offset, sizeof(ObjectBlock));
+}
+
+void FrameUniforms::Release()
+{
+	if (s_buffer)
+	{
+		for (int i = 0; i < FRAMES_IN_FLIGHT; i++)
+		{
+			if (s_fences[i])
+			{
+				glDeleteSync(s_fences[i]);
+				s_fences[i] = 0;
+			}
+		}
+		GLState::BindBuffer(GL_UNIFORM_BUFFER, s_buffer);
+		glUnmapBuffer(GL_UNIFORM_BUFFER);
+		GLState::ForgetBuffer(s_buffer);
+		glDeleteBuffers(1, &s_buffer);
+		s_buffer = 0;
+		s_mapped = nullptr;
+	}
+}
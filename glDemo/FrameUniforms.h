@@ -0,0 +1,83 @@
+#pragma once
+#include "core.h"
+
+using namespace glm;
+
+//std140 uniform blocks shared by every shader, laid out to match the declarations in Assets/Shaders
+//the camera block is written once a frame, each object drawn on its own gets an object block
+//both come out of one persistently mapped ring buffer split into a section per frame in flight
+//a fence at the end of each frame stops us writing over a section until the GPU has finished reading it
+//so setting a block is a memcpy and one glBindBufferRange rather than a lookup and upload per uniform
+
+//binding points, see layout(std140, binding = N) in the shaders
+const GLuint CAMERA_BLOCK_BINDING = 0;
+const GLuint OBJECT_BLOCK_BINDING = 1;
+
+struct CameraBlock
+{
+	mat4 m_view;
+	mat4 m_proj;
+	vec4 m_camPos;		//w unused
+};
+
+struct ObjectBlock
+{
+	mat4 m_model;
+	vec4 m_normal[3];	//std140 pads each column of a mat3 out to a vec4
+};
+
+class FrameUniforms
+{
+public:
+
+	//move on to the next section of the ring, waiting for the GPU if it is still using it
+	static void BeginFrame();
+
+	//fence off this frame's section
+	static void EndFrame();
+
+	//write a block and bind it to its binding point for the draws that follow
+	static void SetCamera(const mat4& _view, const mat4& _proj, const vec3& _camPos);
+	static void SetObject(const mat4& _model, const mat3& _normal);
+
+	//room for _count object blocks in this frame's section, returns the offset of the first
+	//the rest follow every ObjectStride() bytes, GL thread only as it may have to grow the ring
+	static size_t ReserveObjects(size_t _count);
+	static size_t ObjectStride() { return Aligned(sizeof(ObjectBlock)); }
+
+	//fill in a reserved block, only a memcpy so any thread can do it
+	static void WriteObject(size_t _offset, const mat4& _model, const mat3& _normal);
+
+	//bind a block written with WriteObject for the draws that follow
+	static void BindObject(size_t _offset);
+
+	//how many blocks have been written since the last BeginFrame
+	static int GetBlocksWritten() { return s_blocksWritten; }
+
+	static void Release();
+
+protected:
+
+	//bytes of a frame's section a block of _size takes up, rounded up to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+	static size_t Aligned(size_t _size) { return (_size + s_alignment - 1) / s_alignment * s_alignment; }
+
+	static void Create(size_t _frameBytes);
+	static void Write(GLuint _binding, const void* _data, size_t _size);
+
+	//make sure there are _bytes free in this frame's section, growing the ring if not
+	//_binding is what they are for, so the camera block gets rewritten when it isn't the camera that needs the room
+	static void MakeRoom(size_t _bytes, GLuint _binding);
+
+	static const int FRAMES_IN_FLIGHT = 3;
+
+	static GLuint s_buffer;
+	static unsigned char* s_mapped;
+	static size_t s_alignment;
+	static size_t s_frameBytes;		//size of each frame's section
+	static int s_frame;				//which section we are writing to
+	static size_t s_offset;			//next free byte
+	static size_t s_end;			//end of this frame's section
+	static GLsync s_fences[FRAMES_IN_FLIGHT];
+	static CameraBlock s_camera;	//kept so it can be rewritten if the ring has to grow mid-frame
+	static int s_blocksWritten;
+};
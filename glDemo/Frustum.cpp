@@ -0,0 +1,182 @@
+#include "Frustum.h"
+#include "TransformKernels.h"
+#include "SimdTarget.h"
+#include <immintrin.h>
+
+void Frustum::Extract(const mat4& _viewProj)
+{
+	//glm matrices are column major so row i is (m[0][i], m[1][i], m[2][i], m[3][i])
+	vec4 row0 = vec4(_viewProj[0][0], _viewProj[1][0], _viewProj[2][0], _viewProj[3][0]);
+	vec4 row1 = vec4(_viewProj[0][1], _viewProj[1][1], _viewProj[2][1], _viewProj[3][1]);
+	vec4 row2 = vec4(_viewProj[0][2], _viewProj[1][2], _viewProj[2][2], _viewProj[3][2]);
+	vec4 row3 = vec4(_viewProj[0][3], _viewProj[1][3], _viewProj[2][3], _viewProj[3][3]);
+
+	//a point is inside when -w <= x, y, z <= w (Gribb & Hartmann)
+	m_planes[PLANE_LEFT] = row3 + row0;
+	m_planes[PLANE_RIGHT] = row3 - row0;
+	m_planes[PLANE_BOTTOM] = row3 + row1;
+	m_planes[PLANE_TOP] = row3 - row1;
+	m_planes[PLANE_NEAR] = row3 + row2;
+	m_planes[PLANE_FAR] = row3 - row2;
+
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		m_planes[i] /= glm::length(vec3(m_planes[i]));
+	}
+}
+
+bool Frustum::TestSphere(const vec3& _centre, float _radius) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		if (glm::dot(vec3(m_planes[i]), _centre) + m_planes[i].w < -_radius)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+bool Frustum::TestBox(const vec3& _centre, const vec3& _extent) const
+{
+	for (int i = 0; i < PLANE_COUNT; i++)
+	{
+		//how far the box reaches towards the plane normal
+		float reach = glm::dot(glm::abs(vec3(m_planes[i])), _extent);
+		if (glm::dot(vec3(m_planes[i]), _centre) + m_planes[i].w < -reach)
+		{
+			return false;
+		}
+	}
+	return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Batched tests, one object per lane
+// both the sphere and the box are tested against all six planes and the answers ANDed
+// which is less work than branching out early when we're doing four or eight at once
+/////////////////////////////////////////////////////////////////////////////////////
+
+static int CullScalar(const Frustum& _frustum, const WorldBounds& _b, size_t _first, size_t _count, uint8_t* _visible)
+{
+	int numVisible = 0;
+	for (size_t i = 0; i < _count; i++)
+	{
+		size_t id = _first + i;
+		bool in = _frustum.TestSphere(vec3(_b.m_sphereX[id], _b.m_sphereY[id], _b.m_sphereZ[id]), _b.m_radius[id])
+			&& _frustum.TestBox(vec3(_b.m_boxX[id], _b.m_boxY[id], _b.m_boxZ[id]), vec3(_b.m_extentX[id], _b.m_extentY[id], _b.m_extentZ[id]));
+		_visible[i] = in ? 1 : 0;
+		numVisible += _visible[i];
+	}
+	return numVisible;
+}
+
+SIMD_TARGET_SSE4 static int CullSSE4(const Frustum& _frustum, const WorldBounds& _b, size_t _first, size_t _count, uint8_t* _visible)
+{
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	int numVisible = 0;
+	size_t i = 0;
+	for (; i + 4 <= _count; i += 4)
+	{
+		size_t id = _first + i;
+		__m128 sx = _mm_loadu_ps(&_b.m_sphereX[id]);
+		__m128 sy = _mm_loadu_ps(&_b.m_sphereY[id]);
+		__m128 sz = _mm_loadu_ps(&_b.m_sphereZ[id]);
+		__m128 negR = _mm_xor_ps(_mm_loadu_ps(&_b.m_radius[id]), signMask);
+		__m128 bx = _mm_loadu_ps(&_b.m_boxX[id]);
+		__m128 by = _mm_loadu_ps(&_b.m_boxY[id]);
+		__m128 bz = _mm_loadu_ps(&_b.m_boxZ[id]);
+		__m128 ex = _mm_loadu_ps(&_b.m_extentX[id]);
+		__m128 ey = _mm_loadu_ps(&_b.m_extentY[id]);
+		__m128 ez = _mm_loadu_ps(&_b.m_extentZ[id]);
+
+		//lanes end up all ones if the object is outside any plane
+		__m128 outside = _mm_setzero_ps();
+		for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+		{
+			const vec4& plane = _frustum.GetPlane(p);
+			__m128 nx = _mm_set1_ps(plane.x);
+			__m128 ny = _mm_set1_ps(plane.y);
+			__m128 nz = _mm_set1_ps(plane.z);
+			__m128 d = _mm_set1_ps(plane.w);
+
+			__m128 sphereDist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, sx), _mm_mul_ps(ny, sy)), _mm_mul_ps(nz, sz)), d);
+			__m128 boxDist = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, bx), _mm_mul_ps(ny, by)), _mm_mul_ps(nz, bz)), d);
+			__m128 reach = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(fabsf(plane.x)), ex), _mm_mul_ps(_mm_set1_ps(fabsf(plane.y)), ey)), _mm_mul_ps(_mm_set1_ps(fabsf(plane.z)), ez));
+
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(sphereDist, negR));
+			outside = _mm_or_ps(outside, _mm_cmplt_ps(boxDist, _mm_xor_ps(reach, signMask)));
+		}
+
+		int mask = ~_mm_movemask_ps(outside) & 0xf;
+		for (int l = 0; l < 4; l++)
+		{
+			_visible[i + l] = (mask >> l) & 1;
+			numVisible += _visible[i + l];
+		}
+	}
+
+	return numVisible + CullScalar(_frustum, _b, _first + i, _count - i, _visible + i);
+}
+
+SIMD_TARGET_AVX2 static int CullAVX2(const Frustum& _frustum, const WorldBounds& _b, size_t _first, size_t _count, uint8_t* _visible)
+{
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+
+	int numVisible = 0;
+	size_t i = 0;
+	for (; i + 8 <= _count; i += 8)
+	{
+		size_t id = _first + i;
+		__m256 sx = _mm256_loadu_ps(&_b.m_sphereX[id]);
+		__m256 sy = _mm256_loadu_ps(&_b.m_sphereY[id]);
+		__m256 sz = _mm256_loadu_ps(&_b.m_sphereZ[id]);
+		__m256 negR = _mm256_xor_ps(_mm256_loadu_ps(&_b.m_radius[id]), signMask);
+		__m256 bx = _mm256_loadu_ps(&_b.m_boxX[id]);
+		__m256 by = _mm256_loadu_ps(&_b.m_boxY[id]);
+		__m256 bz = _mm256_loadu_ps(&_b.m_boxZ[id]);
+		__m256 ex = _mm256_loadu_ps(&_b.m_extentX[id]);
+		__m256 ey = _mm256_loadu_ps(&_b.m_extentY[id]);
+		__m256 ez = _mm256_loadu_ps(&_b.m_extentZ[id]);
+
+		__m256 outside = _mm256_setzero_ps();
+		for (int p = 0; p < Frustum::PLANE_COUNT; p++)
+		{
+			const vec4& plane = _frustum.GetPlane(p);
+			__m256 nx = _mm256_set1_ps(plane.x);
+			__m256 ny = _mm256_set1_ps(plane.y);
+			__m256 nz = _mm256_set1_ps(plane.z);
+			__m256 d = _mm256_set1_ps(plane.w);
+
+			__m256 sphereDist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, sx), _mm256_mul_ps(ny, sy)), _mm256_mul_ps(nz, sz)), d);
+			__m256 boxDist = _mm256_add_ps(_mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(nx, bx), _mm256_mul_ps(ny, by)), _mm256_mul_ps(nz, bz)), d);
+			__m256 reach = _mm256_add_ps(_mm256_add_ps(_mm256_mul_ps(_mm256_set1_ps(fabsf(plane.x)), ex), _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.y)), ey)), _mm256_mul_ps(_mm256_set1_ps(fabsf(plane.z)), ez));
+
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(sphereDist, negR, _CMP_LT_OQ));
+			outside = _mm256_or_ps(outside, _mm256_cmp_ps(boxDist, _mm256_xor_ps(reach, signMask), _CMP_LT_OQ));
+		}
+
+		int mask = ~_mm256_movemask_ps(outside) & 0xff;
+		for (int l = 0; l < 8; l++)
+		{
+			_visible[i + l] = (mask >> l) & 1;
+			numVisible += _visible[i + l];
+		}
+	}
+
+	return numVisible + CullScalar(_frustum, _b, _first + i, _count - i, _visible + i);
+}
+
+int Frustum::Cull(const WorldBounds& _bounds, size_t _first, size_t _count, uint8_t* _visible) const
+{
+	switch (TransformKernels::GetPath())
+	{
+	case TransformKernels::PATH_AVX2:
+		return CullAVX2(*this, _bounds, _first, _count, _visible);
+	case TransformKernels::PATH_SSE4:
+		return CullSSE4(*this, _bounds, _first, _count, _visible);
+	default:
+		return CullScalar(*this, _bounds, _first, _count, _visible);
+	}
+}
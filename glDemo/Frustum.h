@@ -0,0 +1,42 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include "Bounds.h"
+
+using namespace glm;
+
+//the six planes of a camera's view volume, pulled straight out of its projection * view matrix
+//used to throw away objects that can't possibly be on screen before we bother drawing them
+class Frustum
+{
+public:
+
+	enum Plane
+	{
+		PLANE_LEFT = 0,
+		PLANE_RIGHT,
+		PLANE_BOTTOM,
+		PLANE_TOP,
+		PLANE_NEAR,
+		PLANE_FAR,
+		PLANE_COUNT
+	};
+
+	//work out the planes for this projection * view matrix (OpenGL -1 to 1 clip space)
+	//each plane is (normal, d) with the normal pointing into the frustum and normalised
+	void Extract(const mat4& _viewProj);
+
+	const vec4& GetPlane(int _plane) const { return m_planes[_plane]; }
+
+	//single object tests, true if any of it might be inside
+	bool TestSphere(const vec3& _centre, float _radius) const;
+	bool TestBox(const vec3& _centre, const vec3& _extent) const;
+
+	//test _count objects starting at _first, sphere first and then box
+	//_visible[i] is set to 1 if object _first + i might be on screen, 0 if not, returns how many are visible
+	//uses SSE4 or AVX2 when TransformKernels says the CPU has them
+	int Cull(const WorldBounds& _bounds, size_t _first, size_t _count, uint8_t* _visible) const;
+
+protected:
+	vec4 m_planes[PLANE_COUNT];
+};
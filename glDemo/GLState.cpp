@@ -0,0 +1,312 @@
+#include "GLState.h"
+
+GLuint GLState::s_program = GLState::UNKNOWN;
+GLuint GLState::s_vao = GLState::UNKNOWN;
+GLuint GLState::s_activeUnit = GLState::UNKNOWN;
+GLuint GLState::s_textures[GLState::MAX_TEXTURE_UNITS];
+int GLState::s_enabled[4];
+int GLState::s_depthMask = -1;
+GLenum GLState::s_blendSrc = GLState::UNKNOWN;
+GLenum GLState::s_blendDst = GLState::UNKNOWN;
+GLenum GLState::s_cullFace = GLState::UNKNOWN;
+GLuint GLState::s_buffers[4];
+GLState::IndexedBinding GLState::s_uniformBindings[GLState::MAX_BUFFER_INDICES];
+GLState::IndexedBinding GLState::s_storageBindings[GLState::MAX_BUFFER_INDICES];
+unsigned int GLState::s_issued = 0;
+unsigned int GLState::s_elided = 0;
+
+//the static arrays start out as zeroes which looks like a real binding, so mark them unknown before first use
+static bool s_initialised = false;
+
+static inline void CheckInitialised()
+{
+	if (!s_initialised)
+	{
+		GLState::Invalidate();
+	}
+}
+
+void GLState::Invalidate()
+{
+	s_initialised = true;
+
+	s_program = UNKNOWN;
+	s_vao = UNKNOWN;
+	s_activeUnit = UNKNOWN;
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		s_textures[i] = UNKNOWN;
+	}
+	for (int i = 0; i < 4; i++)
+	{
+		s_enabled[i] = -1;
+		s_buffers[i] = UNKNOWN;
+	}
+	s_depthMask = -1;
+	s_blendSrc = s_blendDst = UNKNOWN;
+	s_cullFace = UNKNOWN;
+	for (int i = 0; i < MAX_BUFFER_INDICES; i++)
+	{
+		s_uniformBindings[i].m_buffer = UNKNOWN;
+		s_storageBindings[i].m_buffer = UNKNOWN;
+	}
+}
+
+void GLState::UseProgram(GLuint _prog)
+{
+	CheckInitialised();
+	if (Changed(s_program, _prog))
+	{
+		glUseProgram(_prog);
+	}
+}
+
+void GLState::BindVertexArray(GLuint _vao)
+{
+	CheckInitialised();
+	if (Changed(s_vao, _vao))
+	{
+		glBindVertexArray(_vao);
+	}
+}
+
+void GLState::ActiveTexture(GLuint _unit)
+{
+	CheckInitialised();
+	if (Changed(s_activeUnit, _unit))
+	{
+		glActiveTexture(GL_TEXTURE0 + _unit);
+	}
+}
+
+void GLState::BindTexture(GLuint _tex)
+{
+	CheckInitialised();
+	if (s_activeUnit >= (GLuint)MAX_TEXTURE_UNITS)
+	{
+		//don't know which unit is active, so nothing to compare against
+		glBindTexture(GL_TEXTURE_2D, _tex);
+		s_issued++;
+		return;
+	}
+	if (Changed(s_textures[s_activeUnit], _tex))
+	{
+		glBindTexture(GL_TEXTURE_2D, _tex);
+	}
+}
+
+void GLState::BindTexture(GLuint _unit, GLuint _tex)
+{
+	CheckInitialised();
+	if (_unit < (GLuint)MAX_TEXTURE_UNITS && s_textures[_unit] == _tex)
+	{
+		s_elided++;
+		return;
+	}
+	ActiveTexture(_unit);
+	BindTexture(_tex);
+}
+
+int GLState::CapIndex(GLenum _cap)
+{
+	switch (_cap)
+	{
+	case GL_BLEND: return 0;
+	case GL_DEPTH_TEST: return 1;
+	case GL_CULL_FACE: return 2;
+	case GL_TEXTURE_2D: return 3;
+	default: return -1;
+	}
+}
+
+void GLState::SetEnabled(GLenum _cap, bool _enabled)
+{
+	CheckInitialised();
+	int index = CapIndex(_cap);
+	if (index < 0)
+	{
+		s_issued++;
+	}
+	else if (!Changed(s_enabled[index], _enabled ? 1 : 0))
+	{
+		return;
+	}
+
+	if (_enabled)
+	{
+		glEnable(_cap);
+	}
+	else
+	{
+		glDisable(_cap);
+	}
+}
+
+void GLState::DepthMask(bool _write)
+{
+	CheckInitialised();
+	if (Changed(s_depthMask, _write ? 1 : 0))
+	{
+		glDepthMask(_write ? GL_TRUE : GL_FALSE);
+	}
+}
+
+void GLState::BlendFunc(GLenum _src, GLenum _dst)
+{
+	CheckInitialised();
+	if (s_blendSrc == _src && s_blendDst == _dst)
+	{
+		s_elided++;
+		return;
+	}
+	s_blendSrc = _src;
+	s_blendDst = _dst;
+	s_issued++;
+	glBlendFunc(_src, _dst);
+}
+
+void GLState::CullFace(GLenum _face)
+{
+	CheckInitialised();
+	if (Changed(s_cullFace, _face))
+	{
+		glCullFace(_face);
+	}
+}
+
+int GLState::BufferIndex(GLenum _target)
+{
+	switch (_target)
+	{
+	case GL_ARRAY_BUFFER: return 0;
+	case GL_DRAW_INDIRECT_BUFFER: return 1;
+	case GL_UNIFORM_BUFFER: return 2;
+	case GL_SHADER_STORAGE_BUFFER: return 3;
+	default: return -1;
+	}
+}
+
+void GLState::BindBuffer(GLenum _target, GLuint _buffer)
+{
+	CheckInitialised();
+	int index = BufferIndex(_target);
+	if (index < 0)
+	{
+		s_issued++;
+		glBindBuffer(_target, _buffer);
+	}
+	else if (Changed(s_buffers[index], _buffer))
+	{
+		glBindBuffer(_target, _buffer);
+	}
+}
+
+GLState::IndexedBinding* GLState::Indexed(GLenum _target, GLuint _index)
+{
+	if (_index >= (GLuint)MAX_BUFFER_INDICES)
+	{
+		return nullptr;
+	}
+	if (_target == GL_UNIFORM_BUFFER)
+	{
+		return &s_uniformBindings[_index];
+	}
+	if (_target == GL_SHADER_STORAGE_BUFFER)
+	{
+		return &s_storageBindings[_index];
+	}
+	return nullptr;
+}
+
+void GLState::BindBufferBase(GLenum _target, GLuint _index, GLuint _buffer)
+{
+	BindBufferRange(_target, _index, _buffer, 0, 0);
+}
+
+void GLState::BindBufferRange(GLenum _target, GLuint _index, GLuint _buffer, GLintptr _offset, GLsizeiptr _size)
+{
+	CheckInitialised();
+	IndexedBinding* binding = Indexed(_target, _index);
+	if (binding && binding->m_buffer == _buffer && binding->m_offset == _offset && binding->m_size == _size)
+	{
+		s_elided++;
+		return;
+	}
+
+	if (_size == 0)
+	{
+		glBindBufferBase(_target, _index, _buffer);
+	}
+	else
+	{
+		glBindBufferRange(_target, _index, _buffer, _offset, _size);
+	}
+	s_issued++;
+
+	if (binding)
+	{
+		binding->m_buffer = _buffer;
+		binding->m_offset = _offset;
+		binding->m_size = _size;
+	}
+
+	//the indexed bind functions bind the general target as well
+	int index = BufferIndex(_target);
+	if (index >= 0)
+	{
+		s_buffers[index] = _buffer;
+	}
+}
+
+void GLState::ForgetBuffer(GLuint _buffer)
+{
+	CheckInitialised();
+	for (int i = 0; i < 4; i++)
+	{
+		if (s_buffers[i] == _buffer)
+		{
+			s_buffers[i] = UNKNOWN;
+		}
+	}
+	for (int i = 0; i < MAX_BUFFER_INDICES; i++)
+	{
+		if (s_uniformBindings[i].m_buffer == _buffer)
+		{
+			s_uniformBindings[i].m_buffer = UNKNOWN;
+		}
+		if (s_storageBindings[i].m_buffer == _buffer)
+		{
+			s_storageBindings[i].m_buffer = UNKNOWN;
+		}
+	}
+}
+
+void GLState::ForgetVertexArray(GLuint _vao)
+{
+	CheckInitialised();
+	if (s_vao == _vao)
+	{
+		s_vao = UNKNOWN;
+	}
+}
+
+void GLState::ForgetTexture(GLuint _tex)
+{
+	CheckInitialised();
+	for (int i = 0; i < MAX_TEXTURE_UNITS; i++)
+	{
+		if (s_textures[i] == _tex)
+		{
+			s_textures[i] = UNKNOWN;
+		}
+	}
+}
+
+void GLState::ForgetProgram(GLuint _prog)
+{
+	CheckInitialised();
+	if (s_program == _prog)
+	{
+		s_program = UNKNOWN;
+	}
+}
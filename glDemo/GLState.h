@@ -0,0 +1,94 @@
+#pragma once
+#include "core.h"
+
+//thin shadow of the GL state the render paths keep changing
+//every call goes through here and is dropped if GL is already in that state
+//anything that changes this state must come through here too (or call Invalidate) or the shadow goes stale
+//element array buffer bindings belong to the bound VAO so they are passed straight through
+class GLState
+{
+public:
+
+	static void UseProgram(GLuint _prog);
+	static void BindVertexArray(GLuint _vao);
+
+	//2D textures, per texture unit (0, 1, ... rather than GL_TEXTURE0 ...)
+	static void ActiveTexture(GLuint _unit);
+	static void BindTexture(GLuint _tex);	//on the active unit
+	static void BindTexture(GLuint _unit, GLuint _tex);
+
+	//GL_BLEND, GL_DEPTH_TEST, GL_CULL_FACE and GL_TEXTURE_2D, anything else goes straight to GL
+	static void SetEnabled(GLenum _cap, bool _enabled);
+	static void Enable(GLenum _cap) { SetEnabled(_cap, true); }
+	static void Disable(GLenum _cap) { SetEnabled(_cap, false); }
+
+	static void DepthMask(bool _write);
+	static void BlendFunc(GLenum _src, GLenum _dst);
+	static void CullFace(GLenum _face);
+
+	//GL_ARRAY_BUFFER, GL_DRAW_INDIRECT_BUFFER, GL_UNIFORM_BUFFER and GL_SHADER_STORAGE_BUFFER
+	static void BindBuffer(GLenum _target, GLuint _buffer);
+	//indexed uniform / shader storage bindings
+	static void BindBufferBase(GLenum _target, GLuint _index, GLuint _buffer);
+	static void BindBufferRange(GLenum _target, GLuint _index, GLuint _buffer, GLintptr _offset, GLsizeiptr _size);
+
+	//deleting an object unbinds it everywhere, so the shadow mustn't think it is still bound
+	static void ForgetBuffer(GLuint _buffer);
+	static void ForgetVertexArray(GLuint _vao);
+	static void ForgetTexture(GLuint _tex);
+	static void ForgetProgram(GLuint _prog);
+
+	//forget everything, the next call of each kind always goes to GL
+	static void Invalidate();
+
+	//running totals of calls passed on to GL / dropped as redundant
+	static unsigned int GetIssued() { return s_issued; }
+	static unsigned int GetElided() { return s_elided; }
+
+protected:
+
+	static const int MAX_TEXTURE_UNITS = 16;
+	static const int MAX_BUFFER_INDICES = 16;
+	static const GLuint UNKNOWN = 0xffffffff;
+
+	struct IndexedBinding
+	{
+		GLuint m_buffer;
+		GLintptr m_offset;
+		GLsizeiptr m_size;	//0 for glBindBufferBase
+	};
+
+	//false and counts it as elided if _shadow already holds _value, otherwise updates it
+	template<class T>
+	static bool Changed(T& _shadow, T _value)
+	{
+		if (_shadow == _value)
+		{
+			s_elided++;
+			return false;
+		}
+		_shadow = _value;
+		s_issued++;
+		return true;
+	}
+
+	static int CapIndex(GLenum _cap);
+	static int BufferIndex(GLenum _target);
+	static IndexedBinding* Indexed(GLenum _target, GLuint _index);
+
+	static GLuint s_program;
+	static GLuint s_vao;
+	static GLuint s_activeUnit;
+	static GLuint s_textures[MAX_TEXTURE_UNITS];
+	static int s_enabled[4];		//-1 unknown
+	static int s_depthMask;			//-1 unknown
+	static GLenum s_blendSrc;
+	static GLenum s_blendDst;
+	static GLenum s_cullFace;
+	static GLuint s_buffers[4];
+	static IndexedBinding s_uniformBindings[MAX_BUFFER_INDICES];
+	static IndexedBinding s_storageBindings[MAX_BUFFER_INDICES];
+
+	static unsigned int s_issued;
+	static unsigned int s_elided;
+};
@@ -1,7 +1,9 @@
 #include "core.h"
 #include "GameObject.h"
 #include "stringHelp.h"
+#include "FrameUniforms.h"
 #include "helper.h"
+#include "SceneArena.h"
 
 using namespace glm;
 
@@ -16,31 +18,63 @@ GameObject::~GameObject()
 
 void GameObject::Load(ifstream& _file)
 {
+	//the Scene should have given me a slot in its TransformStore before loading me
+	assert(m_transforms);
+
+	vec3 pos, rot, scale, rot_incr;
+
 	StringHelp::String(_file, "NAME", m_name);
-	StringHelp::Float3(_file, "POS", m_pos.x, m_pos.y, m_pos.z);
-	StringHelp::Float3(_file, "ROT", m_rot.x, m_rot.y, m_rot.z);
-	StringHelp::Float3(_file, "SCALE", m_scale.x, m_scale.y, m_scale.z);
-	StringHelp::Float3(_file, "ROT INC", m_rot_incr.x, m_rot_incr.y, m_rot_incr.z);
+	StringHelp::Float3(_file, "POS", pos.x, pos.y, pos.z);
+	StringHelp::Float3(_file, "ROT", rot.x, rot.y, rot.z);
+	StringHelp::Float3(_file, "SCALE", scale.x, scale.y, scale.z);
+	StringHelp::Float3(_file, "ROT INC", rot_incr.x, rot_incr.y, rot_incr.z);
+	StringHelp::OptionalString(_file, "PARENT", m_parentName);
+
+	//which pass(es) to draw me in, opaque if not given
+	string pass;
+	if (StringHelp::OptionalString(_file, "RP", pass))
+	{
+		if (pass == "OPAQUE")
+		{
+			m_RP = RP_OPAQUE;
+		}
+		else if (pass == "TRANSPARENT")
+		{
+			m_RP = RP_TRANSPARENT;
+		}
+		else if (pass == "NONE")
+		{
+			m_RP = RP_NONE;
+		}
+		else
+		{
+			printf("UNKNOWN RENDER PASS: %s \n", pass.c_str());
+			assert(0);
+		}
+	}
+
+	m_transforms->SetPos(m_transform, pos);
+	m_transforms->SetRot(m_transform, rot);
+	m_transforms->SetScale(m_transform, scale);
+	m_transforms->SetRotIncr(m_transform, rot_incr);
 }
 
 void GameObject::Tick(float _dt)
 {
-	m_rot += m_rot_incr;
-
-	m_worldMatrix = glm::translate(mat4(1.0), vec3(m_pos));
-	m_worldMatrix = glm::rotate(m_worldMatrix, glm::radians(m_rot.x), glm::vec3(1.0f, 0.0f, 0.0f));
-	m_worldMatrix = glm::rotate(m_worldMatrix, glm::radians(m_rot.y), glm::vec3(0.0f, 1.0f, 0.0f));
-	m_worldMatrix = glm::rotate(m_worldMatrix, glm::radians(m_rot.z), glm::vec3(0.0f, 0.0f, 1.0f));
+	//spinning and building my world matrix is done for every object in one go by Scene::Update
+	//so nothing else to do here, but subclasses can add their own behaviour
+}
 
-	m_worldMatrix = glm::scale(m_worldMatrix, glm::vec3(m_scale));
+GameObject* GameObject::Clone(SceneArena& _arena)
+{
+	return _arena.New<GameObject>(*this);
 }
 
 void GameObject::PreRender()
 {
-	// Setup model transform
-	GLint pLocation;
-	Helper::SetUniformLocation(m_ShaderProg, "modelMatrix", &pLocation);
-	glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&m_worldMatrix);
+	// Setup model transform and its inverse-transpose for the normals (kept up to date by the TransformStore)
+	// as this frame's object uniform block
+	FrameUniforms::SetObject(GetWorldMatrix(), m_transforms->GetNormalMatrix(m_transform));
 }
 
 void GameObject::Render()
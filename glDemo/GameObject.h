@@ -3,9 +3,16 @@
 #include <stdio.h>
 #include <string>
 #include "RenderPass.h"
+#include "TransformStore.h"
+#include "NameRegistry.h"
+#include "MeshArena.h"
 
 using namespace std;
 class Scene;
+class Shader;
+class Texture;
+class Model;
+class SceneArena;
 
 using namespace glm;
 
@@ -23,9 +30,20 @@ public:
 	//TODO: possibly pass keyboard / mouse stuff down here for player controls?
 	virtual void Tick(float _dt);
 
+	//the Scene writes my matrices itself from its FrameSnapshot and then calls SetupMaterial and Render on the GL thread
+	//PreRender is only used for anything drawn outside the Scene
 	virtual void PreRender();//set up any shader values needed for this object
 	virtual void Render();//render this object
 
+	//instancing: the Scene draws everything sharing a shader and texture with a single multi draw out of the MeshArena
+	//0 (the default) means I can't be drawn like that, otherwise it's the instanced version of my shader
+	virtual GLuint GetInstancedShaderProg() { return 0; }
+	virtual void SetupMaterial() {};//shader values every copy of me shares (textures etc.) but not my matrices
+	virtual const MeshRange* GetMeshRange() { return nullptr; }//where what I draw is in the MeshArena
+
+	//a new GameObject set up just like me (out of _arena), it still needs its own name and transform
+	virtual GameObject* Clone(SceneArena& _arena);
+
 	//various getters and setters
 	void SetName(string _name) { m_name = _name; }
 	string GetName() { return m_name; }
@@ -37,20 +55,45 @@ public:
 	//this GameObject should be drawn in THIS render pass
 	RenderPass GetRP() { return m_RP; }
 
+	//what I'm drawn with, the Scene sorts draws by these so objects sharing them are drawn together
+	//invalid if I don't use one (or don't draw anything at all)
+	Handle<Shader> GetShaderHandle() { return m_shaderHandle; }
+	Handle<Texture> GetTextureHandle() { return m_textureHandle; }
+	Handle<Model> GetModelHandle() { return m_modelHandle; }
+
+	//model space bounds of whatever I draw, used for culling
+	//nullptr (the default) means I can't be culled
+	virtual const Bounds* GetLocalBounds() { return nullptr; }
+
+	//my transform lives in the Scene's TransformStore, this is where to find it
+	void SetTransform(TransformStore* _store, TransformID _id) { m_transforms = _store; m_transform = _id; }
+	TransformID GetTransformID() { return m_transform; }
+	const mat4& GetWorldMatrix() { return m_transforms->GetWorld(m_transform); }
+
+	//did my world matrix change in the last Scene::Update (because I, or anything I'm attached to, moved)
+	bool TransformChanged() { return m_transforms->WasUpdated(m_transform); }
+
+	//name of the GameObject I'm attached to from the manifest, the Scene hooks us up in Init
+	string GetParentName() { return m_parentName; }
+
 protected:
 
 	string m_name;
 	string m_type;
 
-	vec3		m_pos;
-	vec3		m_rot;
-	vec3		m_scale;
-	vec3		m_rot_incr;
+	//position, rotation, scale etc. are all held in here rather than by each object
+	TransformStore*	m_transforms = nullptr;
+	TransformID		m_transform = INVALID_TRANSFORM;
 
-	glm::mat4	m_worldMatrix;
+	//optional PARENT, my position, rotation and scale are then relative to it
+	string m_parentName;
 
 	GLuint m_ShaderProg;
 
+	Handle<Shader>	m_shaderHandle;
+	Handle<Texture>	m_textureHandle;
+	Handle<Model>	m_modelHandle;
+
 	RenderPass m_RP = RP_OPAQUE;
 };
 
@@ -1,20 +1,21 @@
 #include "GameObjectFactory.h"
 #include "GameObject.h"
 #include "ExampleGO.h"
+#include "SceneArena.h"
 #include <assert.h>
 
 using std::string;
 
-GameObject* GameObjectFactory::makeNewGO(string _type)
+GameObject* GameObjectFactory::makeNewGO(string _type, SceneArena& _arena)
 {
 	printf("GAME OBJECT TYPE: %s \n", _type.c_str());
 	if (_type == "GAME_OBJECT")
 	{
-		return new GameObject();
+		return _arena.New<GameObject>();
 	}
 	else if (_type == "EXAMPLE")
 	{
-		return new ExampleGO();
+		return _arena.New<ExampleGO>();
 	}
 	else
 	{
@@ -1,12 +1,13 @@
 #pragma once
 #include <string>
 class GameObject;
+class SceneArena;
 //HACK A rather simple Factory using the base class GameObject
-//generates a GameObject based on its type
+//generates a GameObject based on its type, allocated out of _arena
 class GameObjectFactory
 {
 public:
 
-	static GameObject* makeNewGO(std::string _type);
+	static GameObject* makeNewGO(std::string _type, SceneArena& _arena);
 };
 
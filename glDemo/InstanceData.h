@@ -0,0 +1,17 @@
+#pragma once
+#include "core.h"
+
+using namespace glm;
+
+//what the instanced shaders get for each copy of an object, see texture-directional-instanced.vert
+//the Scene packs one of these per instance into its instance buffer every frame
+struct InstanceData
+{
+	mat4 m_model;
+	mat3 m_normal;
+};
+
+//vertex attribute locations the per instance values are fed into
+//a mat4 takes four locations and a mat3 three, so these use 6 to 12 (the mesh itself uses 0 to 5)
+const GLuint INSTANCE_MODEL_ATTRIB = 6;
+const GLuint INSTANCE_NORMAL_ATTRIB = 10;
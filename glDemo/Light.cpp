@@ -18,7 +18,8 @@ void Light::Load(ifstream& _file)
 	StringHelp::Float3(_file, "POS", m_pos.x, m_pos.y, m_pos.z);
 	StringHelp::Float3(_file, "COL", m_col.x, m_col.y, m_col.z);
 	StringHelp::Float3(_file, "AMB", m_amb.x, m_amb.y, m_amb.z);
-
+	StringHelp::OptionalFloat(_file, "RANGE", m_range);
+	m_version++;
 }
 
 /////////////////////////////////////////////////////////////////////////////////////
@@ -28,21 +29,11 @@ void Light::Tick(float _dt)
 {
 }
 
-//send values to the shaders to allow the use of this light
-// <m_name>Pos <m_name>Col <m_name>Amb
-void Light::SetRenderValues(unsigned int _prog)
+//pack me up for the shaders' light buffer
+void Light::GetLightData(LightData& _out)
 {
-	GLint loc;
-	string posString = m_name + "Pos";
-	string colString = m_name + "Col";
-	string ambString = m_name + "Amb";
-
-	if (Helper::SetUniformLocation(_prog, posString.c_str(), &loc))
-		glUniform3fv(loc, 1, glm::value_ptr(GetPos()));
-
-	if (Helper::SetUniformLocation(_prog, colString.c_str(), &loc))
-		glUniform3fv(loc, 1, glm::value_ptr(GetCol()));
-
-	if (Helper::SetUniformLocation(_prog, ambString.c_str(), &loc))
-		glUniform3fv(loc, 1, glm::value_ptr(GetAmb()));
+	_out.m_posType = vec4(m_pos, (float)LIGHT_POINT);
+	_out.m_dirRange = vec4(0.0f, 0.0f, 0.0f, m_range);
+	_out.m_col = vec4(m_col, 1.0f);
+	_out.m_amb = vec4(m_amb, 1.0f);
 }
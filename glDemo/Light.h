@@ -11,12 +11,14 @@ using namespace glm;
 
 using namespace std;
 
+#include "LightBuffer.h"
+
 //base class for a light
 class Light
 {
 public:
 	Light();
-	~Light() {}
+	virtual ~Light() {}
 
 	//load from mainfest
 	virtual void Load(ifstream& _file);
@@ -33,12 +35,19 @@ public:
 	vec3 GetCol() { return m_col; }
 	vec3 GetAmb() { return m_amb; }
 	vec3 GetPos() { return m_pos; }
+	float GetRange() { return m_range; }
+
+	void SetPos(vec3 _pos) { m_pos = _pos; m_version++; }
+	void SetCol(vec3 _col) { m_col = _col; m_version++; }
+	void SetAmb(vec3 _amb) { m_amb = _amb; m_version++; }
+	void SetRange(float _range) { m_range = _range; m_version++; }
 
-	//set my shader values
-	//base version: if name of light is LG
-	//sets up shader values for LGpos LGcol & LGamb
-	//position, main colour and ambient colour for this light
-	virtual void SetRenderValues(unsigned int _prog);
+	//goes up whenever any of my values change, so the Scene knows when shaders need telling again
+	unsigned int GetVersion() { return m_version; }
+
+	//what the shaders get for me in the Scene's LightBuffer
+	//base version is a point light: position, main colour and ambient colour, fading out to nothing at m_range
+	virtual void GetLightData(LightData& _out);
 
 protected:
 	string m_name;
@@ -47,5 +56,8 @@ protected:
 	vec3 m_pos; // position of the light
 	vec3 m_col; // colour of the light
 	vec3 m_amb; // ambient colour of the light
+	float m_range = 10.0f; // optional RANGE, point lights don't reach any further than this
+
+	unsigned int m_version = 0;
 
 };
\ No newline at end of file
@@ -0,0 +1,208 @@
+#include "LightBuffer.h"
+#include "GLState.h"
+#include <float.h>
+#include <algorithm>
+
+using namespace std;
+
+//the light count goes in a uvec4 before the array, keeping the array 16 byte aligned
+static const size_t HEADER_BYTES = 4 * sizeof(GLuint);
+
+LightBuffer::LightBuffer()
+{
+}
+
+LightBuffer::~LightBuffer()
+{
+	if (m_buffer)
+	{
+		GLState::ForgetBuffer(m_buffer);
+		glDeleteBuffers(1, &m_buffer);
+	}
+	if (m_gridBuffer)
+	{
+		GLState::ForgetBuffer(m_gridBuffer);
+		glDeleteBuffers(1, &m_gridBuffer);
+	}
+}
+
+void LightBuffer::Upload(const vector<LightData>& _lights)
+{
+	if (!m_buffer)
+	{
+		glGenBuffers(1, &m_buffer);
+	}
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_buffer);
+
+	//only reallocate when it has to grow, otherwise just overwrite
+	size_t bytes = HEADER_BYTES + _lights.size() * sizeof(LightData);
+	if (bytes > m_capacity)
+	{
+		m_capacity = bytes;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_capacity, nullptr, GL_DYNAMIC_DRAW);
+	}
+
+	GLuint header[4] = { (GLuint)_lights.size(), 0, 0, 0 };
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, HEADER_BYTES, header);
+	if (!_lights.empty())
+	{
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, HEADER_BYTES, _lights.size() * sizeof(LightData), _lights.data());
+	}
+
+	m_numLights = (int)_lights.size();
+
+	//and the grid, header then data in one go
+	m_grid.Build(_lights);
+	if (!m_gridBuffer)
+	{
+		glGenBuffers(1, &m_gridBuffer);
+	}
+	GLState::BindBuffer(GL_SHADER_STORAGE_BUFFER, m_gridBuffer);
+	size_t gridHeader = sizeof(m_grid.m_min) + sizeof(m_grid.m_dims);
+	size_t gridBytes = gridHeader + m_grid.m_data.size() * sizeof(GLuint);
+	if (gridBytes > m_gridCapacity)
+	{
+		m_gridCapacity = gridBytes;
+		glBufferData(GL_SHADER_STORAGE_BUFFER, m_gridCapacity, nullptr, GL_DYNAMIC_DRAW);
+	}
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, sizeof(m_grid.m_min), &m_grid.m_min);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, sizeof(m_grid.m_min), sizeof(m_grid.m_dims), &m_grid.m_dims);
+	glBufferSubData(GL_SHADER_STORAGE_BUFFER, gridHeader, m_grid.m_data.size() * sizeof(GLuint), m_grid.m_data.data());
+}
+
+void LightBuffer::Bind()
+{
+	if (m_buffer)
+	{
+		GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_BUFFER_BINDING, m_buffer);
+		GLState::BindBufferBase(GL_SHADER_STORAGE_BUFFER, LIGHT_GRID_BINDING, m_gridBuffer);
+	}
+}
+
+void LightGrid::Build(const vector<LightData>& _lights)
+{
+	//the box around every point light's range, and how big they are on average
+	vec3 lo(FLT_MAX);
+	vec3 hi(-FLT_MAX);
+	float totalRange = 0.0f;
+	int numPoint = 0;
+	for (const LightData& light : _lights)
+	{
+		if (light.m_posType.w == (float)LIGHT_POINT)
+		{
+			vec3 pos = vec3(light.m_posType);
+			float range = light.m_dirRange.w;
+			lo = min(lo, pos - vec3(range));
+			hi = max(hi, pos + vec3(range));
+			totalRange += range;
+			numPoint++;
+		}
+	}
+
+	m_dims = uvec4(0);
+	m_min = vec4(0.0f);
+	if (numPoint)
+	{
+		//small enough that a cell only holds lights nearly reaching it, big enough for the grid to stay small
+		vec3 extent = max(hi - lo, vec3(1e-3f));
+		float cellSize = std::max(0.5f * totalRange / numPoint, std::max(extent.x, std::max(extent.y, extent.z)) / MAX_DIM);
+		cellSize = std::max(cellSize, 1e-3f);
+		m_min = vec4(lo, 1.0f / cellSize);
+		for (int a = 0; a < 3; a++)
+		{
+			m_dims[a] = (GLuint)std::min(MAX_DIM, std::max(1, (int)ceil(extent[a] / cellSize)));
+		}
+	}
+	const GLuint numCells = m_dims.x * m_dims.y * m_dims.z;
+	m_dims.w = numCells;
+
+	//count how many lights land in each cell, then lay the lists out end to end and fill them
+	//pass 0 counts into the pairs' counts, pass 1 fills using them as cursors
+	const GLuint listsStart = (numCells + 1) * 2;
+	m_data.assign(listsStart, 0);
+	for (int pass = 0; pass < 2; pass++)
+	{
+		GLuint numGlobal = 0;
+		for (GLuint i = 0; i < (GLuint)_lights.size(); i++)
+		{
+			const LightData& light = _lights[i];
+			if (light.m_posType.w != (float)LIGHT_POINT)
+			{
+				if (pass)
+				{
+					m_data[m_data[numCells * 2] + numGlobal] = i;
+				}
+				numGlobal++;
+				continue;
+			}
+
+			vec3 pos = vec3(light.m_posType);
+			float range = light.m_dirRange.w;
+			ivec3 first = clamp(ivec3(floor((pos - range - vec3(m_min)) * m_min.w)), ivec3(0), ivec3(m_dims) - 1);
+			ivec3 last = clamp(ivec3(floor((pos + range - vec3(m_min)) * m_min.w)), ivec3(0), ivec3(m_dims) - 1);
+			for (int z = first.z; z <= last.z; z++)
+			{
+				for (int y = first.y; y <= last.y; y++)
+				{
+					for (int x = first.x; x <= last.x; x++)
+					{
+						//only if the range sphere actually touches the cell's box
+						vec3 cellLo = vec3(m_min) + vec3(x, y, z) / m_min.w;
+						vec3 closest = clamp(pos, cellLo, cellLo + 1.0f / m_min.w);
+						vec3 d = pos - closest;
+						if (dot(d, d) > range * range)
+						{
+							continue;
+						}
+						GLuint cell = (z * m_dims.y + y) * m_dims.x + x;
+						if (pass)
+						{
+							m_data[m_data[cell * 2] + m_data[cell * 2 + 1]] = i;
+						}
+						m_data[cell * 2 + 1]++;
+					}
+				}
+			}
+		}
+		if (!pass)
+		{
+			m_data[numCells * 2 + 1] = numGlobal;
+		}
+
+		if (!pass)
+		{
+			//counts are in, work out where each list starts and reset the counts to fill them again
+			GLuint next = listsStart;
+			for (GLuint cell = 0; cell <= numCells; cell++)
+			{
+				m_data[cell * 2] = next;
+				next += m_data[cell * 2 + 1];
+				if (cell < numCells)
+				{
+					m_data[cell * 2 + 1] = 0;
+				}
+			}
+			m_data.resize(next);
+		}
+	}
+}
+
+void LightGrid::PointLightsAt(const vec3& _pos, const GLuint*& _lights, GLuint& _count) const
+{
+	_count = 0;
+	_lights = nullptr;
+	ivec3 cell = ivec3(floor((_pos - vec3(m_min)) * m_min.w));
+	if (cell.x < 0 || cell.y < 0 || cell.z < 0 || cell.x >= (int)m_dims.x || cell.y >= (int)m_dims.y || cell.z >= (int)m_dims.z)
+	{
+		return;
+	}
+	GLuint index = (cell.z * m_dims.y + cell.y) * m_dims.x + cell.x;
+	_lights = m_data.data() + m_data[index * 2];
+	_count = m_data[index * 2 + 1];
+}
+
+void LightGrid::GlobalLights(const GLuint*& _lights, GLuint& _count) const
+{
+	_lights = m_data.data() + m_data[m_dims.w * 2];
+	_count = m_data[m_dims.w * 2 + 1];
+}
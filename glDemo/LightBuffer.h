@@ -0,0 +1,74 @@
+#pragma once
+#include "core.h"
+#include <vector>
+
+using namespace glm;
+
+//every light in the scene packed into one shader storage buffer
+//shaders loop over however many there are (see texture-directional.frag) instead of knowing each one by name
+//alongside it a grid over the world lists which point lights reach each cell, so a fragment only looks at the few that can light it
+
+//binding points, see layout(std430, binding = N) in the shaders
+const GLuint LIGHT_BUFFER_BINDING = 2;
+const GLuint LIGHT_GRID_BINDING = 3;
+
+enum LightType
+{
+	LIGHT_POINT = 0,
+	LIGHT_DIRECTION = 1
+};
+
+//std430 layout of one light in the buffer
+struct LightData
+{
+	vec4 m_posType;		//xyz position, w LightType
+	vec4 m_dirRange;	//xyz direction (directional lights), w range (point lights)
+	vec4 m_col;
+	vec4 m_amb;
+};
+
+//uniform grid of cells around every point light's range, each with the list of lights whose range touches it
+//laid out as the shaders read it: the header, then a first / count pair per cell,
+//then one more pair for the lights that reach everywhere (directional), then the light indices the pairs point into
+struct LightGrid
+{
+	vec4 m_min = vec4(0.0f);	//xyz corner, w 1 / cell size
+	uvec4 m_dims = uvec4(0);	//xyz cells along each axis, w total cells
+	std::vector<GLuint> m_data;
+
+	//build it for _lights, cells are about half the average point light range, at most MAX_DIM along each axis
+	void Build(const std::vector<LightData>& _lights);
+
+	//the point lights that could reach _pos, just as the shaders look them up
+	void PointLightsAt(const vec3& _pos, const GLuint*& _lights, GLuint& _count) const;
+
+	//the lights that reach everywhere
+	void GlobalLights(const GLuint*& _lights, GLuint& _count) const;
+
+	static const int MAX_DIM = 32;
+};
+
+class LightBuffer
+{
+public:
+	LightBuffer();
+	~LightBuffer();
+
+	//replace what's in the buffer and rebuild the grid, only needs doing when a light has changed
+	void Upload(const std::vector<LightData>& _lights);
+
+	//make this the buffer (and grid) shaders read their lights from
+	void Bind();
+
+	int GetNumLights() const { return m_numLights; }
+	const LightGrid& GetGrid() const { return m_grid; }
+
+protected:
+	GLuint m_buffer = 0;
+	size_t m_capacity = 0;	//in bytes
+	int m_numLights = 0;
+
+	LightGrid m_grid;
+	GLuint m_gridBuffer = 0;
+	size_t m_gridCapacity = 0;	//in bytes
+};
@@ -2,17 +2,18 @@
 #include <assert.h>
 #include "Light.h"
 #include "DirectionLight.h"
+#include "SceneArena.h"
 
-Light* LightFactory::makeNewLight(std::string _type)
+Light* LightFactory::makeNewLight(std::string _type, SceneArena& _arena)
 {
 	printf("LIGHT TYPE: %s \n", _type.c_str());
 	if (_type == "LIGHT")
 	{
-		return new Light();
+		return _arena.New<Light>();
 	}
 	else if (_type == "DIRECTION")
 	{
-		return new DirectionLight();
+		return _arena.New<DirectionLight>();
 	}
 	else
 	{
@@ -1,12 +1,14 @@
 #pragma once
 #include <string>
 class Light;
+class SceneArena;
 
 //ditto for the other factories but now for lights!
+//allocated out of _arena
 class LightFactory
 {
 public:
 
-	static Light* makeNewLight(std::string _type);
+	static Light* makeNewLight(std::string _type, SceneArena& _arena);
 };
 
@@ -0,0 +1,35 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include <string>
+
+//a whole file mapped read only into memory, unmapped again when this goes
+//lets a loader read straight out of the OS file cache without copying the file into a buffer first
+class MappedFile
+{
+public:
+
+	MappedFile() {}
+	~MappedFile() { Close(); }
+
+	//false if it doesn't exist or can't be mapped, an empty file opens with no data
+	bool Open(const std::string& _path);
+	void Close();
+
+	bool IsOpen() const { return m_file != INVALID_HANDLE_VALUE; }
+	const unsigned char* GetData() const { return m_data; }
+	uint64_t GetSize() const { return m_size; }
+
+	//64 bit FNV-1a of the whole file, for telling whether two files (or two versions of one) hold the same bytes
+	uint64_t Hash() const;
+
+protected:
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	HANDLE m_file = INVALID_HANDLE_VALUE;
+	HANDLE m_mapping = NULL;
+	const unsigned char* m_data = nullptr;
+	uint64_t m_size = 0;
+};
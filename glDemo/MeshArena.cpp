@@ -0,0 +1,287 @@
+#include "MeshArena.h"
+#include "InstanceData.h"
+#include "GLState.h"
+#include <algorithm>
+
+using namespace std;
+
+vector<MeshArena::PendingMesh> MeshArena::s_pending;
+size_t MeshArena::s_numVertices = 0;
+size_t MeshArena::s_numIndices = 0;
+vector<MeshArena::FreeBlock> MeshArena::s_freeVertices;
+vector<MeshArena::FreeBlock> MeshArena::s_freeIndices;
+
+GLuint MeshArena::s_vao = 0;
+GLuint MeshArena::s_vertexBuffer = 0;
+GLuint MeshArena::s_indexBuffer = 0;
+size_t MeshArena::s_vertexCapacity = 0;
+size_t MeshArena::s_indexCapacity = 0;
+GLuint MeshArena::s_instanceBuffer = 0;
+
+//room for this many to start with, about what the manifest's models need
+static const size_t MIN_VERTICES = 64 * 1024;
+static const size_t MIN_INDICES = 256 * 1024;
+
+MeshRange MeshArena::Add(const vector<ArenaVertex>& _vertices, const vector<GLuint>& _indices)
+{
+	return Add(_vertices.data(), _vertices.size(), _indices.data(), _indices.size());
+}
+
+MeshRange MeshArena::Add(const ArenaVertex* _vertices, size_t _numVertices, const GLuint* _indices, size_t _numIndices)
+{
+	MeshRange range;
+	range.m_firstIndex = (GLuint)Allocate(s_freeIndices, s_numIndices, _numIndices);
+	range.m_indexCount = (GLuint)_numIndices;
+	range.m_baseVertex = (GLint)Allocate(s_freeVertices, s_numVertices, _numVertices);
+	range.m_vertexCount = (GLuint)_numVertices;
+
+	//held here until the next Bind uploads it
+	PendingMesh pending;
+	pending.m_range = range;
+	pending.m_vertices.assign(_vertices, _vertices + _numVertices);
+	pending.m_indices.assign(_indices, _indices + _numIndices);
+	s_pending.push_back(move(pending));
+
+	return range;
+}
+
+void MeshArena::Remove(const MeshRange& _range)
+{
+	if ((_range.m_vertexCount && _range.m_baseVertex + _range.m_vertexCount > s_numVertices) || (_range.m_indexCount && _range.m_firstIndex + _range.m_indexCount > s_numIndices))
+	{
+		printf("REMOVING A MESH THAT ISN'T IN THE ARENA: vertices %d + %u indices %u + %u \n", _range.m_baseVertex, _range.m_vertexCount, _range.m_firstIndex, _range.m_indexCount);
+		assert(0);
+		return;
+	}
+
+	//no point uploading it now
+	for (size_t i = 0; i < s_pending.size(); i++)
+	{
+		if (s_pending[i].m_range.m_baseVertex == _range.m_baseVertex && s_pending[i].m_range.m_firstIndex == _range.m_firstIndex)
+		{
+			s_pending.erase(s_pending.begin() + i);
+			break;
+		}
+	}
+
+	Free(s_freeVertices, s_numVertices, _range.m_baseVertex, _range.m_vertexCount);
+	Free(s_freeIndices, s_numIndices, _range.m_firstIndex, _range.m_indexCount);
+}
+
+size_t MeshArena::Allocate(vector<FreeBlock>& _free, size_t& _end, size_t _count)
+{
+	for (size_t i = 0; i < _free.size() && _count; i++)
+	{
+		if (_free[i].m_count >= _count)
+		{
+			size_t first = _free[i].m_first;
+			_free[i].m_first += _count;
+			_free[i].m_count -= _count;
+			if (!_free[i].m_count)
+			{
+				_free.erase(_free.begin() + i);
+			}
+			return first;
+		}
+	}
+
+	size_t first = _end;
+	_end += _count;
+	return first;
+}
+
+void MeshArena::Free(vector<FreeBlock>& _free, size_t& _end, size_t _first, size_t _count)
+{
+	if (!_count)
+	{
+		return;
+	}
+
+	//where it goes to keep them in order, then merged with the gap after it and the one before
+	size_t i = 0;
+	while (i < _free.size() && _free[i].m_first < _first)
+	{
+		i++;
+	}
+	FreeBlock block = { _first, _count };
+	if (i < _free.size() && block.m_first + block.m_count == _free[i].m_first)
+	{
+		block.m_count += _free[i].m_count;
+		_free.erase(_free.begin() + i);
+	}
+	if (i > 0 && _free[i - 1].m_first + _free[i - 1].m_count == block.m_first)
+	{
+		i--;
+		block.m_first = _free[i].m_first;
+		block.m_count += _free[i].m_count;
+		_free.erase(_free.begin() + i);
+	}
+
+	//the arena just ends sooner rather than having a gap at the end
+	if (block.m_first + block.m_count == _end)
+	{
+		_end = block.m_first;
+		return;
+	}
+	_free.insert(_free.begin() + i, block);
+}
+
+bool MeshArena::GetPending(const MeshRange& _range, const ArenaVertex*& _vertices, const GLuint*& _indices)
+{
+	for (const PendingMesh& pending : s_pending)
+	{
+		if (pending.m_range.m_baseVertex == _range.m_baseVertex && pending.m_range.m_firstIndex == _range.m_firstIndex)
+		{
+			_vertices = pending.m_vertices.data();
+			_indices = pending.m_indices.data();
+			return true;
+		}
+	}
+	return false;
+}
+
+GLuint MeshArena::Regrow(GLuint _buffer, size_t _oldBytes, size_t _newBytes)
+{
+	GLuint newBuffer = 0;
+	glGenBuffers(1, &newBuffer);
+	GLState::BindBuffer(GL_COPY_WRITE_BUFFER, newBuffer);
+	glBufferData(GL_COPY_WRITE_BUFFER, _newBytes, nullptr, GL_STATIC_DRAW);
+
+	//what is already there stays on the GPU, no need to send it again
+	if (_buffer)
+	{
+		if (_oldBytes)
+		{
+			GLState::BindBuffer(GL_COPY_READ_BUFFER, _buffer);
+			glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, _oldBytes);
+		}
+		GLState::ForgetBuffer(_buffer);
+		glDeleteBuffers(1, &_buffer);
+	}
+	return newBuffer;
+}
+
+void MeshArena::Grow()
+{
+	if (!s_vao)
+	{
+		glGenVertexArrays(1, &s_vao);
+	}
+
+	if (s_numVertices > s_vertexCapacity)
+	{
+		size_t capacity = std::max(s_numVertices, std::max(s_vertexCapacity * 2, MIN_VERTICES));
+		s_vertexBuffer = Regrow(s_vertexBuffer, s_vertexCapacity * sizeof(ArenaVertex), capacity * sizeof(ArenaVertex));
+		s_vertexCapacity = capacity;
+
+		//the attribute pointers belong to the old buffer object, so point them at the new one
+		GLState::BindVertexArray(s_vao);
+		GLState::BindBuffer(GL_ARRAY_BUFFER, s_vertexBuffer);
+		glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(ArenaVertex), (const GLvoid*)offsetof(ArenaVertex, m_pos));
+		glEnableVertexAttribArray(0);
+		glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(ArenaVertex), (const GLvoid*)offsetof(ArenaVertex, m_texCoord));
+		glEnableVertexAttribArray(2);
+		glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(ArenaVertex), (const GLvoid*)offsetof(ArenaVertex, m_normal));
+		glEnableVertexAttribArray(3);
+		glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(ArenaVertex), (const GLvoid*)offsetof(ArenaVertex, m_tangent));
+		glEnableVertexAttribArray(4);
+		glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(ArenaVertex), (const GLvoid*)offsetof(ArenaVertex, m_biTangent));
+		glEnableVertexAttribArray(5);
+	}
+
+	if (s_numIndices > s_indexCapacity)
+	{
+		size_t capacity = std::max(s_numIndices, std::max(s_indexCapacity * 2, MIN_INDICES));
+		s_indexBuffer = Regrow(s_indexBuffer, s_indexCapacity * sizeof(GLuint), capacity * sizeof(GLuint));
+		s_indexCapacity = capacity;
+
+		//the index buffer binding is part of the VAO
+		GLState::BindVertexArray(s_vao);
+		glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, s_indexBuffer);
+	}
+}
+
+void MeshArena::Upload()
+{
+	Grow();
+
+	//only what was added since last time goes up, everything else is already there
+	GLState::BindVertexArray(s_vao);
+	GLState::BindBuffer(GL_ARRAY_BUFFER, s_vertexBuffer);
+	for (const PendingMesh& pending : s_pending)
+	{
+		glBufferSubData(GL_ARRAY_BUFFER, pending.m_range.m_baseVertex * sizeof(ArenaVertex), pending.m_vertices.size() * sizeof(ArenaVertex), pending.m_vertices.data());
+		glBufferSubData(GL_ELEMENT_ARRAY_BUFFER, pending.m_range.m_firstIndex * sizeof(GLuint), pending.m_indices.size() * sizeof(GLuint), pending.m_indices.data());
+	}
+
+	//the GPU has its copy, ours can go
+	s_pending.clear();
+	s_pending.shrink_to_fit();
+}
+
+void MeshArena::Bind(GLuint _instanceBuffer)
+{
+	if (!s_vao || !s_pending.empty())
+	{
+		Upload();
+	}
+	GLState::BindVertexArray(s_vao);
+
+	//point the per instance attributes at the instance buffer, the VAO remembers this so it's only done when the buffer changes
+	if (_instanceBuffer && _instanceBuffer != s_instanceBuffer)
+	{
+		GLState::BindBuffer(GL_ARRAY_BUFFER, _instanceBuffer);
+
+		for (GLuint c = 0; c < 4; c++)
+		{
+			glVertexAttribPointer(INSTANCE_MODEL_ATTRIB + c, 4, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const GLvoid*)(c * sizeof(vec4)));
+			glEnableVertexAttribArray(INSTANCE_MODEL_ATTRIB + c);
+			glVertexAttribDivisor(INSTANCE_MODEL_ATTRIB + c, 1);
+		}
+		for (GLuint c = 0; c < 3; c++)
+		{
+			glVertexAttribPointer(INSTANCE_NORMAL_ATTRIB + c, 3, GL_FLOAT, GL_FALSE, sizeof(InstanceData), (const GLvoid*)(sizeof(mat4) + c * sizeof(vec3)));
+			glEnableVertexAttribArray(INSTANCE_NORMAL_ATTRIB + c);
+			glVertexAttribDivisor(INSTANCE_NORMAL_ATTRIB + c, 1);
+		}
+
+		s_instanceBuffer = _instanceBuffer;
+	}
+}
+
+void MeshArena::Draw(const MeshRange& _range)
+{
+	glDrawElementsBaseVertex(GL_TRIANGLES, _range.m_indexCount, GL_UNSIGNED_INT, (GLvoid*)(_range.m_firstIndex * sizeof(GLuint)), _range.m_baseVertex);
+}
+
+DrawElementsIndirectCommand MeshArena::MakeCommand(const MeshRange& _range, GLuint _instanceCount, GLuint _baseInstance)
+{
+	DrawElementsIndirectCommand command;
+	command.m_count = _range.m_indexCount;
+	command.m_instanceCount = _instanceCount;
+	command.m_firstIndex = _range.m_firstIndex;
+	command.m_baseVertex = _range.m_baseVertex;
+	command.m_baseInstance = _baseInstance;
+	return command;
+}
+
+void MeshArena::Release()
+{
+	if (s_vao)
+	{
+		GLState::ForgetVertexArray(s_vao);
+		GLState::ForgetBuffer(s_vertexBuffer);
+		GLState::ForgetBuffer(s_indexBuffer);
+		glDeleteVertexArrays(1, &s_vao);
+		glDeleteBuffers(1, &s_vertexBuffer);
+		glDeleteBuffers(1, &s_indexBuffer);
+		s_vao = s_vertexBuffer = s_indexBuffer = 0;
+	}
+	s_vertexCapacity = s_indexCapacity = 0;
+	s_instanceBuffer = 0;
+	s_pending.clear();
+	s_pending.shrink_to_fit();
+	s_numVertices = s_numIndices = 0;
+	s_freeVertices.clear();
+	s_freeIndices.clear();
+}
@@ -0,0 +1,118 @@
+#pragma once
+#include "core.h"
+#include <vector>
+
+using namespace glm;
+
+//one vertex as it is stored in the arena, everything a mesh needs interleaved together
+//attribute locations match what each mesh used to set up for itself: pos 0, uv 2, normal 3, tangent 4, bitangent 5
+struct ArenaVertex
+{
+	vec3 m_pos;
+	vec3 m_texCoord;
+	vec3 m_normal;
+	vec3 m_tangent;
+	vec3 m_biTangent;
+};
+
+//where a mesh lives inside the arena
+struct MeshRange
+{
+	GLuint m_firstIndex = 0;
+	GLuint m_indexCount = 0;
+	GLint m_baseVertex = 0;
+	GLuint m_vertexCount = 0;
+};
+
+//layout glMultiDrawElementsIndirect reads its draws in, one of these per draw
+struct DrawElementsIndirectCommand
+{
+	GLuint m_count;
+	GLuint m_instanceCount;
+	GLuint m_firstIndex;
+	GLint m_baseVertex;
+	GLuint m_baseInstance;
+};
+
+//every static mesh's vertices and indices packed into one vertex buffer and one index buffer behind a single VAO
+//so switching mesh is just a different offset and lots of meshes can go out in a single multi draw
+//a mesh is only held on the CPU until the next Bind, which appends it to the GL buffers with glBufferSubData
+//the buffers double in size (copying across on the GPU) whenever they run out of room
+//a mesh that is Removed leaves a gap the next Add that fits goes into, so unloading and loading a scene again takes no more room
+class MeshArena
+{
+public:
+
+	//copy a mesh in, indices are relative to its own first vertex
+	static MeshRange Add(const std::vector<ArenaVertex>& _vertices, const std::vector<GLuint>& _indices);
+	static MeshRange Add(const ArenaVertex* _vertices, size_t _numVertices, const GLuint* _indices, size_t _numIndices);
+
+	//give a mesh's room back, for when whatever Added it goes
+	//only for ranges Added since the last Release, which has already taken back everything before it
+	static void Remove(const MeshRange& _range);
+
+	//bind the arena's VAO (uploading anything added since last time)
+	//with the per instance attributes reading InstanceData from _instanceBuffer, 0 leaves them where they were
+	static void Bind(GLuint _instanceBuffer = 0);
+
+	//draw one mesh on its own, the VAO must already be bound
+	static void Draw(const MeshRange& _range);
+
+	//make a multi draw command for _instanceCount copies of a mesh whose per instance data starts at _baseInstance
+	static DrawElementsIndirectCommand MakeCommand(const MeshRange& _range, GLuint _instanceCount, GLuint _baseInstance);
+
+	//up to the end of the last mesh still in the arena, gaps included
+	static size_t NumVertices() { return s_numVertices; }
+	static size_t NumIndices() { return s_numIndices; }
+
+	//a mesh's vertices and indices as they went in, for checking them
+	//only while it is still waiting to be uploaded (always, if nothing has been drawn), false otherwise
+	static bool GetPending(const MeshRange& _range, const ArenaVertex*& _vertices, const GLuint*& _indices);
+
+	//free the GL buffers and anything not uploaded yet
+	static void Release();
+
+protected:
+
+	//a mesh added since the last upload
+	struct PendingMesh
+	{
+		MeshRange m_range;
+		std::vector<ArenaVertex> m_vertices;
+		std::vector<GLuint> m_indices;
+	};
+
+	//a gap left by a Remove
+	struct FreeBlock
+	{
+		size_t m_first;
+		size_t m_count;
+	};
+
+	//_count from the first gap big enough, or off the _end if none are
+	static size_t Allocate(std::vector<FreeBlock>& _free, size_t& _end, size_t _count);
+
+	//give _count from _first back, joining it onto any gaps either side and pulling _end back if it was the last thing there
+	static void Free(std::vector<FreeBlock>& _free, size_t& _end, size_t _first, size_t _count);
+
+	static void Upload();
+
+	//make sure the GL buffers hold at least s_numVertices and s_numIndices, doubling if not
+	static void Grow();
+
+	//a new buffer of _newBytes with the first _oldBytes of _buffer copied into it, _buffer is deleted
+	static GLuint Regrow(GLuint _buffer, size_t _oldBytes, size_t _newBytes);
+
+	static std::vector<PendingMesh> s_pending;
+	static size_t s_numVertices;
+	static size_t s_numIndices;
+	static std::vector<FreeBlock> s_freeVertices;	//in order of m_first, never touching each other or the end
+	static std::vector<FreeBlock> s_freeIndices;
+
+	static GLuint s_vao;
+	static GLuint s_vertexBuffer;
+	static GLuint s_indexBuffer;
+	static size_t s_vertexCapacity;	//in vertices
+	static size_t s_indexCapacity;	//in indices
+	static GLuint s_instanceBuffer;	//instance buffer the per instance attributes currently read from
+};
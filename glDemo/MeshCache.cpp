@@ -0,0 +1,245 @@
+#include "MeshCache.h"
+#include "MappedFile.h"
+#include <stddef.h>
+#include <mutex>
+#include <atomic>
+
+using namespace std;
+
+bool MeshCache::s_enabled = true;
+
+unsigned int MeshCache::s_hits = 0;
+unsigned int MeshCache::s_misses = 0;
+double MeshCache::s_warmSeconds = 0.0;
+double MeshCache::s_coldSeconds = 0.0;
+static mutex s_statsMutex;
+static atomic<unsigned int> s_tempFiles(0);	//so no two Saves ever write the same temp file
+
+//start of every cache file, followed by m_numVertices ArenaVertex and then m_numIndices GLuint
+//a multiple of 8 bytes so the vertex floats after it stay aligned
+struct MeshCacheHeader
+{
+	char m_magic[4];
+	uint32_t m_version;
+	uint32_t m_vertexSize;		//sizeof(ArenaVertex) when it was written
+	uint32_t m_meshIndex;
+	uint32_t m_importer;		//MeshImporter
+	uint32_t m_importFlags;
+	uint32_t m_hasTexCoords;
+	uint32_t m_reserved;
+	uint64_t m_sourceSize;
+	uint64_t m_sourceTime;
+	uint64_t m_sourceHash;
+	uint32_t m_numVertices;
+	uint32_t m_numIndices;
+	float m_min[3];
+	float m_max[3];
+	float m_centre[3];
+	float m_radius;
+};
+
+static const char MESH_CACHE_MAGIC[4] = { 'M', 'S', 'H', 'C' };
+
+string MeshCache::CachePath(const string& _source, unsigned int _meshIndex)
+{
+	return _source + "." + to_string(_meshIndex) + ".meshcache";
+}
+
+bool MeshCache::StampSource(const string& _source, SourceStamp& _stamp)
+{
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(_source.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		return false;
+	}
+	_stamp.m_size = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	_stamp.m_time = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+
+	MappedFile file;
+	if (!file.Open(_source))
+	{
+		return false;
+	}
+	_stamp.m_hash = file.Hash();
+	return true;
+}
+
+bool MeshCache::Open(const string& _source, unsigned int _meshIndex, MeshImporter _importer, unsigned int _importFlags, MappedFile& _file)
+{
+	if (!s_enabled)
+	{
+		return false;
+	}
+
+	string path = CachePath(_source, _meshIndex);
+	if (!_file.Open(path) || _file.GetSize() < sizeof(MeshCacheHeader))
+	{
+		_file.Close();
+		return false;
+	}
+
+	//made by this version of the code for this mesh?
+	const MeshCacheHeader* header = (const MeshCacheHeader*)_file.GetData();
+	if (memcmp(header->m_magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC)) != 0 ||
+		header->m_version != VERSION ||
+		header->m_vertexSize != sizeof(ArenaVertex) ||
+		header->m_meshIndex != _meshIndex ||
+		header->m_importer != (uint32_t)_importer ||
+		header->m_importFlags != _importFlags)
+	{
+		_file.Close();
+		return false;
+	}
+	uint64_t expected = sizeof(MeshCacheHeader) + (uint64_t)header->m_numVertices * sizeof(ArenaVertex) + (uint64_t)header->m_numIndices * sizeof(GLuint);
+	if (_file.GetSize() != expected)
+	{
+		_file.Close();
+		return false;
+	}
+
+	//from the same source? the size and time are enough if they match
+	//otherwise a source with the same size may only have been touched (copied, checked out again) so compare the contents before giving up
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	if (!GetFileAttributesExA(_source.c_str(), GetFileExInfoStandard, &attributes))
+	{
+		_file.Close();
+		return false;
+	}
+	uint64_t sourceSize = ((uint64_t)attributes.nFileSizeHigh << 32) | attributes.nFileSizeLow;
+	uint64_t sourceTime = ((uint64_t)attributes.ftLastWriteTime.dwHighDateTime << 32) | attributes.ftLastWriteTime.dwLowDateTime;
+	if (sourceSize != header->m_sourceSize)
+	{
+		_file.Close();
+		return false;
+	}
+	if (sourceTime != header->m_sourceTime)
+	{
+		SourceStamp stamp;
+		if (!StampSource(_source, stamp) || stamp.m_hash != header->m_sourceHash)
+		{
+			_file.Close();
+			return false;
+		}
+
+		//the contents matched, store the new time so next time doesn't need to hash the source again
+		//the file can't be written while it is mapped, so let go of it and map it again afterwards
+		_file.Close();
+		{
+			fstream update(path, ios::in | ios::out | ios::binary);
+			if (update.is_open())
+			{
+				update.seekp(offsetof(MeshCacheHeader, m_sourceTime));
+				update.write((const char*)&sourceTime, sizeof(sourceTime));
+			}
+		}
+		return _file.Open(path) && _file.GetSize() == expected;
+	}
+	return true;
+}
+
+MeshRange MeshCache::Add(const MappedFile& _file, Bounds& _bounds, bool& _hasTexCoords)
+{
+	const MeshCacheHeader* header = (const MeshCacheHeader*)_file.GetData();
+
+	//straight from the mapping into the arena, no importer and no intermediate copies
+	const ArenaVertex* vertices = (const ArenaVertex*)(_file.GetData() + sizeof(MeshCacheHeader));
+	const GLuint* indices = (const GLuint*)(vertices + header->m_numVertices);
+	MeshRange range = MeshArena::Add(vertices, header->m_numVertices, indices, header->m_numIndices);
+
+	_bounds = Bounds();
+	_bounds.m_min = vec3(header->m_min[0], header->m_min[1], header->m_min[2]);
+	_bounds.m_max = vec3(header->m_max[0], header->m_max[1], header->m_max[2]);
+	_bounds.m_centre = vec3(header->m_centre[0], header->m_centre[1], header->m_centre[2]);
+	_bounds.m_radius = header->m_radius;
+	_hasTexCoords = header->m_hasTexCoords != 0;
+	return range;
+}
+
+bool MeshCache::Save(const string& _source, unsigned int _meshIndex, MeshImporter _importer, unsigned int _importFlags, const MeshData& _mesh)
+{
+	if (!s_enabled)
+	{
+		return false;
+	}
+
+	SourceStamp stamp;
+	if (!StampSource(_source, stamp))
+	{
+		return false;
+	}
+
+	MeshCacheHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.m_magic, MESH_CACHE_MAGIC, sizeof(MESH_CACHE_MAGIC));
+	header.m_version = VERSION;
+	header.m_vertexSize = sizeof(ArenaVertex);
+	header.m_meshIndex = _meshIndex;
+	header.m_importer = (uint32_t)_importer;
+	header.m_importFlags = _importFlags;
+	header.m_hasTexCoords = _mesh.m_hasTexCoords ? 1 : 0;
+	header.m_sourceSize = stamp.m_size;
+	header.m_sourceTime = stamp.m_time;
+	header.m_sourceHash = stamp.m_hash;
+	header.m_numVertices = (uint32_t)_mesh.m_vertices.size();
+	header.m_numIndices = (uint32_t)_mesh.m_indices.size();
+	for (int i = 0; i < 3; i++)
+	{
+		header.m_min[i] = _mesh.m_bounds.m_min[i];
+		header.m_max[i] = _mesh.m_bounds.m_max[i];
+		header.m_centre[i] = _mesh.m_bounds.m_centre[i];
+	}
+	header.m_radius = _mesh.m_bounds.m_radius;
+
+	//write it to one side and move it into place, so a half written file is never picked up
+	//the name is this process's and this Save's own, another thread (or copy of the program) saving the same mesh writes somewhere else
+	string path = CachePath(_source, _meshIndex);
+	string temp = path + "." + to_string(GetCurrentProcessId()) + "." + to_string(s_tempFiles++) + ".tmp";
+	{
+		ofstream file(temp, ios::out | ios::binary | ios::trunc);
+		if (!file.is_open())
+		{
+			return false;
+		}
+		file.write((const char*)&header, sizeof(header));
+		file.write((const char*)_mesh.m_vertices.data(), _mesh.m_vertices.size() * sizeof(ArenaVertex));
+		file.write((const char*)_mesh.m_indices.data(), _mesh.m_indices.size() * sizeof(GLuint));
+		if (!file.good())
+		{
+			file.close();
+			DeleteFileA(temp.c_str());
+			return false;
+		}
+	}
+	if (!MoveFileExA(temp.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING))
+	{
+		DeleteFileA(temp.c_str());
+		return false;
+	}
+	return true;
+}
+
+void MeshCache::Record(bool _hit, double _seconds)
+{
+	lock_guard<mutex> lock(s_statsMutex);
+	if (_hit)
+	{
+		s_hits++;
+		s_warmSeconds += _seconds;
+	}
+	else
+	{
+		s_misses++;
+		s_coldSeconds += _seconds;
+	}
+}
+
+void MeshCache::PrintStats()
+{
+	printf("MESH CACHE : %u warm (from cache) %.2f ms, %u cold (imported) %.2f ms%s\n", s_hits, s_warmSeconds * 1000.0, s_misses, s_coldSeconds * 1000.0, s_enabled ? "" : " (cache off)");
+}
+
+void MeshCache::ResetStats()
+{
+	s_hits = s_misses = 0;
+	s_warmSeconds = s_coldSeconds = 0.0;
+}
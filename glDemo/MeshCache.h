@@ -0,0 +1,64 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include <string>
+#include "MeshData.h"
+
+class MappedFile;
+
+//binary copies of imported meshes so warm starts skip Assimp altogether
+//each mesh is written next to its source as <source>.<mesh index>.meshcache holding the final vertices, indices and bounds
+//a cache file is only used if its version, layout, importer and its flags and the source's size, modified time and content hash all still match
+//on a hit the file is memory mapped and its vertices and indices go into the MeshArena straight from the mapping
+class MeshCache
+{
+public:
+
+	//bump whenever the file layout or what the importer produces changes
+	static const uint32_t VERSION = 2;
+
+	//load mesh _meshIndex of _source from its cache file, in two halves so the file checks can happen on another thread
+	//Open maps the cache file into _file if it is up to date (thread safe), Add then puts it into the MeshArena (not thread safe)
+	//_importer and _importFlags are whatever would have imported it, a cache made any other way is stale
+	//Open is false if there is no usable cache file, the mesh then has to be imported and Saved
+	static bool Open(const std::string& _source, unsigned int _meshIndex, MeshImporter _importer, unsigned int _importFlags, MappedFile& _file);
+	static MeshRange Add(const MappedFile& _file, Bounds& _bounds, bool& _hasTexCoords);
+
+	//write the cache file for an imported mesh, false (and nothing left behind) if it couldn't be written
+	//thread safe, even for the same mesh, whichever finishes last is the one left in place
+	static bool Save(const std::string& _source, unsigned int _meshIndex, MeshImporter _importer, unsigned int _importFlags, const MeshData& _mesh);
+
+	//where the cache file for a mesh goes
+	static std::string CachePath(const std::string& _source, unsigned int _meshIndex);
+
+	//off makes every load a miss and nothing is written (-nomeshcache)
+	static void SetEnabled(bool _enabled) { s_enabled = _enabled; }
+	static bool IsEnabled() { return s_enabled; }
+
+	//add one mesh load to the totals, _hit for loaded from the cache (warm) otherwise imported (cold)
+	//safe to call from any thread
+	static void Record(bool _hit, double _seconds);
+
+	//mesh loads so far, warm and cold, and how long they took
+	static void PrintStats();
+	static void ResetStats();
+
+protected:
+
+	//everything about the source a cache file has to match
+	struct SourceStamp
+	{
+		uint64_t m_size;
+		uint64_t m_time;	//last write time
+		uint64_t m_hash;	//64 bit FNV-1a of the contents
+	};
+
+	static bool StampSource(const std::string& _source, SourceStamp& _stamp);
+
+	static bool s_enabled;
+
+	static unsigned int s_hits;
+	static unsigned int s_misses;
+	static double s_warmSeconds;
+	static double s_coldSeconds;
+};
@@ -0,0 +1,22 @@
+#pragma once
+#include "core.h"
+#include <vector>
+#include "Bounds.h"
+#include "MeshArena.h"
+
+//what turned a model file into a MeshData
+enum MeshImporter
+{
+	IMPORTER_ASSIMP = 0,
+	IMPORTER_OBJ,		//ObjLoader
+};
+
+//one mesh fully processed and ready to go into the MeshArena
+//what an importer produces and what the MeshCache stores, so a cached mesh comes back exactly as it was imported
+struct MeshData
+{
+	std::vector<ArenaVertex> m_vertices;
+	std::vector<GLuint> m_indices;		//triangles, relative to the first vertex
+	Bounds m_bounds;					//model space, sphere already finished
+	bool m_hasTexCoords = false;
+};
@@ -1,5 +1,7 @@
 #pragma once
 #include <string>
+#include "Bounds.h"
+#include "MeshArena.h"
 
 using namespace std;
 
@@ -11,12 +13,25 @@ public:
 	Model();
 	virtual ~Model();
 
+	//Load only reads my entry in the manifest, the geometry itself comes in two steps after that
+	//Decode does the slow part (reading and processing files) and may run on any thread, with other models decoding alongside
+	//Upload then finishes off on the thread with the GL context, in manifest order
 	virtual void Load(ifstream& _file);
+	virtual void Decode() {};
+	virtual void Upload() {};
 	virtual void Render() {};
 
+	//where my geometry is in the shared MeshArena, so lots of copies (and other arena meshes) can be drawn in one multi draw
+	//models that aren't in the arena return nullptr and get drawn one at a time instead
+	virtual const MeshRange* GetMeshRange() { return nullptr; }
+
 	string GetName() { return m_name; }
 
+	//model space bounding box and sphere, invalid if we don't know (and then whatever uses us is never culled)
+	const Bounds& GetBounds() { return m_bounds; }
+
 protected:
 	string m_name;
 	string m_type;
+	Bounds m_bounds;
 };
\ No newline at end of file
@@ -1,15 +1,16 @@
 #include "ModelFactory.h"
 #include <assert.h>
 #include "AIModel.h"
+#include "SceneArena.h"
 
-Model* ModelFactory::makeNewModel(std::string _type)
+Model* ModelFactory::makeNewModel(std::string _type, SceneArena& _arena)
 {
 	printf("TYPE: %s \n", _type.c_str());
 	//There is no point in making one of the model base class 
 	//as it doesn't do anything 
 	if (_type == "AI")
 	{
-		return new AIModel();
+		return _arena.New<AIModel>();
 	}
 	else
 	{
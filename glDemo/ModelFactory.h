@@ -1,13 +1,14 @@
 #pragma once
 #include <string>
 class Model;
+class SceneArena;
 
 //models are the things owned by Game Objects that are rendered at their location
-//base factory to create them given a TYPE
+//base factory to create them given a TYPE, allocated out of _arena
 class ModelFactory
 {
 public:
 
-	static Model* makeNewModel(std::string _type);
+	static Model* makeNewModel(std::string _type, SceneArena& _arena);
 };
 
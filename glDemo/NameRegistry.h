@@ -0,0 +1,81 @@
+#pragma once
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+//a compact index into a NameRegistry
+//templated on the item type so a Texture handle can't be used to look up a Shader
+template<class T>
+struct Handle
+{
+	static const uint32_t INVALID = 0xffffffff;
+
+	uint32_t m_index = INVALID;
+
+	bool IsValid() const { return m_index != INVALID; }
+	bool operator==(const Handle& _other) const { return m_index == _other.m_index; }
+	bool operator!=(const Handle& _other) const { return m_index != _other.m_index; }
+};
+
+//interns the names of the things in the scene once when they are loaded
+//lookups after that are a single hash instead of walking a list comparing strings
+template<class T>
+class NameRegistry
+{
+public:
+
+	//register an item under its name
+	//returns false if the name is already taken, the first item registered keeps the name
+	bool Add(const std::string& _name, T* _item)
+	{
+		if (m_lookup.find(_name) != m_lookup.end())
+		{
+			m_duplicates++;
+			return false;
+		}
+
+		m_lookup[_name] = (uint32_t)m_items.size();
+		m_items.push_back(_item);
+		return true;
+	}
+
+	//name -> handle, invalid handle if we have never seen this name
+	Handle<T> Find(const std::string& _name) const
+	{
+		Handle<T> handle;
+		auto it = m_lookup.find(_name);
+		if (it != m_lookup.end())
+		{
+			handle.m_index = it->second;
+		}
+		return handle;
+	}
+
+	//handle -> item, always O(1)
+	T* Get(Handle<T> _handle) const
+	{
+		return _handle.IsValid() ? m_items[_handle.m_index] : nullptr;
+	}
+
+	size_t Size() const { return m_items.size(); }
+	int NumDuplicates() const { return m_duplicates; }
+
+	void Reserve(size_t _count)
+	{
+		m_items.reserve(_count);
+		m_lookup.reserve(_count);
+	}
+
+	void Clear()
+	{
+		m_items.clear();
+		m_lookup.clear();
+		m_duplicates = 0;
+	}
+
+protected:
+	std::vector<T*> m_items;
+	std::unordered_map<std::string, uint32_t> m_lookup;
+	int m_duplicates = 0;
+};
@@ -0,0 +1,589 @@
+#include "ObjLoader.h"
+#include "MappedFile.h"
+#include "WorkerPool.h"
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+#include <mutex>
+
+using namespace std;
+using namespace glm;
+
+WorkerPool* ObjLoader::s_pool = nullptr;
+static mutex s_poolMutex;
+
+//bytes of file each parsing job gets, fixed so the chunks (and so the result) don't depend on the thread count
+static const size_t OBJ_CHUNK_BYTES = 256 * 1024;
+
+//negative OBJ indices count back from the last element read, which a chunk can only know relative to its own start
+//so they are kept relative to the chunk offset by this, leaving 0 for missing and positive for the file's own 1 based indices
+static const int32_t OBJ_RELATIVE = -(1 << 30);
+
+//one face corner as written in the file, see OBJ_RELATIVE
+struct ObjCorner
+{
+	int32_t m_v;
+	int32_t m_vt;
+	int32_t m_vn;
+};
+
+//an o, g or usemtl line, where a new mesh may begin
+struct ObjBreak
+{
+	size_t m_face;		//faces in this chunk before it
+	bool m_material;	//usemtl rather than o / g
+	string m_name;
+};
+
+//everything one parsing job found in its slice of the file, in file order
+struct ObjChunk
+{
+	vector<vec3> m_positions;
+	vector<vec3> m_texCoords;
+	vector<vec3> m_normals;
+	vector<ObjCorner> m_corners;
+	vector<uint32_t> m_faceSizes;	//corners in each face
+	vector<ObjBreak> m_breaks;
+};
+
+//faces [m_begin, m_end) of one chunk, with the corners starting at m_firstCorner
+struct ObjFaceRange
+{
+	size_t m_chunk;
+	size_t m_begin;
+	size_t m_end;
+	size_t m_firstCorner;
+};
+
+static inline const char* SkipSpace(const char* _p, const char* _end)
+{
+	while (_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r'))
+	{
+		_p++;
+	}
+	return _p;
+}
+
+static inline bool IsDigit(char _c)
+{
+	return _c >= '0' && _c <= '9';
+}
+
+//is the keyword at _p exactly _length characters long?
+static inline bool EndsKeyword(const char* _p, const char* _end, size_t _length)
+{
+	return _p + _length == _end || _p[_length] == ' ' || _p[_length] == '\t' || _p[_length] == '\r';
+}
+
+//decimal float with optional sign, fraction and exponent, much quicker than strtof (or streams) and exact for anything a modeller writes out
+static const char* ParseFloat(const char* _p, const char* _end, float& _out)
+{
+	static const double powers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+	_p = SkipSpace(_p, _end);
+
+	bool negative = false;
+	if (_p < _end && (*_p == '-' || *_p == '+'))
+	{
+		negative = *_p == '-';
+		_p++;
+	}
+
+	//up to 19 significant digits fit in the mantissa, any more only move the decimal point
+	uint64_t mantissa = 0;
+	int digits = 0;
+	int exponent = 0;
+	for (; _p < _end && IsDigit(*_p); _p++)
+	{
+		if (digits < 19)
+		{
+			mantissa = mantissa * 10 + (*_p - '0');
+			digits += mantissa != 0;
+		}
+		else
+		{
+			exponent++;
+		}
+	}
+	if (_p < _end && *_p == '.')
+	{
+		for (_p++; _p < _end && IsDigit(*_p); _p++)
+		{
+			if (digits < 19)
+			{
+				mantissa = mantissa * 10 + (*_p - '0');
+				digits += mantissa != 0;
+				exponent--;
+			}
+		}
+	}
+	if (_p < _end && (*_p == 'e' || *_p == 'E'))
+	{
+		_p++;
+		bool negativeExponent = false;
+		if (_p < _end && (*_p == '-' || *_p == '+'))
+		{
+			negativeExponent = *_p == '-';
+			_p++;
+		}
+		int e = 0;
+		for (; _p < _end && IsDigit(*_p); _p++)
+		{
+			e = e < 10000 ? e * 10 + (*_p - '0') : e;
+		}
+		exponent += negativeExponent ? -e : e;
+	}
+
+	double value = (double)mantissa;
+	if (exponent < 0)
+	{
+		value = exponent >= -22 ? value / powers[-exponent] : value * pow(10.0, exponent);
+	}
+	else if (exponent > 0)
+	{
+		value = exponent <= 22 ? value * powers[exponent] : value * pow(10.0, exponent);
+	}
+	_out = (float)(negative ? -value : value);
+	return _p;
+}
+
+//a face index, see OBJ_RELATIVE, 0 if there isn't one here
+//_count is how many of this kind of element the chunk has read so far
+static const char* ParseIndex(const char* _p, const char* _end, size_t _count, int32_t& _out)
+{
+	bool negative = false;
+	if (_p < _end && *_p == '-')
+	{
+		negative = true;
+		_p++;
+	}
+	int32_t value = 0;
+	for (; _p < _end && IsDigit(*_p); _p++)
+	{
+		value = value * 10 + (*_p - '0');
+	}
+	_out = negative ? (int32_t)_count - value + OBJ_RELATIVE : value;
+	return _p;
+}
+
+//parse every line in [_p, _end), which starts at the beginning of a line and ends at the end of one
+static void ParseChunk(const char* _p, const char* _end, ObjChunk& _chunk)
+{
+	while (_p < _end)
+	{
+		const char* lineEnd = (const char*)memchr(_p, '\n', _end - _p);
+		if (!lineEnd)
+		{
+			lineEnd = _end;
+		}
+
+		const char* p = SkipSpace(_p, lineEnd);
+		_p = lineEnd + 1;
+		if (p == lineEnd)
+		{
+			continue;
+		}
+
+		if (p[0] == 'v')
+		{
+			vec3 value(0.0f);
+			if (EndsKeyword(p, lineEnd, 1))
+			{
+				p = ParseFloat(p + 1, lineEnd, value.x);
+				p = ParseFloat(p, lineEnd, value.y);
+				ParseFloat(p, lineEnd, value.z);
+				_chunk.m_positions.push_back(value);
+			}
+			else if (p[1] == 't' && EndsKeyword(p, lineEnd, 2))
+			{
+				//the w is optional (and usually missing)
+				p = ParseFloat(p + 2, lineEnd, value.x);
+				p = ParseFloat(p, lineEnd, value.y);
+				if (SkipSpace(p, lineEnd) < lineEnd)
+				{
+					ParseFloat(p, lineEnd, value.z);
+				}
+				_chunk.m_texCoords.push_back(value);
+			}
+			else if (p[1] == 'n' && EndsKeyword(p, lineEnd, 2))
+			{
+				p = ParseFloat(p + 2, lineEnd, value.x);
+				p = ParseFloat(p, lineEnd, value.y);
+				ParseFloat(p, lineEnd, value.z);
+				_chunk.m_normals.push_back(value);
+			}
+		}
+		else if (p[0] == 'f' && EndsKeyword(p, lineEnd, 1))
+		{
+			//v, v/vt, v//vn or v/vt/vn for each corner
+			uint32_t count = 0;
+			for (p = SkipSpace(p + 1, lineEnd); p < lineEnd; p = SkipSpace(p, lineEnd))
+			{
+				ObjCorner corner = { 0, 0, 0 };
+				p = ParseIndex(p, lineEnd, _chunk.m_positions.size(), corner.m_v);
+				if (p < lineEnd && *p == '/')
+				{
+					p++;
+					if (p < lineEnd && *p != '/')
+					{
+						p = ParseIndex(p, lineEnd, _chunk.m_texCoords.size(), corner.m_vt);
+					}
+					if (p < lineEnd && *p == '/')
+					{
+						p = ParseIndex(p + 1, lineEnd, _chunk.m_normals.size(), corner.m_vn);
+					}
+				}
+				if (corner.m_v == 0)
+				{
+					//not something we understand, skip to the next corner
+					while (p < lineEnd && *p != ' ' && *p != '\t' && *p != '\r')
+					{
+						p++;
+					}
+					continue;
+				}
+				_chunk.m_corners.push_back(corner);
+				count++;
+			}
+
+			//lines and points, which SortByPType threw away
+			if (count < 3)
+			{
+				_chunk.m_corners.resize(_chunk.m_corners.size() - count);
+				continue;
+			}
+			_chunk.m_faceSizes.push_back(count);
+		}
+		else if (((p[0] == 'o' || p[0] == 'g') && EndsKeyword(p, lineEnd, 1)) ||
+			(lineEnd - p >= 6 && strncmp(p, "usemtl", 6) == 0 && EndsKeyword(p, lineEnd, 6)))
+		{
+			ObjBreak objBreak;
+			objBreak.m_face = _chunk.m_faceSizes.size();
+			objBreak.m_material = p[0] == 'u';
+			p = SkipSpace(p + (objBreak.m_material ? 6 : 1), lineEnd);
+			const char* nameEnd = lineEnd;
+			while (nameEnd > p && (nameEnd[-1] == ' ' || nameEnd[-1] == '\t' || nameEnd[-1] == '\r'))
+			{
+				nameEnd--;
+			}
+			objBreak.m_name.assign(p, nameEnd);
+			_chunk.m_breaks.push_back(objBreak);
+		}
+	}
+}
+
+//a file index (see OBJ_RELATIVE) as a 0 based index into everything of its kind in the file, -1 if there wasn't one
+static inline int64_t ResolveIndex(int32_t _index, size_t _chunkStart)
+{
+	if (_index > 0)
+	{
+		return (int64_t)_index - 1;
+	}
+	if (_index < 0)
+	{
+		return (int64_t)_index - OBJ_RELATIVE + (int64_t)_chunkStart;
+	}
+	return -1;
+}
+
+//open addressing table from a resolved corner to the vertex made for it
+class ObjWeldTable
+{
+public:
+
+	ObjWeldTable(size_t _corners)
+	{
+		size_t capacity = 16;
+		while (capacity < _corners * 2)
+		{
+			capacity *= 2;
+		}
+		m_entries.resize(capacity);
+		m_mask = capacity - 1;
+	}
+
+	//the vertex for this corner, _next (which then goes up) if it's new
+	GLuint Find(const ObjCorner& _corner, GLuint& _next, bool& _added)
+	{
+		uint32_t hash = (uint32_t)_corner.m_v * 73856093u ^ (uint32_t)_corner.m_vt * 19349663u ^ (uint32_t)_corner.m_vn * 83492791u;
+		hash ^= hash >> 16;
+		for (size_t slot = hash & m_mask;; slot = (slot + 1) & m_mask)
+		{
+			Entry& entry = m_entries[slot];
+			if (entry.m_vertex == EMPTY)
+			{
+				entry.m_corner = _corner;
+				entry.m_vertex = _next++;
+				_added = true;
+				return entry.m_vertex;
+			}
+			if (entry.m_corner.m_v == _corner.m_v && entry.m_corner.m_vt == _corner.m_vt && entry.m_corner.m_vn == _corner.m_vn)
+			{
+				_added = false;
+				return entry.m_vertex;
+			}
+		}
+	}
+
+protected:
+
+	static const GLuint EMPTY = 0xffffffff;
+
+	struct Entry
+	{
+		ObjCorner m_corner;
+		GLuint m_vertex = EMPTY;
+	};
+
+	vector<Entry> m_entries;
+	size_t m_mask;
+};
+
+WorkerPool* ObjLoader::GetPool()
+{
+	lock_guard<mutex> lock(s_poolMutex);
+	if (!s_pool)
+	{
+		s_pool = new WorkerPool();
+	}
+	return s_pool;
+}
+
+void ObjLoader::Release()
+{
+	lock_guard<mutex> lock(s_poolMutex);
+	delete s_pool;
+	s_pool = nullptr;
+}
+
+bool ObjLoader::Load(const string& _filename, unsigned int _meshIndex, MeshData& _mesh, WorkerPool* _pool)
+{
+	MappedFile file;
+	if (!file.Open(_filename))
+	{
+		return false;
+	}
+	const char* data = (const char*)file.GetData();
+	size_t size = (size_t)file.GetSize();
+
+	//cut the file into chunks that each start at the beginning of a line
+	vector<size_t> starts;
+	for (size_t start = 0; start < size;)
+	{
+		starts.push_back(start);
+		const char* newLine = start + OBJ_CHUNK_BYTES < size ? (const char*)memchr(data + start + OBJ_CHUNK_BYTES, '\n', size - start - OBJ_CHUNK_BYTES) : nullptr;
+		start = newLine ? newLine - data + 1 : size;
+	}
+	starts.push_back(size);
+
+	size_t numChunks = starts.size() - 1;
+	vector<ObjChunk> chunks(numChunks);
+	WorkerPool::ParallelFor(_pool ? _pool : GetPool(), numChunks, 1, [&](size_t _begin, size_t _end, size_t)
+	{
+		for (size_t c = _begin; c < _end; c++)
+		{
+			ParseChunk(data + starts[c], data + starts[c + 1], chunks[c]);
+		}
+	});
+
+	//where each chunk's elements start in the whole file
+	vector<size_t> positionStart(numChunks + 1, 0), texCoordStart(numChunks + 1, 0), normalStart(numChunks + 1, 0);
+	for (size_t c = 0; c < numChunks; c++)
+	{
+		positionStart[c + 1] = positionStart[c] + chunks[c].m_positions.size();
+		texCoordStart[c + 1] = texCoordStart[c] + chunks[c].m_texCoords.size();
+		normalStart[c + 1] = normalStart[c] + chunks[c].m_normals.size();
+	}
+
+	//find the faces of the mesh we want, a new mesh starts at a change of object, group or material once the current one has faces
+	vector<ObjFaceRange> ranges;
+	size_t numCorners = 0;
+	unsigned int mesh = 0;
+	size_t meshFaces = 0;
+	string group, material;
+	for (size_t c = 0; c < numChunks; c++)
+	{
+		const ObjChunk& chunk = chunks[c];
+		size_t face = 0;
+		size_t corner = 0;
+		for (size_t b = 0; b <= chunk.m_breaks.size(); b++)
+		{
+			size_t end = b < chunk.m_breaks.size() ? chunk.m_breaks[b].m_face : chunk.m_faceSizes.size();
+			size_t firstCorner = corner;
+			for (size_t f = face; f < end; f++)
+			{
+				corner += chunk.m_faceSizes[f];
+			}
+			if (end > face)
+			{
+				if (mesh == _meshIndex)
+				{
+					ObjFaceRange range = { c, face, end, firstCorner };
+					ranges.push_back(range);
+					numCorners += corner - firstCorner;
+				}
+				meshFaces += end - face;
+			}
+			face = end;
+
+			if (b < chunk.m_breaks.size())
+			{
+				const ObjBreak& objBreak = chunk.m_breaks[b];
+				string& current = objBreak.m_material ? material : group;
+				if (objBreak.m_name != current && meshFaces > 0)
+				{
+					mesh++;
+					meshFaces = 0;
+				}
+				current = objBreak.m_name;
+			}
+		}
+	}
+	if (ranges.empty())
+	{
+		return false;
+	}
+
+	//weld the corners into unique vertices and fan each face into triangles
+	vector<ObjCorner> vertices;
+	vertices.reserve(numCorners);
+	_mesh.m_indices.clear();
+	_mesh.m_indices.reserve(numCorners * 3);
+	ObjWeldTable weld(numCorners);
+	GLuint next = 0;
+	vector<GLuint> face;
+	int64_t numPositions = (int64_t)positionStart[numChunks];
+	int64_t numTexCoords = (int64_t)texCoordStart[numChunks];
+	int64_t numNormals = (int64_t)normalStart[numChunks];
+	for (const ObjFaceRange& range : ranges)
+	{
+		const ObjChunk& chunk = chunks[range.m_chunk];
+		const ObjCorner* corners = chunk.m_corners.data() + range.m_firstCorner;
+		for (size_t f = range.m_begin; f < range.m_end; f++)
+		{
+			uint32_t count = chunk.m_faceSizes[f];
+			face.resize(count);
+			for (uint32_t i = 0; i < count; i++)
+			{
+				int64_t v = ResolveIndex(corners[i].m_v, positionStart[range.m_chunk]);
+				int64_t vt = ResolveIndex(corners[i].m_vt, texCoordStart[range.m_chunk]);
+				int64_t vn = ResolveIndex(corners[i].m_vn, normalStart[range.m_chunk]);
+				if (v < 0 || v >= numPositions || vt >= numTexCoords || vn >= numNormals || vt < -1 || vn < -1)
+				{
+					cout << "ObjLoader bad face index in : " << _filename << endl;
+					return false;
+				}
+
+				ObjCorner resolved = { (int32_t)v, (int32_t)vt, (int32_t)vn };
+				bool added;
+				face[i] = weld.Find(resolved, next, added);
+				if (added)
+				{
+					vertices.push_back(resolved);
+				}
+			}
+			corners += count;
+
+			for (uint32_t i = 1; i + 1 < count; i++)
+			{
+				_mesh.m_indices.push_back(face[0]);
+				_mesh.m_indices.push_back(face[i]);
+				_mesh.m_indices.push_back(face[i + 1]);
+			}
+		}
+	}
+
+	//everything in one array of each, so the welded vertices can look things up
+	vector<vec3> positions(numPositions), texCoords(numTexCoords), normals(numNormals);
+	for (size_t c = 0; c < numChunks; c++)
+	{
+		copy(chunks[c].m_positions.begin(), chunks[c].m_positions.end(), positions.begin() + positionStart[c]);
+		copy(chunks[c].m_texCoords.begin(), chunks[c].m_texCoords.end(), texCoords.begin() + texCoordStart[c]);
+		copy(chunks[c].m_normals.begin(), chunks[c].m_normals.end(), normals.begin() + normalStart[c]);
+	}
+
+	bool hasTexCoords = false;
+	bool hasNormals = false;
+	_mesh.m_vertices.resize(vertices.size());
+	_mesh.m_bounds = Bounds();
+	for (size_t i = 0; i < vertices.size(); i++)
+	{
+		ArenaVertex& vertex = _mesh.m_vertices[i];
+		vertex.m_pos = positions[vertices[i].m_v];
+		vertex.m_texCoord = vertices[i].m_vt >= 0 ? texCoords[vertices[i].m_vt] : vec3(0.0f);
+		vertex.m_normal = vertices[i].m_vn >= 0 ? normals[vertices[i].m_vn] : vec3(0.0f);
+		vertex.m_tangent = vertex.m_biTangent = vec3(0.0f);
+		hasTexCoords = hasTexCoords || vertices[i].m_vt >= 0;
+		hasNormals = hasNormals || vertices[i].m_vn >= 0;
+		_mesh.m_bounds.Add(vertex.m_pos);
+	}
+	_mesh.m_bounds.FinishSphere();
+	_mesh.m_hasTexCoords = hasTexCoords;
+
+	//no normals in the file, average the faces around each position as GenSmoothNormals did
+	if (!hasNormals)
+	{
+		vector<vec3> smooth(numPositions, vec3(0.0f));
+		for (size_t i = 0; i < _mesh.m_indices.size(); i += 3)
+		{
+			const GLuint* tri = &_mesh.m_indices[i];
+			vec3 normal = cross(_mesh.m_vertices[tri[1]].m_pos - _mesh.m_vertices[tri[0]].m_pos, _mesh.m_vertices[tri[2]].m_pos - _mesh.m_vertices[tri[0]].m_pos);
+			float length = glm::length(normal);
+			if (length > 0.0f)
+			{
+				normal /= length;
+				for (int k = 0; k < 3; k++)
+				{
+					smooth[vertices[tri[k]].m_v] += normal;
+				}
+			}
+		}
+		for (size_t i = 0; i < vertices.size(); i++)
+		{
+			vec3 normal = smooth[vertices[i].m_v];
+			float length = glm::length(normal);
+			_mesh.m_vertices[i].m_normal = length > 0.0f ? normal / length : vec3(0.0f);
+		}
+	}
+
+	//tangents and bitangents from the texture coordinates, summed over the faces around each vertex
+	//and then made perpendicular to its normal as CalcTangentSpace did
+	if (hasTexCoords)
+	{
+		for (size_t i = 0; i < _mesh.m_indices.size(); i += 3)
+		{
+			ArenaVertex* tri[3] = { &_mesh.m_vertices[_mesh.m_indices[i]], &_mesh.m_vertices[_mesh.m_indices[i + 1]], &_mesh.m_vertices[_mesh.m_indices[i + 2]] };
+			vec3 v = tri[1]->m_pos - tri[0]->m_pos;
+			vec3 w = tri[2]->m_pos - tri[0]->m_pos;
+			float sx = tri[1]->m_texCoord.x - tri[0]->m_texCoord.x, sy = tri[1]->m_texCoord.y - tri[0]->m_texCoord.y;
+			float tx = tri[2]->m_texCoord.x - tri[0]->m_texCoord.x, ty = tri[2]->m_texCoord.y - tri[0]->m_texCoord.y;
+			float direction = (tx * sy - ty * sx) < 0.0f ? -1.0f : 1.0f;
+
+			//no texture space to speak of, make one up
+			if (sx * ty == sy * tx)
+			{
+				sx = 0.0f; sy = 1.0f;
+				tx = 1.0f; ty = 0.0f;
+			}
+
+			vec3 tangent = (w * sy - v * ty) * direction;
+			vec3 biTangent = (w * sx - v * tx) * direction;
+			for (int k = 0; k < 3; k++)
+			{
+				tri[k]->m_tangent += tangent;
+				tri[k]->m_biTangent += biTangent;
+			}
+		}
+		for (ArenaVertex& vertex : _mesh.m_vertices)
+		{
+			vec3 tangent = vertex.m_tangent - vertex.m_normal * dot(vertex.m_tangent, vertex.m_normal);
+			vec3 biTangent = vertex.m_biTangent - vertex.m_normal * dot(vertex.m_biTangent, vertex.m_normal);
+			float tangentLength = glm::length(tangent);
+			float biTangentLength = glm::length(biTangent);
+			vertex.m_tangent = tangentLength > 0.0f ? tangent / tangentLength : vec3(0.0f);
+			vertex.m_biTangent = biTangentLength > 0.0f ? biTangent / biTangentLength : vec3(0.0f);
+		}
+	}
+
+	return true;
+}
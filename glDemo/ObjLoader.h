@@ -0,0 +1,32 @@
+#pragma once
+#include "core.h"
+#include <string>
+#include "MeshData.h"
+
+class WorkerPool;
+
+//a Wavefront OBJ reader for the models we ship, as a much quicker alternative to importing them with Assimp
+//the file is memory mapped and cut into line aligned chunks which are parsed in parallel and then stitched back together
+//face corners are welded into unique vertices with a hash table (what aiProcess_JoinIdenticalVertices did) and polygons are fanned into triangles
+//normals are generated if the file doesn't have any and tangents whenever there are texture coordinates, as GenSmoothNormals and CalcTangentSpace did
+//what comes out is a MeshData in exactly the layout AIMesh puts into the MeshArena
+//select it for a model with LOADER: OBJ in the manifest
+class ObjLoader
+{
+public:
+
+	//load mesh _meshIndex of an OBJ file, false if it can't be read or has no such mesh
+	//meshes are split at o, g and usemtl lines and any without faces are skipped, so the indices count the same way as Assimp's
+	//_pool is what the parsing is spread over, nullptr uses the loader's own
+	static bool Load(const std::string& _filename, unsigned int _meshIndex, MeshData& _mesh, WorkerPool* _pool = nullptr);
+
+	//the pool Load uses by default, made the first time it's needed
+	static WorkerPool* GetPool();
+
+	//stop the default pool's threads
+	static void Release();
+
+protected:
+
+	static WorkerPool* s_pool;
+};
@@ -0,0 +1,164 @@
+#pragma once
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+#include <utility>
+#include <new>
+#include <stdio.h>
+#include <assert.h>
+
+using namespace std;
+
+//how full a pool is
+//m_holes are freed slots below the high water mark waiting to be reused, m_holes / m_highWater is how fragmented it is
+struct PoolStats
+{
+	const char* m_type;
+	size_t m_objectSize;
+	size_t m_live;
+	size_t m_capacity;		//slots in all the blocks allocated so far
+	size_t m_highWater;		//slots ever handed out since the last Clear
+	size_t m_holes;
+	size_t m_bytes;			//memory held by the blocks
+
+	float Occupancy() const { return m_capacity ? (float)m_live / (float)m_capacity : 0.0f; }
+	float Fragmentation() const { return m_highWater ? (float)m_holes / (float)m_highWater : 0.0f; }
+};
+
+//what SceneArena needs to know about a pool without knowing what it holds
+class PoolBase
+{
+public:
+	virtual ~PoolBase() {}
+	virtual void Clear() = 0;
+	virtual void Release() = 0;
+	virtual PoolStats GetStats() const = 0;
+};
+
+//objects of one type, allocated BLOCK_SIZE at a time so they sit next to each other in memory
+//freed slots go on a free list and are handed out again before any new ones
+//Clear destroys everything in one sweep but keeps the blocks, so filling the pool up again allocates nothing
+template<class T>
+class ObjectPool : public PoolBase
+{
+public:
+
+	static const size_t BLOCK_SIZE = 256;
+
+	ObjectPool(const char* _type) : m_type(_type) {}
+	~ObjectPool() { Release(); }
+
+	template<class... Args>
+	T* New(Args&&... _args)
+	{
+		size_t slot;
+		if (!m_free.empty())
+		{
+			slot = m_free.back();
+			m_free.pop_back();
+		}
+		else
+		{
+			if (m_highWater == m_blocks.size() * BLOCK_SIZE)
+			{
+				m_blocks.push_back(new Storage[BLOCK_SIZE]);
+			}
+			slot = m_highWater++;
+			m_live.push_back(0);
+		}
+
+		T* object = new (SlotPtr(slot)) T(std::forward<Args>(_args)...);
+		m_live[slot] = 1;
+		m_numLive++;
+		return object;
+	}
+
+	//_object must have come from this pool as a T, not as something derived from T
+	void Delete(T* _object)
+	{
+		size_t slot = FindSlot(_object);
+		if (slot == NO_SLOT || !m_live[slot])
+		{
+			printf("DELETING AN OBJECT THAT ISN'T IN THE %s POOL \n", m_type);
+			assert(0);
+			return;
+		}
+
+		_object->~T();
+		m_live[slot] = 0;
+		m_numLive--;
+		m_free.push_back(slot);
+	}
+
+	//destroy every live object, keeping the memory for next time
+	virtual void Clear()
+	{
+		for (size_t slot = 0; slot < m_highWater; slot++)
+		{
+			if (m_live[slot])
+			{
+				SlotPtr(slot)->~T();
+			}
+		}
+		m_live.clear();
+		m_free.clear();
+		m_highWater = 0;
+		m_numLive = 0;
+	}
+
+	//and give the memory back too
+	virtual void Release()
+	{
+		Clear();
+		for (size_t b = 0; b < m_blocks.size(); b++)
+		{
+			delete[] m_blocks[b];
+		}
+		m_blocks.clear();
+	}
+
+	virtual PoolStats GetStats() const
+	{
+		PoolStats stats;
+		stats.m_type = m_type;
+		stats.m_objectSize = sizeof(T);
+		stats.m_live = m_numLive;
+		stats.m_capacity = m_blocks.size() * BLOCK_SIZE;
+		stats.m_highWater = m_highWater;
+		stats.m_holes = m_free.size();
+		stats.m_bytes = m_blocks.size() * BLOCK_SIZE * sizeof(Storage);
+		return stats;
+	}
+
+protected:
+
+	static const size_t NO_SLOT = (size_t)-1;
+
+	//raw, correctly aligned room for one T
+	struct Storage
+	{
+		alignas(T) unsigned char m_bytes[sizeof(T)];
+	};
+
+	T* SlotPtr(size_t _slot) const { return (T*)&m_blocks[_slot / BLOCK_SIZE][_slot % BLOCK_SIZE]; }
+
+	size_t FindSlot(T* _object) const
+	{
+		const Storage* storage = (const Storage*)_object;
+		for (size_t b = 0; b < m_blocks.size(); b++)
+		{
+			if (storage >= m_blocks[b] && storage < m_blocks[b] + BLOCK_SIZE)
+			{
+				return b * BLOCK_SIZE + (size_t)(storage - m_blocks[b]);
+			}
+		}
+		return NO_SLOT;
+	}
+
+	const char* m_type;
+	vector<Storage*> m_blocks;
+	vector<uint8_t> m_live;		//per slot up to m_highWater, is there an object in it
+	vector<size_t> m_free;		//freed slots below m_highWater
+	size_t m_highWater = 0;
+	size_t m_numLive = 0;
+};
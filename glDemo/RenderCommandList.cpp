@@ -0,0 +1,53 @@
+#include "RenderCommandList.h"
+#include "GameObject.h"
+#include "GLState.h"
+#include "FrameUniforms.h"
+#include "MeshArena.h"
+
+void RenderCommandList::UseProgram(GLuint _prog)
+{
+	if (_prog != m_program)
+	{
+		Push(CMD_USE_PROGRAM, 0, _prog);
+		if (!m_firstProgram)
+		{
+			m_firstProgram = _prog;
+		}
+		m_program = _prog;
+		m_programChanges++;
+	}
+}
+
+void RenderCommandList::Replay() const
+{
+	for (size_t i = 0; i < m_commands.size(); i++)
+	{
+		const RenderCommand& command = m_commands[i];
+		switch (command.m_type)
+		{
+		case CMD_USE_PROGRAM:
+			GLState::UseProgram((GLuint)command.m_arg);
+			break;
+
+		case CMD_SETUP_MATERIAL:
+			command.m_GO->SetupMaterial();
+			break;
+
+		case CMD_BIND_OBJECT_BLOCK:
+			FrameUniforms::BindObject((size_t)command.m_arg);
+			break;
+
+		case CMD_DRAW:
+			command.m_GO->Render();
+			break;
+
+		case CMD_BIND_ARENA:
+			MeshArena::Bind((GLuint)command.m_arg);
+			break;
+
+		case CMD_MULTI_DRAW:
+			glMultiDrawElementsIndirect(GL_TRIANGLES, GL_UNSIGNED_INT, (const GLvoid*)(command.m_arg * sizeof(DrawElementsIndirectCommand)), (GLsizei)command.m_count, 0);
+			break;
+		}
+	}
+}
@@ -0,0 +1,77 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+class GameObject;
+
+//what a RenderCommand asks the GL thread to do
+enum RenderCommandType : uint32_t
+{
+	CMD_USE_PROGRAM = 0,	//m_arg = program
+	CMD_SETUP_MATERIAL,		//m_GO->SetupMaterial()
+	CMD_BIND_OBJECT_BLOCK,	//m_arg = offset of an object uniform block already written into FrameUniforms
+	CMD_DRAW,				//m_GO->Render()
+	CMD_BIND_ARENA,			//MeshArena::Bind(m_arg), m_arg = per instance buffer
+	CMD_MULTI_DRAW,			//m_arg = first command in the bound indirect buffer, m_count = how many
+};
+
+//one step of a frame's drawing, plain data so worker threads can write them without touching GL
+struct RenderCommand
+{
+	RenderCommandType m_type;
+	uint32_t m_count;
+	union
+	{
+		uint64_t m_arg;
+		GameObject* m_GO;
+	};
+};
+
+//a list of RenderCommands recorded on any thread and replayed in order on the one with the GL context
+//Scene::Render has each worker fill its own list for its slice of the draw order, then replays them one after another
+class RenderCommandList
+{
+public:
+
+	void Clear() { m_commands.clear(); m_firstProgram = m_program = 0; m_programChanges = m_draws = 0; }
+	size_t Size() const { return m_commands.size(); }
+
+	//what was recorded, so stats can be totted up without replaying
+	GLuint GetFirstProgram() const { return m_firstProgram; }
+	GLuint GetLastProgram() const { return m_program; }
+	int GetProgramChanges() const { return m_programChanges; }
+	int GetDraws() const { return m_draws; }
+
+	//program changes are only recorded when it differs from the last one in this list
+	//(GLState drops any that repeat the end of the previous list)
+	void UseProgram(GLuint _prog);
+	void SetupMaterial(GameObject* _GO) { Push(CMD_SETUP_MATERIAL, 0, 0)->m_GO = _GO; }
+	void BindObjectBlock(size_t _offset) { Push(CMD_BIND_OBJECT_BLOCK, 0, _offset); }
+	void Draw(GameObject* _GO) { Push(CMD_DRAW, 0, 0)->m_GO = _GO; m_draws++; }
+	void BindArena(GLuint _instanceBuffer) { Push(CMD_BIND_ARENA, 0, _instanceBuffer); }
+	void MultiDraw(size_t _firstCommand, size_t _count) { Push(CMD_MULTI_DRAW, (uint32_t)_count, _firstCommand); m_draws++; }
+
+	//make the GL calls, on the GL thread only
+	void Replay() const;
+
+protected:
+
+	RenderCommand* Push(RenderCommandType _type, uint32_t _count, uint64_t _arg)
+	{
+		RenderCommand command;
+		command.m_type = _type;
+		command.m_count = _count;
+		command.m_arg = _arg;
+		m_commands.push_back(command);
+		return &m_commands.back();
+	}
+
+	vector<RenderCommand> m_commands;
+	GLuint m_firstProgram = 0;
+	GLuint m_program = 0;
+	int m_programChanges = 0;
+	int m_draws = 0;
+};
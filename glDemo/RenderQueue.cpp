@@ -0,0 +1,135 @@
+#include "RenderQueue.h"
+
+//the field sizes have to fit in the key
+static_assert(RenderQueue::DEPTH_BITS + RenderQueue::MESH_BITS + RenderQueue::TEXTURE_BITS + RenderQueue::SHADER_BITS + RenderQueue::PASS_BITS <= 64, "render key too big");
+
+static inline uint64_t Field(uint32_t _value, int _bits)
+{
+	uint32_t maxValue = (1u << _bits) - 1;
+	return _value < maxValue ? _value : maxValue;
+}
+
+uint64_t RenderQueue::MakeKey(uint32_t _pass, uint32_t _shader, uint32_t _texture, uint32_t _mesh, float _depth)
+{
+	const float maxDepth = (float)((1u << DEPTH_BITS) - 1);
+	float depth = _depth < 0.0f ? 0.0f : (_depth > 1.0f ? 1.0f : _depth);
+
+	uint64_t key = Field(_pass, PASS_BITS);
+	key = (key << SHADER_BITS) | Field(_shader, SHADER_BITS);
+	key = (key << TEXTURE_BITS) | Field(_texture, TEXTURE_BITS);
+	key = (key << MESH_BITS) | Field(_mesh, MESH_BITS);
+	key = (key << DEPTH_BITS) | (uint64_t)(depth * maxDepth);
+	return key;
+}
+
+uint64_t RenderQueue::MakeBackToFrontKey(uint32_t _pass, float _depth, uint32_t _shader, uint32_t _texture, uint32_t _mesh)
+{
+	const float maxDepth = (float)((1u << DEPTH_BITS) - 1);
+	float depth = _depth < 0.0f ? 0.0f : (_depth > 1.0f ? 1.0f : _depth);
+
+	uint64_t key = Field(_pass, PASS_BITS);
+	key = (key << DEPTH_BITS) | (uint64_t)((1.0f - depth) * maxDepth);
+	key = (key << SHADER_BITS) | Field(_shader, SHADER_BITS);
+	key = (key << TEXTURE_BITS) | Field(_texture, TEXTURE_BITS);
+	key = (key << MESH_BITS) | Field(_mesh, MESH_BITS);
+	return key;
+}
+
+void RenderQueue::Sort()
+{
+	m_sortPasses = 0;
+
+	//how far from sorted are we? places where a key is smaller than the one before it
+	size_t descents = 0;
+	for (size_t i = 1; i < m_items.size(); i++)
+	{
+		descents += m_items[i].m_key < m_items[i - 1].m_key ? 1 : 0;
+	}
+
+	if (descents == 0)
+	{
+		return;
+	}
+
+	//only a few things out of place, try touching them up before falling back to the full sort
+	if (descents <= m_items.size() / NEARLY_SORTED_RATIO && InsertionSort())
+	{
+		return;
+	}
+
+	RadixSort();
+}
+
+bool RenderQueue::InsertionSort()
+{
+	const size_t count = m_items.size();
+	size_t budget = count * INSERTION_MOVES_PER_ITEM;
+
+	for (size_t i = 1; i < count; i++)
+	{
+		//strictly less, so equal keys keep their order
+		if (m_items[i].m_key >= m_items[i - 1].m_key)
+		{
+			continue;
+		}
+
+		RenderItem item = m_items[i];
+		size_t j = i;
+		while (j > 0 && item.m_key < m_items[j - 1].m_key)
+		{
+			if (budget == 0)
+			{
+				m_items[j] = item;
+				return false;
+			}
+			m_items[j] = m_items[j - 1];
+			j--;
+			budget--;
+		}
+		m_items[j] = item;
+	}
+
+	return true;
+}
+
+void RenderQueue::RadixSort()
+{
+	const size_t count = m_items.size();
+
+	//count every byte of every key in one go
+	size_t histogram[8][256] = {};
+	for (size_t i = 0; i < count; i++)
+	{
+		uint64_t key = m_items[i].m_key;
+		for (int b = 0; b < 8; b++)
+		{
+			histogram[b][(key >> (b * 8)) & 0xff]++;
+		}
+	}
+
+	m_scratch.resize(count);
+	for (int b = 0; b < 8; b++)
+	{
+		//every key has the same value in this byte, so this pass wouldn't move anything
+		if (histogram[b][(m_items[0].m_key >> (b * 8)) & 0xff] == count)
+		{
+			continue;
+		}
+
+		//turn the counts into where each value starts
+		size_t offset = 0;
+		for (int v = 0; v < 256; v++)
+		{
+			size_t n = histogram[b][v];
+			histogram[b][v] = offset;
+			offset += n;
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			m_scratch[histogram[b][(m_items[i].m_key >> (b * 8)) & 0xff]++] = m_items[i];
+		}
+		m_items.swap(m_scratch);
+		m_sortPasses++;
+	}
+}
@@ -0,0 +1,72 @@
+#pragma once
+#include <stdint.h>
+#include <vector>
+
+using namespace std;
+
+class GameObject;
+
+//one thing to draw, and where it should come in the draw order
+struct RenderItem
+{
+	uint64_t m_key;
+	GameObject* m_GO;
+};
+
+//list of everything to be drawn this frame, sorted so that objects sharing state end up next to each other
+//the sort key packs, from most to least significant:
+//	pass (4 bits) | shader (10) | texture (12) | mesh (12) | depth (24)
+//so all of a pass comes together, then each shader's objects, then each texture's within that...
+//which lets submission change program / texture only when they actually change
+//for see-through objects the draw order has to be back to front, so MakeBackToFrontKey puts depth first instead
+class RenderQueue
+{
+public:
+
+	static const int DEPTH_BITS = 24;
+	static const int MESH_BITS = 12;
+	static const int TEXTURE_BITS = 12;
+	static const int SHADER_BITS = 10;
+	static const int PASS_BITS = 4;
+
+	//build a key from the registry indices of what an object is drawn with
+	//indices too big for their field (or invalid handles) all share the largest value, they still draw correctly just sort less well
+	//_depth is 0 (near) to 1 (far), anything outside that is clamped
+	static uint64_t MakeKey(uint32_t _pass, uint32_t _shader, uint32_t _texture, uint32_t _mesh, float _depth);
+
+	//pass (4 bits) | far to near depth (24) | shader (10) | texture (12) | mesh (12)
+	//state only breaks ties between objects at the same depth
+	static uint64_t MakeBackToFrontKey(uint32_t _pass, float _depth, uint32_t _shader, uint32_t _texture, uint32_t _mesh);
+
+	void Clear() { m_items.clear(); }
+	void Reserve(size_t _count) { m_items.reserve(_count); m_scratch.reserve(_count); }
+	void Push(uint64_t _key, GameObject* _GO) { RenderItem item = { _key, _GO }; m_items.push_back(item); }
+	void Append(const vector<RenderItem>& _items) { m_items.insert(m_items.end(), _items.begin(), _items.end()); }
+
+	//stable sort on the key
+	//if the items were pushed in nearly the right order (e.g. last frame's order) they are just touched up with an insertion sort
+	//otherwise it is a least significant digit radix sort a byte at a time, skipping bytes that are the same in every key
+	void Sort();
+
+	size_t Size() const { return m_items.size(); }
+	const RenderItem& operator[](size_t _i) const { return m_items[_i]; }
+
+	//how many of the eight radix passes the last Sort actually needed, 0 if the insertion sort was enough
+	int GetSortPasses() const { return m_sortPasses; }
+
+protected:
+
+	//only try the insertion sort if no more than one in this many items is smaller than the one before it
+	static const size_t NEARLY_SORTED_RATIO = 8;
+
+	//give up on the insertion sort after moving items this many times per item, the input wasn't nearly sorted after all
+	static const size_t INSERTION_MOVES_PER_ITEM = 8;
+
+	//returns false if it ran out of moves, everything done up to then is still a valid (stable) step towards sorted
+	bool InsertionSort();
+	void RadixSort();
+
+	vector<RenderItem> m_items;
+	vector<RenderItem> m_scratch;
+	int m_sortPasses = 0;
+};
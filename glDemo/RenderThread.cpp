@@ -0,0 +1,99 @@
+#include "RenderThread.h"
+#include "Scene.h"
+#include "WorkerPool.h"
+#include "FrameUniforms.h"
+#include "TextureStreamer.h"
+#include <iostream>
+
+RenderThread::RenderThread(GLFWwindow* _window, Scene* _scene)
+{
+	m_window = _window;
+	m_scene = _scene;
+	m_workers = _scene->GetWorkers();
+	cout << "RENDER THREAD : SHARING THE SCENE'S " << (m_workers ? m_workers->NumThreads() : 1) << " THREADS" << endl;
+
+	//a context can only be current on one thread at a time
+	glfwMakeContextCurrent(nullptr);
+	m_thread = thread(&RenderThread::Loop, this);
+}
+
+RenderThread::~RenderThread()
+{
+	{
+		lock_guard<mutex> lock(m_wakeMutex);
+		m_quit = true;
+	}
+	m_wake.notify_one();
+	m_thread.join();
+
+	glfwMakeContextCurrent(m_window);
+}
+
+void RenderThread::Submit()
+{
+	m_snapshots.Publish();
+
+	//taking the lock means the render thread is either asleep already or hasn't checked for a snapshot yet, so it can't miss this
+	{
+		lock_guard<mutex> lock(m_wakeMutex);
+		m_numSubmitted++;
+	}
+	m_wake.notify_one();
+}
+
+void RenderThread::WaitForPickup()
+{
+	unique_lock<mutex> lock(m_wakeMutex);
+	m_pickedUp.wait(lock, [this] { return m_numPickedUp == m_numSubmitted; });
+}
+
+const SceneStats& RenderThread::GetStats()
+{
+	m_stats.Acquire();
+	return m_stats.Read();
+}
+
+void RenderThread::Loop()
+{
+	glfwMakeContextCurrent(m_window);
+
+	int width = 0;
+	int height = 0;
+	while (true)
+	{
+		//sleep until the main thread submits something new
+		{
+			unique_lock<mutex> lock(m_wakeMutex);
+			m_wake.wait(lock, [this] { return m_quit || m_snapshots.Acquire(); });
+
+			//the main thread never gets more than one ahead, so this is always the one it submitted last
+			m_numPickedUp = m_numSubmitted;
+		}
+		m_pickedUp.notify_one();
+		if (m_quit)
+		{
+			break;
+		}
+		FrameSnapshot& snap = m_snapshots.Read();
+
+		if (snap.m_width && snap.m_height && (snap.m_width != width || snap.m_height != height))
+		{
+			width = snap.m_width;
+			height = snap.m_height;
+			glViewport(0, 0, width, height);
+		}
+
+		glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+		FrameUniforms::BeginFrame();
+		TextureStreamer::Update(m_workers);
+		m_scene->RenderSnapshot(snap, m_workers);
+		FrameUniforms::EndFrame();
+		glfwSwapBuffers(m_window);
+
+		m_stats.Write() = snap.m_stats;
+		m_stats.Publish();
+		m_framesDrawn++;
+	}
+
+	glfwMakeContextCurrent(nullptr);
+}
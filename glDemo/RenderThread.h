@@ -0,0 +1,68 @@
+#pragma once
+#include "core.h"
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include "TripleBuffer.h"
+#include "FrameSnapshot.h"
+#include "SceneStats.h"
+
+using namespace std;
+
+class Scene;
+class WorkerPool;
+
+//draws a Scene on a thread of its own, one frame behind the main thread
+//the GL context moves over to it, the main thread keeps updating the Scene and each frame hands over a FrameSnapshot of it
+//snapshots go across in a TripleBuffer so the main thread never waits, if it gets ahead only the newest is drawn (and if it falls behind the render thread sleeps)
+//so a frame takes about as long as the slower of updating and drawing rather than both added together
+class RenderThread
+{
+public:
+
+	//takes the GL context off this thread
+	//RenderSnapshot shares _scene's WorkerPool, so drawing and updating take turns on it rather than both filling every core
+	RenderThread(GLFWwindow* _window, Scene* _scene);
+
+	//stops drawing and gives the GL context back to the thread that made me
+	~RenderThread();
+
+	//fill this in (with Scene::BuildSnapshot) then Submit it
+	FrameSnapshot& GetSnapshot() { return m_snapshots.Write(); }
+	void Submit();
+
+	//wait until the render thread has started drawing the last snapshot Submitted
+	//call before building the next one so the main thread is never more than a frame ahead of what is on screen
+	void WaitForPickup();
+
+	//stats from the last frame drawn, main thread only
+	const SceneStats& GetStats();
+
+	//frames actually drawn so far
+	unsigned int GetFramesDrawn() const { return m_framesDrawn.load(); }
+
+protected:
+
+	void Loop();
+
+	GLFWwindow* m_window;
+	Scene* m_scene;
+	WorkerPool* m_workers = nullptr;	//the scene's, not ours to delete
+
+	TripleBuffer<FrameSnapshot> m_snapshots;	//main thread -> render thread
+	TripleBuffer<SceneStats> m_stats;			//and what drawing them took coming back
+
+	//the render thread sleeps on this until there is a snapshot to draw (or it's time to stop)
+	mutex m_wakeMutex;
+	condition_variable m_wake;
+
+	//and the main thread on this until the render thread has picked up what it submitted, both counts guarded by m_wakeMutex
+	condition_variable m_pickedUp;
+	unsigned int m_numSubmitted = 0;
+	unsigned int m_numPickedUp = 0;
+
+	atomic<bool> m_quit{ false };
+	atomic<unsigned int> m_framesDrawn{ 0 };
+	thread m_thread;
+};
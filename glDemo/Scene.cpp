@@ -9,8 +9,38 @@
 #include "Texture.h"
 #include "Shader.h"
 #include "GameObjectFactory.h"
+#include "UniformTable.h"
+#include "GLState.h"
+#include "FrameUniforms.h"
+#include "AssetLoader.h"
+#include "TextureCache.h"
+#include "stringHelp.h"
 #include <assert.h>
 #include <glm/gtc/matrix_transform.hpp>
+#include <random>
+#include <algorithm>
+
+//the first thing loaded with a given name keeps it, anything after that gets reported
+template<class T>
+static void Register(NameRegistry<T>& _registry, const string& _name, T* _item, const char* _kind)
+{
+	if (!_registry.Add(_name, _item))
+	{
+		printf("DUPLICATE %s NAME : %s (only the first one can be looked up)\n", _kind, _name.c_str());
+	}
+}
+
+template<class T>
+static T* Lookup(const NameRegistry<T>& _registry, const string& _name, const char* _kind)
+{
+	T* item = _registry.Get(_registry.Find(_name));
+	if (!item)
+	{
+		printf("Unknown %s NAME : %s \n", _kind, _name.c_str());
+		assert(0);
+	}
+	return item;
+}
 
 Scene::Scene()
 {
@@ -18,182 +48,629 @@ Scene::Scene()
 
 Scene::~Scene()
 {
-	//TODO: We are being really naught and not deleting everything as we finish
-	//what shoudl really go here and in similar places throughout the code base?
+	//GL things go too, so this has to happen while the context is still current
+	Unload();
+	m_arena.Release();
+
+	if (m_instanceBuffer)
+	{
+		GLState::ForgetBuffer(m_instanceBuffer);
+		GLState::ForgetBuffer(m_indirectBuffer);
+		glDeleteBuffers(1, &m_instanceBuffer);
+		glDeleteBuffers(1, &m_indirectBuffer);
+	}
+
+	delete m_Workers;
+}
+
+void Scene::Unload()
+{
+	//everything was allocated out of the arena, so one Clear destroys the lot
+	m_Cameras.clear();
+	m_Lights.clear();
+	m_Models.clear();
+	m_Textures.clear();
+	m_Shaders.clear();
+	m_GameObjects.clear();
+	m_arena.Clear();
+
+	m_CameraRegistry.Clear();
+	m_LightRegistry.Clear();
+	m_ModelRegistry.Clear();
+	m_TextureRegistry.Clear();
+	m_ShaderRegistry.Clear();
+	m_GORegistry.Clear();
+	m_numCameras = m_numLights = m_numGameObjects = m_numModels = m_numTextures = m_numShaders = 0;
+
+	//and nothing left pointing at any of it
+	m_Transforms.Clear();
+	m_GOByTransform.clear();
+	m_bvhDirty = true;
+	m_opaqueQueue.Clear();
+	m_transparentQueue.Clear();
+	m_transparentOrder.clear();
+	m_snapshot.m_opaque.clear();
+	m_snapshot.m_transparent.clear();
+	m_lightDataVersion++;
+	m_useCamera = nullptr;
+	m_useCameraIndex = 0;
 }
 
 //tick all my Game Objects, lights and cameras
 void Scene::Update(float _dt)
 {
-	//update all lights
+	m_stats.Reset();
+
+	//update all lights, the light buffer only needs refilling if any of them changed (or some were added)
+	unsigned int lightsVersion = (unsigned int)m_Lights.size();
 	for (list<Light*>::iterator it = m_Lights.begin(); it != m_Lights.end(); it++)
 	{
 		(*it)->Tick(_dt);
+		lightsVersion += (*it)->GetVersion();
+	}
+	if (lightsVersion != m_lightsVersion)
+	{
+		m_lightsVersion = lightsVersion;
+		m_lightDataVersion++;
+	}
+
+	//spin and build world matrices for every GameObject in one sweep over the TransformStore
+	//only the ones that have changed (or whose parent has) are rebuilt, split across the worker threads if we have them
+	m_Transforms.Update(m_Workers);
+	m_stats.m_transformsUpdated = m_Transforms.GetNumUpdated();
+	m_stats.m_transformsSkipped = m_Transforms.GetNumSkipped();
+
+	//keep the BVH in step with the new world bounds
+	//normally just refit the boxes of anything that moved, only rebuilding when things have moved so much the tree is poor
+	if (!m_bvhDirty && m_stats.m_transformsUpdated > 0)
+	{
+		m_bvh.Refit(m_Transforms.UpdatedFlags());
+		m_stats.m_bvhRefits++;
+		m_bvhDirty = m_bvh.NeedsRebuild();
+	}
+	if (m_bvhDirty)
+	{
+		m_bvh.Build(&m_Transforms.GetWorldBounds());
+		m_stats.m_bvhRebuilds++;
+		m_bvhDirty = false;
 	}
 
-	//update all cameras
+	//update all cameras, only the ones that have moved will rebuild their view matrix
+	//done after the transforms so cameras attached to GameObjects see where they are this frame
 	for (list<Camera*>::iterator it = m_Cameras.begin(); it != m_Cameras.end(); it++)
 	{
+		if ((*it)->IsDirty())
+		{
+			m_stats.m_camerasUpdated++;
+		}
+		else
+		{
+			m_stats.m_camerasSkipped++;
+		}
 		(*it)->Tick(_dt);
 	}
 
-	//update all GameObjects
+	//anything else GameObjects want to do each frame
+	//these stay on the main thread as a subclass is free to poke at the rest of the scene from here
 	for (list<GameObject*>::iterator it = m_GameObjects.begin(); it != m_GameObjects.end(); it++)
 	{
 		(*it)->Tick(_dt);
 	}
 }
 
+void Scene::SetThreadCount(int _threads)
+{
+	delete m_Workers;
+	m_Workers = nullptr;
+
+	if (_threads != 1)
+	{
+		m_Workers = new WorkerPool(_threads);
+	}
+	cout << "SCENE UPDATE THREADS : " << GetThreadCount() << endl;
+}
+
 void Scene::AddGameObject(GameObject* _new)
 {
+	if (_new->GetTransformID() == INVALID_TRANSFORM)
+	{
+		_new->SetTransform(&m_Transforms, m_Transforms.Add());
+	}
+
 	m_GameObjects.push_back(_new);
+	Register(m_GORegistry, _new->GetName(), _new, "Game Object");
+
+	if (m_GOByTransform.size() <= _new->GetTransformID())
+	{
+		m_GOByTransform.resize(_new->GetTransformID() + 1, nullptr);
+	}
+	m_GOByTransform[_new->GetTransformID()] = _new;
+	m_bvhDirty = true;
 }
 
-//I want THAT Game Object by name
-GameObject* Scene::GetGameObject(string _GOName)
+void Scene::FindGameObjects(const vec3& _centre, float _radius, std::vector<GameObject*>& _out)
 {
-	for (list<GameObject*>::iterator it = m_GameObjects.begin(); it != m_GameObjects.end(); it++)
+	m_queryResults.clear();
+	m_bvh.QuerySphere(_centre, _radius, m_queryResults);
+	for (size_t i = 0; i < m_queryResults.size(); i++)
 	{
-		if ((*it)->GetName() == _GOName)
+		if (m_queryResults[i] < m_GOByTransform.size() && m_GOByTransform[m_queryResults[i]])
 		{
-			return (*it);
+			_out.push_back(m_GOByTransform[m_queryResults[i]]);
 		}
 	}
-	printf("Unknown Game Object NAME : %s \n", _GOName.c_str());
-	assert(0);
-	return nullptr;
 }
 
-Camera* Scene::GetCamera(string _camName)
+GameObject* Scene::RayCast(const vec3& _origin, const vec3& _dir, float _maxDist, float* _hitDist)
 {
-	for (list<Camera*>::iterator it = m_Cameras.begin(); it != m_Cameras.end(); it++)
+	uint32_t hit;
+	float t;
+	if (!m_bvh.RayCast(_origin, _dir, _maxDist, hit, t) || hit >= m_GOByTransform.size())
 	{
-		if ((*it)->GetName() == _camName)
-		{
-			return (*it);
-		}
+		return nullptr;
+	}
+
+	if (_hitDist)
+	{
+		*_hitDist = t;
 	}
-	printf("Unknown Camera NAME : %s \n", _camName.c_str());
-	assert(0);
-	return nullptr;
+	return m_GOByTransform[hit];
 }
 
-Light* Scene::GetLight(string _lightName)
+//I want THAT Game Object by name
+GameObject* Scene::GetGameObject(const string& _GOName)
 {
-	for (list<Light*>::iterator it = m_Lights.begin(); it != m_Lights.end(); it++)
+	return Lookup(m_GORegistry, _GOName, "Game Object");
+}
+
+Camera* Scene::GetCamera(const string& _camName)
+{
+	return Lookup(m_CameraRegistry, _camName, "Camera");
+}
+
+Light* Scene::GetLight(const string& _lightName)
+{
+	return Lookup(m_LightRegistry, _lightName, "Light");
+}
+
+Texture* Scene::GetTexture(const string& _texName)
+{
+	return Lookup(m_TextureRegistry, _texName, "Texture");
+}
+
+Model* Scene::GetModel(const string& _modelName)
+{
+	return Lookup(m_ModelRegistry, _modelName, "Model");
+}
+
+Shader* Scene::GetShader(const string& _shaderName)
+{
+	return Lookup(m_ShaderRegistry, _shaderName, "Shader");
+}
+
+
+//how many objects each thread frustum culls at a time
+static const size_t CULL_CHUNK = 4096;
+
+//below this many objects testing every one is quicker than walking the BVH
+static const size_t BVH_CULL_MIN = 4096;
+
+//how many queue entries each thread records draws for at a time
+static const size_t RECORD_CHUNK = 1024;
+
+//can these two go in the same multi draw (they may still be different models)
+static inline bool SameMaterial(GameObject* _a, GameObject* _b)
+{
+	return _a->GetInstancedShaderProg() == _b->GetInstancedShaderProg() && _a->GetShaderHandle() == _b->GetShaderHandle()
+		&& _a->GetTextureHandle() == _b->GetTextureHandle();
+}
+
+//distance in front of the camera of the middle of a transform's bounding sphere
+static inline float ViewDepth(const WorldBounds& _bounds, TransformID _id, const mat4& _view)
+{
+	return -(_view[0][2] * _bounds.m_sphereX[_id] + _view[1][2] * _bounds.m_sphereY[_id] + _view[2][2] * _bounds.m_sphereZ[_id] + _view[3][2]);
+}
+
+//Render Everything
+void Scene::Render()
+{
+	BuildSnapshot(m_snapshot);
+	RenderSnapshot(m_snapshot, m_Workers);
+	m_stats = m_snapshot.m_stats;
+}
+
+void Scene::BuildSnapshot(FrameSnapshot& _snap)
+{
+	//the camera, every shader reads it from the same uniform block
+	_snap.m_view = m_useCamera->GetView();
+	_snap.m_proj = m_useCamera->GetProj();
+	_snap.m_camPos = m_useCamera->GetWorldPos();
+
+	//and the lights, only copied if this snapshot hasn't got the latest ones already
+	if (_snap.m_lightsVersion != m_lightDataVersion)
 	{
-		if ((*it)->GetName() == _lightName)
+		_snap.m_lights.resize(m_Lights.size());
+		size_t i = 0;
+		for (list<Light*>::iterator it = m_Lights.begin(); it != m_Lights.end(); it++, i++)
 		{
-			return (*it);
+			(*it)->GetLightData(_snap.m_lights[i]);
 		}
+		_snap.m_lightsVersion = m_lightDataVersion;
 	}
-	printf("Unknown Light NAME : %s \n", _lightName.c_str());
-	assert(0);
-	return nullptr;
-}
 
-Texture* Scene::GetTexture(string _texName)
-{
-	for (list<Texture*>::iterator it = m_Textures.begin(); it != m_Textures.end(); it++)
+	//work out which objects the current camera can see
+	//the world space bounds were brought up to date along with the world matrices in Update
+	m_frustum.Extract(m_useCamera->GetProj() * m_useCamera->GetView());
+	m_visible.resize(m_Transforms.Size());
+	if (m_Transforms.Size() >= BVH_CULL_MIN && m_bvh.NumItems() == m_Transforms.Size())
 	{
-		if ((*it)->GetName() == _texName)
+		//lots of objects, let the BVH throw away whole groups at once
+		m_bvh.ResetNodesVisited();
+		m_queryResults.clear();
+		m_bvh.QueryFrustum(m_frustum, m_queryResults);
+		std::fill(m_visible.begin(), m_visible.end(), 0);
+		for (size_t i = 0; i < m_queryResults.size(); i++)
 		{
-			return (*it);
+			m_visible[m_queryResults[i]] = 1;
 		}
+		m_stats.m_bvhNodesVisited = m_bvh.GetNodesVisited();
+	}
+	else
+	{
+		//not many, quicker to just test them all in SIMD batches
+		WorkerPool::ParallelFor(m_Workers, m_Transforms.Size(), CULL_CHUNK, [this](size_t _begin, size_t _end, size_t)
+		{
+			m_frustum.Cull(m_Transforms.GetWorldBounds(), _begin, _end - _begin, &m_visible[_begin]);
+		});
 	}
-	printf("Unknown Texture NAME : %s \n", _texName.c_str());
-	assert(0);
-	return nullptr;
-}
 
-Model* Scene::GetModel(string _modelName)
-{
-	for (list<Model*>::iterator it = m_Models.begin(); it != m_Models.end(); it++)
+	//fill the queue with everything visible in the opaque pass, keyed on what it is drawn with and how far away it is
+	//front to back within a shader / texture / mesh run so the depth test can throw away more of the pixels
+	//each thread keys its own slice of the objects, the slices then go into the queue in order
+	const mat4 view = m_useCamera->GetView();
+	const float farPlane = m_useCamera->GetFar();
+	const WorldBounds& bounds = m_Transforms.GetWorldBounds();
+
+	size_t numObjects = m_GOByTransform.size();
+	size_t numKeyChunks = (numObjects + CULL_CHUNK - 1) / CULL_CHUNK;
+	m_keyChunks.resize(numKeyChunks);
+	m_chunkCulled.resize(numKeyChunks);
+	WorkerPool::ParallelFor(m_Workers, numObjects, CULL_CHUNK, [&](size_t _begin, size_t _end, size_t _chunk)
 	{
-		if ((*it)->GetName() == _modelName)
+		vector<RenderItem>& items = m_keyChunks[_chunk];
+		items.clear();
+		int culled = 0;
+		for (size_t id = _begin; id < _end; id++)
 		{
-			return (*it);
+			GameObject* GO = m_GOByTransform[id];
+			if (!GO || !(GO->GetRP() & RP_OPAQUE))// TODO: note the bit-wise operation. Why?
+			{
+				continue;
+			}
+
+			//don't bother with anything outside the view
+			if (!m_visible[id])
+			{
+				culled++;
+				continue;
+			}
+
+			float depth = ViewDepth(bounds, (TransformID)id, view);
+			RenderItem item = { RenderQueue::MakeKey(0, GO->GetShaderHandle().m_index, GO->GetTextureHandle().m_index, GO->GetModelHandle().m_index, depth / farPlane), GO };
+			items.push_back(item);
 		}
+		m_chunkCulled[_chunk] = culled;
+	});
+
+	m_opaqueQueue.Clear();
+	for (size_t c = 0; c < numKeyChunks; c++)
+	{
+		m_opaqueQueue.Append(m_keyChunks[c]);
+		m_stats.m_objectsVisible += (int)m_keyChunks[c].size();
+		m_stats.m_objectsCulled += m_chunkCulled[c];
 	}
-	printf("Unknown Model NAME : %s \n", _modelName.c_str());
-	assert(0);
-	return nullptr;
+	m_opaqueQueue.Sort();
+
+	//copy out everything in draw order along with its matrices as they are now
+	_snap.m_opaque.resize(m_opaqueQueue.Size());
+	WorkerPool::ParallelFor(m_Workers, m_opaqueQueue.Size(), RECORD_CHUNK, [&](size_t _begin, size_t _end, size_t)
+	{
+		for (size_t i = _begin; i < _end; i++)
+		{
+			SnapshotItem& item = _snap.m_opaque[i];
+			item.m_GO = m_opaqueQueue[i].m_GO;
+			TransformID id = item.m_GO->GetTransformID();
+			item.m_transform.m_model = m_Transforms.GetWorld(id);
+			item.m_transform.m_normal = m_Transforms.GetNormalMatrix(id);
+		}
+	});
+
+	//now everything see-through, back to front so each one blends over whatever is behind it
+	//last frame's order goes in first, marking those objects 2 in m_visible so they aren't added again below
+	m_transparentQueue.Clear();
+	for (size_t i = 0; i < m_transparentOrder.size(); i++)
+	{
+		GameObject* GO = m_transparentOrder[i];
+		TransformID id = GO->GetTransformID();
+		if (m_visible[id] == 1 && (GO->GetRP() & RP_TRANSPARENT))
+		{
+			m_transparentQueue.Push(TransparentKey(GO, view, farPlane), GO);
+			m_visible[id] = 2;
+		}
+	}
+
+	//then anything that wasn't there last frame (just come into view or only just added)
+	for (list<GameObject*>::iterator it = m_GameObjects.begin(); it != m_GameObjects.end(); it++)
+	{
+		if ((*it)->GetRP() & RP_TRANSPARENT)
+		{
+			TransformID id = (*it)->GetTransformID();
+			if (m_visible[id] == 1)
+			{
+				m_transparentQueue.Push(TransparentKey(*it, view, farPlane), *it);
+			}
+			else if (m_visible[id] == 0)
+			{
+				m_stats.m_objectsCulled++;
+			}
+		}
+	}
+	m_transparentQueue.Sort();
+	m_stats.m_transparentVisible = (int)m_transparentQueue.Size();
+	m_stats.m_transparentSortPasses = m_transparentQueue.GetSortPasses();
+
+	m_transparentOrder.clear();
+	_snap.m_transparent.resize(m_transparentQueue.Size());
+	for (size_t i = 0; i < m_transparentQueue.Size(); i++)
+	{
+		SnapshotItem& item = _snap.m_transparent[i];
+		item.m_GO = m_transparentQueue[i].m_GO;
+		TransformID id = item.m_GO->GetTransformID();
+		item.m_transform.m_model = m_Transforms.GetWorld(id);
+		item.m_transform.m_normal = m_Transforms.GetNormalMatrix(id);
+		m_transparentOrder.push_back(item.m_GO);
+	}
+
+	_snap.m_stats = m_stats;
 }
 
-Shader* Scene::GetShader(string _shaderName)
+void Scene::RenderSnapshot(FrameSnapshot& _snap, WorkerPool* _workers)
 {
-	for (list<Shader*>::iterator it = m_Shaders.begin(); it != m_Shaders.end(); it++)
+	SceneStats& stats = _snap.m_stats;
+	unsigned int locationQueries = UniformTable::GetLocationQueries();
+	unsigned int glIssued = GLState::GetIssued();
+	unsigned int glElided = GLState::GetElided();
+
+	//every shader reads the camera from the same uniform block, so it only needs writing once
+	FrameUniforms::SetCamera(_snap.m_view, _snap.m_proj, _snap.m_camPos);
+	stats.m_cameraUploads++;
+
+	//and all the lights from the light buffer, refilled only when one of them has changed
+	if (_snap.m_lightsVersion != m_uploadedLightsVersion)
+	{
+		m_lightBuffer.Upload(_snap.m_lights);
+		m_uploadedLightsVersion = _snap.m_lightsVersion;
+		stats.m_lightUploads++;
+	}
+	m_lightBuffer.Bind();
+
+	//split the sorted queue into batches sharing an instanced shader and texture
+	//each batch is a single multi draw out of the MeshArena, one command per model in it with a copy per object
+	//the commands find their objects' matrices in m_instanceData through their base instance
+	//anything that can't be drawn like that is left in batches of its own to be drawn one at a time, each with its own object block
+	m_batches.clear();
+	m_drawCommands.clear();
+	size_t numInstances = 0;
+	size_t numBlocks = 0;
+	for (size_t i = 0; i < _snap.m_opaque.size(); )
 	{
-		if ((*it)->GetName() == _shaderName)
+		GameObject* GO = _snap.m_opaque[i].m_GO;
+		bool instanced = GO->GetInstancedShaderProg() != 0;
+
+		DrawBatch batch;
+		batch.m_first = i;
+		batch.m_firstCommand = m_drawCommands.size();
+		batch.m_instanced = instanced;
+
+		size_t end = i + 1;
+		if (instanced)
+		{
+			//the queue is sorted by shader, texture and then model, so each model's copies are next to each other
+			while (end < _snap.m_opaque.size() && SameMaterial(GO, _snap.m_opaque[end].m_GO))
+			{
+				end++;
+			}
+
+			for (size_t j = i; j < end; j++)
+			{
+				GameObject* instance = _snap.m_opaque[j].m_GO;
+				if (j == i || instance->GetModelHandle() != _snap.m_opaque[j - 1].m_GO->GetModelHandle())
+				{
+					m_drawCommands.push_back(MeshArena::MakeCommand(*instance->GetMeshRange(), 0, (GLuint)(numInstances + j - i)));
+				}
+				m_drawCommands.back().m_instanceCount++;
+			}
+			batch.m_firstSlot = numInstances;
+			numInstances += end - i;
+		}
+		else
 		{
-			return (*it);
+			while (end < _snap.m_opaque.size() && _snap.m_opaque[end].m_GO->GetInstancedShaderProg() == 0)
+			{
+				end++;
+			}
+			batch.m_firstSlot = numBlocks;
+			numBlocks += end - i;
 		}
+
+		batch.m_count = end - i;
+		batch.m_numCommands = m_drawCommands.size() - batch.m_firstCommand;
+		m_batches.push_back(batch);
+		i = end;
 	}
-	printf("Unknown Shader NAME : %s \n", _shaderName.c_str());
-	assert(0);
-	return nullptr;
-}
 
+	//room for every object's matrices, instanced ones in m_instanceData and the rest as object blocks straight into the uniform ring
+	//then the threads fill them in and record the draws for their slice of the queue
+	//nothing in here touches GL, it all goes into a command list per slice that is replayed on this thread afterwards
+	m_instanceData.resize(numInstances);
+	size_t firstBlock = numBlocks ? FrameUniforms::ReserveObjects(numBlocks) : 0;
+	size_t blockStride = FrameUniforms::ObjectStride();
+	if (numInstances && !m_instanceBuffer)
+	{
+		glGenBuffers(1, &m_instanceBuffer);
+		glGenBuffers(1, &m_indirectBuffer);
+	}
 
-//Render Everything
-void Scene::Render()
-{
-	//TODO: Set up for the Opaque Render Pass will go here
-	//check out the example stuff back in main.cpp to see what needs setting up here
-	for (list<GameObject*>::iterator it = m_GameObjects.begin(); it != m_GameObjects.end(); it++)
+	size_t numRecordChunks = (_snap.m_opaque.size() + RECORD_CHUNK - 1) / RECORD_CHUNK;
+	m_commandLists.resize(numRecordChunks);
+	WorkerPool::ParallelFor(_workers, _snap.m_opaque.size(), RECORD_CHUNK, [&](size_t _begin, size_t _end, size_t _chunk)
 	{
-		if ((*it)->GetRP() & RP_OPAQUE)// TODO: note the bit-wise operation. Why?
+		RenderCommandList& commands = m_commandLists[_chunk];
+		commands.Clear();
+
+		//the batch this slice starts in
+		size_t b = std::upper_bound(m_batches.begin(), m_batches.end(), _begin, [](size_t _item, const DrawBatch& _batch) { return _item < _batch.m_first; }) - m_batches.begin() - 1;
+		for (size_t i = _begin; i < _end; i++)
 		{
-			//set shader program using
-			GLuint SP = (*it)->GetShaderProg();
-			glUseProgram(SP);
+			while (i >= m_batches[b].m_first + m_batches[b].m_count)
+			{
+				b++;
+			}
+			const DrawBatch& batch = m_batches[b];
+			const SnapshotItem& item = _snap.m_opaque[i];
+			GameObject* GO = item.m_GO;
+			size_t slot = batch.m_firstSlot + i - batch.m_first;
+
+			if (batch.m_instanced)
+			{
+				m_instanceData[slot] = item.m_transform;
+
+				//the whole batch is drawn by whichever slice it starts in
+				//everything but the matrices is shared, so the first one sets it up for the lot
+				if (i == batch.m_first)
+				{
+					commands.UseProgram(GO->GetInstancedShaderProg());
+					commands.SetupMaterial(GO);
+					commands.BindArena(m_instanceBuffer);
+					commands.MultiDraw(batch.m_firstCommand, batch.m_numCommands);
+				}
+			}
+			else
+			{
+				size_t offset = firstBlock + slot * blockStride;
+				FrameUniforms::WriteObject(offset, item.m_transform.m_model, item.m_transform.m_normal);
+
+				commands.UseProgram(GO->GetShaderProg());
+				commands.BindObjectBlock(offset);
+				commands.SetupMaterial(GO);
+				commands.Draw(GO);
+			}
+		}
+	});
+
+	//one upload each for every batch's matrices and draw commands this frame
+	//glBufferData hands the driver fresh storage each time so we never wait on last frame's draws still reading the old one
+	if (!m_instanceData.empty())
+	{
+		m_instanceBufferSize = std::max(m_instanceBufferSize, m_instanceData.size() * sizeof(InstanceData));
+		GLState::BindBuffer(GL_ARRAY_BUFFER, m_instanceBuffer);
+		glBufferData(GL_ARRAY_BUFFER, m_instanceBufferSize, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_ARRAY_BUFFER, 0, m_instanceData.size() * sizeof(InstanceData), m_instanceData.data());
+
+		m_indirectBufferSize = std::max(m_indirectBufferSize, m_drawCommands.size() * sizeof(DrawElementsIndirectCommand));
+		GLState::BindBuffer(GL_DRAW_INDIRECT_BUFFER, m_indirectBuffer);
+		glBufferData(GL_DRAW_INDIRECT_BUFFER, m_indirectBufferSize, nullptr, GL_STREAM_DRAW);
+		glBufferSubData(GL_DRAW_INDIRECT_BUFFER, 0, m_drawCommands.size() * sizeof(DrawElementsIndirectCommand), m_drawCommands.data());
+	}
 
-			//set up for uniform shader values for current camera
-			m_useCamera->SetRenderValues(SP);
+	//and draw them, each slice picking up where the one before left off
+	//a slice starting with the program the last one ended on doesn't count as a switch (GLState drops the call anyway)
+	GLuint currentProg = 0;
+	for (size_t c = 0; c < numRecordChunks; c++)
+	{
+		const RenderCommandList& commands = m_commandLists[c];
+		commands.Replay();
 
-			//loop through setting up uniform shader values for anything else
-			SetShaderUniforms(SP);
+		stats.m_programBinds += commands.GetProgramChanges();
+		if (commands.GetFirstProgram() && commands.GetFirstProgram() == currentProg)
+		{
+			stats.m_programBinds--;
+		}
+		if (commands.GetLastProgram())
+		{
+			currentProg = commands.GetLastProgram();
+		}
+		stats.m_drawCalls += commands.GetDraws();
+	}
+	for (size_t b = 0; b < m_batches.size(); b++)
+	{
+		if (m_batches[b].m_instanced)
+		{
+			stats.m_indirectDraws++;
+			stats.m_indirectCommands += (int)m_batches[b].m_numCommands;
+			stats.m_instancesDrawn += (int)m_batches[b].m_count;
+		}
+	}
 
-			//set any uniform shader values for the actual model
-			(*it)->PreRender();
+	//now everything see-through, back to front so each one blends over whatever is behind it
+	if (!_snap.m_transparent.empty())
+	{
+		//blend over what is already there, and don't let see-through things hide each other in the depth buffer
+		GLState::Enable(GL_BLEND);
+		GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+		GLState::DepthMask(false);
 
-			//actually render the GameObject
-			(*it)->Render();
+		for (size_t i = 0; i < _snap.m_transparent.size(); i++)
+		{
+			const SnapshotItem& item = _snap.m_transparent[i];
+			GameObject* GO = item.m_GO;
+
+			GLuint SP = GO->GetShaderProg();
+			if (SP != currentProg)
+			{
+				GLState::UseProgram(SP);
+				stats.m_programBinds++;
+				currentProg = SP;
+			}
+
+			FrameUniforms::SetObject(item.m_transform.m_model, item.m_transform.m_normal);
+			GO->SetupMaterial();
+			GO->Render();
+			stats.m_drawCalls++;
 		}
+
+		GLState::DepthMask(true);
+		GLState::Disable(GL_BLEND);
 	}
 
-	//TODO: now do the same for RP_TRANSPARENT here
+	stats.m_uniformLocationQueries = (int)(UniformTable::GetLocationQueries() - locationQueries);
+	stats.m_glCallsIssued = (int)(GLState::GetIssued() - glIssued);
+	stats.m_glCallsElided = (int)(GLState::GetElided() - glElided);
 }
 
-void Scene::SetShaderUniforms(GLuint _shaderprog)
+uint64_t Scene::TransparentKey(GameObject* _GO, const mat4& _view, float _farPlane)
 {
-	//everything needs to know about all the lights
-	for (list<Light*>::iterator it = m_Lights.begin(); it != m_Lights.end(); it++)
-	{
-		(*it)->SetRenderValues(_shaderprog);
-	}
+	const WorldBounds& bounds = m_Transforms.GetWorldBounds();
+	TransformID id = _GO->GetTransformID();
 
+	float depth = ViewDepth(bounds, id, _view);
+	return RenderQueue::MakeBackToFrontKey(1, depth / _farPlane, _GO->GetShaderHandle().m_index, _GO->GetTextureHandle().m_index, _GO->GetModelHandle().m_index);
 }
 
 void Scene::Load(ifstream& _file)
 {
-	string dummy;
-
 	//load Cameras
-	_file >> dummy >> m_numCameras; _file.ignore(256, '\n');
+	m_numCameras = StringHelp::SectionCount(_file);
+	m_CameraRegistry.Reserve(m_numCameras);
 	cout << "CAMERAS : " << m_numCameras << endl;
 	for (int i = 0; i < m_numCameras; i++)
 	{
-		//skip {
-		_file.ignore(256, '\n');
 		cout << "{\n";
-
-		string type;
-		_file >> dummy >> type; _file.ignore(256, '\n');
-		Camera* newCam = CameraFactory::makeNewCam(type);
+		Camera* newCam = CameraFactory::makeNewCam(StringHelp::EntryType(_file), m_arena);
 		newCam->Load(_file);
 
 		m_Cameras.push_back(newCam);
+		Register(m_CameraRegistry, newCam->GetName(), newCam, "Camera");
 
 		//skip }
 		_file.ignore(256, '\n');
@@ -203,20 +680,17 @@ void Scene::Load(ifstream& _file)
 	cout << endl << endl;
 
 	//load Lights
-	_file >> dummy >> m_numLights; _file.ignore(256, '\n');
+	m_numLights = StringHelp::SectionCount(_file);
+	m_LightRegistry.Reserve(m_numLights);
 	cout << "LIGHTS : " << m_numLights << endl;
 	for (int i = 0; i < m_numLights; i++)
 	{
-		//skip {
-		_file.ignore(256, '\n');
 		cout << "{\n";
-
-		string type;
-		_file >> dummy >> type; _file.ignore(256, '\n');
-		Light* newLight = LightFactory::makeNewLight(type);
+		Light* newLight = LightFactory::makeNewLight(StringHelp::EntryType(_file), m_arena);
 		newLight->Load(_file);
 
 		m_Lights.push_back(newLight);
+		Register(m_LightRegistry, newLight->GetName(), newLight, "Light");
 
 		//skip }
 		_file.ignore(256, '\n');
@@ -226,20 +700,17 @@ void Scene::Load(ifstream& _file)
 	cout << endl << endl;
 
 	//load Models
-	_file >> dummy >> m_numModels; _file.ignore(256, '\n');
+	m_numModels = StringHelp::SectionCount(_file);
+	m_ModelRegistry.Reserve(m_numModels);
 	cout << "MODELS : " << m_numModels << endl;
 	for (int i = 0; i < m_numModels; i++)
 	{
-		//skip {
-		_file.ignore(256, '\n');
 		cout << "{\n";
-
-		string type;
-		_file >> dummy >> type; _file.ignore(256, '\n');
-		Model* newModel = ModelFactory::makeNewModel(type);
+		Model* newModel = ModelFactory::makeNewModel(StringHelp::EntryType(_file), m_arena);
 		newModel->Load(_file);
 
 		m_Models.push_back(newModel);
+		Register(m_ModelRegistry, newModel->GetName(), newModel, "Model");
 
 		//skip }
 		_file.ignore(256, '\n');
@@ -249,7 +720,8 @@ void Scene::Load(ifstream& _file)
 	cout << endl << endl;
 
 	//load Textures
-	_file >> dummy >> m_numTextures; _file.ignore(256, '\n');
+	m_numTextures = StringHelp::SectionCount(_file);
+	m_TextureRegistry.Reserve(m_numTextures);
 	cout << "TEXTURES : " << m_numTextures << endl;
 	for (int i = 0; i < m_numTextures; i++)
 	{
@@ -257,7 +729,10 @@ void Scene::Load(ifstream& _file)
 		_file.ignore(256, '\n');
 		cout << "{\n";
 
-		m_Textures.push_back(new Texture(_file));
+		Texture* newTexture = m_arena.New<Texture>(_file);
+
+		m_Textures.push_back(newTexture);
+		Register(m_TextureRegistry, newTexture->GetName(), newTexture, "Texture");
 
 		//skip }
 		_file.ignore(256, '\n');
@@ -267,7 +742,8 @@ void Scene::Load(ifstream& _file)
 	cout << endl << endl;
 
 	//load Shaders
-	_file >> dummy >> m_numShaders; _file.ignore(256, '\n');
+	m_numShaders = StringHelp::SectionCount(_file);
+	m_ShaderRegistry.Reserve(m_numShaders);
 	cout << "SHADERS : " << m_numShaders << endl;
 	for (int i = 0; i < m_numShaders; i++)
 	{
@@ -275,7 +751,10 @@ void Scene::Load(ifstream& _file)
 		_file.ignore(256, '\n');
 		cout << "{\n";
 
-		m_Shaders.push_back(new Shader(_file));
+		Shader* newShader = m_arena.New<Shader>(_file);
+
+		m_Shaders.push_back(newShader);
+		Register(m_ShaderRegistry, newShader->GetName(), newShader, "Shader");
 
 		//skip }
 		_file.ignore(256, '\n');
@@ -285,27 +764,54 @@ void Scene::Load(ifstream& _file)
 	cout << endl << endl;
 
 	//load GameObjects
-	_file >> dummy >> m_numGameObjects; _file.ignore(256, '\n');
+	m_numGameObjects = StringHelp::SectionCount(_file);
+	m_GORegistry.Reserve(m_numGameObjects);
+	m_Transforms.Reserve(m_numGameObjects);
 	cout << "GAMEOBJECTS : " << m_numGameObjects << endl;
 	for (int i = 0; i < m_numGameObjects; i++)
 	{
-		//skip {
-		_file.ignore(256, '\n');
 		cout << "{\n";
-
-		string type;
-		_file >> dummy >> type; _file.ignore(256, '\n');
-		GameObject* newGO = GameObjectFactory::makeNewGO(type);
+		GameObject* newGO = GameObjectFactory::makeNewGO(StringHelp::EntryType(_file), m_arena);
+		newGO->SetTransform(&m_Transforms, m_Transforms.Add());
 		newGO->Load(_file);
 
-		m_GameObjects.push_back(newGO);
+		AddGameObject(newGO);
 
 		//skip }
 		_file.ignore(256, '\n');
 		cout << "}\n";
 	}
 
+	LoadAssets();
+}
 
+void Scene::LoadAssets()
+{
+	//everything above only read the manifest, now read the files it names
+	//models and textures decode across the workers while this thread (the one with the GL context) uploads each as it is ready
+	//shaders go first as they have nothing to decode, so they compile while the first decodes are under way
+	//uploads stay in manifest order so the MeshArena lays out the same every run
+	AssetLoader loader(m_Workers);
+	for (list<Shader*>::iterator it = m_Shaders.begin(); it != m_Shaders.end(); ++it)
+	{
+		Shader* shader = *it;
+		loader.Add(shader->GetName(), nullptr, [shader] { shader->Upload(); });
+	}
+	for (list<Model*>::iterator it = m_Models.begin(); it != m_Models.end(); ++it)
+	{
+		Model* model = *it;
+		loader.Add(model->GetName(), [model] { model->Decode(); }, [model] { model->Upload(); });
+	}
+	for (list<Texture*>::iterator it = m_Textures.begin(); it != m_Textures.end(); ++it)
+	{
+		Texture* texture = *it;
+		loader.Add(texture->GetName(), [texture] { texture->Decode(); }, [texture] { texture->Upload(); });
+	}
+	loader.Run();
+	loader.PrintStats();
+
+	//anything decoded that no texture went on to Acquire
+	TextureCache::Trim();
 }
 
 void Scene::Init()
@@ -334,11 +840,83 @@ void Scene::Init()
 		m_useCameraIndex = 0;
 	}
 
+	//attach GameObjects to their parents
+	for (list<GameObject*>::iterator it = m_GameObjects.begin(); it != m_GameObjects.end(); it++)
+	{
+		string parentName = (*it)->GetParentName();
+		if (!parentName.empty())
+		{
+			GameObject* parent = GetGameObject(parentName);
+			if (!m_Transforms.SetParent((*it)->GetTransformID(), parent->GetTransformID()))
+			{
+				printf("GAME OBJECT %s NOT ATTACHED TO %s\n", (*it)->GetName().c_str(), parentName.c_str());
+			}
+		}
+	}
+
 	//set up links between everything and GameObjects
+	//once they know what they are drawing, give their bounds to the TransformStore for culling
 	for (list<GameObject*>::iterator it = m_GameObjects.begin(); it != m_GameObjects.end(); it++)
 	{
 		(*it)->Init(this);
+
+		const Bounds* bounds = (*it)->GetLocalBounds();
+		if (bounds)
+		{
+			m_Transforms.SetLocalBounds((*it)->GetTransformID(), *bounds);
+		}
+	}
+}
+
+void Scene::AddPointLights(int _count, float _spread, float _range)
+{
+	std::mt19937 rng(_count);
+	std::uniform_real_distribution<float> place(-_spread, _spread);
+	std::uniform_real_distribution<float> colour(0.0f, 1.0f);
+
+	for (int i = 0; i < _count; i++)
+	{
+		Light* light = m_arena.New<Light>();
+		light->SetName("POINT_" + to_string(i));
+		light->SetPos(vec3(place(rng), place(rng), place(rng)));
+		light->SetCol(vec3(colour(rng), colour(rng), colour(rng)));
+		light->SetAmb(vec3(0.0f));
+		light->SetRange(_range);
+
+		m_Lights.push_back(light);
+		Register(m_LightRegistry, light->GetName(), light, "Light");
+	}
+	m_numLights += _count;
+}
+
+void Scene::AddCopies(const string& _GOName, int _count, float _spread)
+{
+	GameObject* original = GetGameObject(_GOName);
+	TransformID originalID = original->GetTransformID();
+
+	//same seed every time so runs can be compared
+	std::mt19937 rng(12345);
+	std::uniform_real_distribution<float> place(-_spread, _spread);
+	std::uniform_real_distribution<float> spin(-90.0f, 90.0f);
+
+	m_Transforms.Reserve(m_Transforms.Size() + _count);
+	for (int i = 0; i < _count; i++)
+	{
+		//copies come out already initialised, they just need somewhere of their own to be
+		GameObject* copy = original->Clone(m_arena);
+		copy->SetName(_GOName + "_" + to_string(i));
+
+		TransformID id = m_Transforms.Add();
+		copy->SetTransform(&m_Transforms, id);
+		m_Transforms.SetPos(id, vec3(place(rng), place(rng), place(rng)));
+		m_Transforms.SetRot(id, m_Transforms.GetRot(originalID));
+		m_Transforms.SetScale(id, m_Transforms.GetScale(originalID));
+		m_Transforms.SetRotIncr(id, vec3(spin(rng), spin(rng), spin(rng)));
+		m_Transforms.SetLocalBounds(id, m_Transforms.GetLocalBounds(originalID));
+
+		AddGameObject(copy);
 	}
+	m_numGameObjects += _count;
 }
 void Scene::setupCamera()
 {
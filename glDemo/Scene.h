@@ -4,6 +4,20 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include "NameRegistry.h"
+#include "TransformStore.h"
+#include "SceneStats.h"
+#include "WorkerPool.h"
+#include "Frustum.h"
+#include "BVH.h"
+#include "RenderQueue.h"
+#include "InstanceData.h"
+#include "MeshArena.h"
+#include "LightBuffer.h"
+#include "RenderCommandList.h"
+#include "FrameSnapshot.h"
+#include "SceneArena.h"
+#include <unordered_map>
 
 using namespace std;
 
@@ -14,7 +28,9 @@ class Model;
 class Texture;
 class Shader;
 
-//Note quite a proper scene graph but this contains data structures for all of our bits and pieces we want to draw
+//contains data structures for all of our bits and pieces we want to draw
+//GameObjects (and cameras) can be attached to a PARENT GameObject, their transforms then live in a hierarchy
+//inside m_Transforms which keeps world matrices up to date from the top down, see TransformStore.h
 class Scene
 {
 public:
@@ -24,22 +40,50 @@ public:
 	//tick all GOs
 	void Update(float _dt);
 
-	//add this GO to my list
+	//how many threads Update can use, 0 for one per hardware thread, 1 to keep everything on the main thread
+	void SetThreadCount(int _threads);
+	int GetThreadCount() const { return m_Workers ? m_Workers->NumThreads() : 1; }
+	WorkerPool* GetWorkers() const { return m_Workers; }
+
+	//add this GO to my list (and give it a transform if it doesn't have one yet)
 	void AddGameObject(GameObject* _new);
 
 	//return a pointer to a given thing by its name
-	GameObject* GetGameObject(string _GOName);
-	Camera* GetCamera(string _camName);
-	Light* GetLight(string _lightName);
-	Texture* GetTexture(string _texName);
-	Model* GetModel(string _modelName);
-	Shader* GetShader(string _shaderName);
+	GameObject* GetGameObject(const string& _GOName);
+	Camera* GetCamera(const string& _camName);
+	Light* GetLight(const string& _lightName);
+	Texture* GetTexture(const string& _texName);
+	Model* GetModel(const string& _modelName);
+	Shader* GetShader(const string& _shaderName);
+
+	//names are interned when they are loaded, so these are a single hash lookup
+	//hang on to the handle and the Get versions below never touch a string again
+	Handle<GameObject> FindGameObject(const string& _GOName) const { return m_GORegistry.Find(_GOName); }
+	Handle<Camera> FindCamera(const string& _camName) const { return m_CameraRegistry.Find(_camName); }
+	Handle<Light> FindLight(const string& _lightName) const { return m_LightRegistry.Find(_lightName); }
+	Handle<Texture> FindTexture(const string& _texName) const { return m_TextureRegistry.Find(_texName); }
+	Handle<Model> FindModel(const string& _modelName) const { return m_ModelRegistry.Find(_modelName); }
+	Handle<Shader> FindShader(const string& _shaderName) const { return m_ShaderRegistry.Find(_shaderName); }
+
+	GameObject* GetGameObject(Handle<GameObject> _handle) const { return m_GORegistry.Get(_handle); }
+	Camera* GetCamera(Handle<Camera> _handle) const { return m_CameraRegistry.Get(_handle); }
+	Light* GetLight(Handle<Light> _handle) const { return m_LightRegistry.Get(_handle); }
+	Texture* GetTexture(Handle<Texture> _handle) const { return m_TextureRegistry.Get(_handle); }
+	Model* GetModel(Handle<Model> _handle) const { return m_ModelRegistry.Get(_handle); }
+	Shader* GetShader(Handle<Shader> _handle) const { return m_ShaderRegistry.Get(_handle); }
 
 	//Render Everything
 	void Render();
 
-	//set up all shader uniform values for all of our lights
-	void SetShaderUniforms(GLuint _shaderprog);
+	//Render split in two so the drawing can happen on another thread, see RenderThread.h
+	//BuildSnapshot culls and sorts this frame and copies out everything drawing it needs, on the thread that runs Update
+	//RenderSnapshot draws one, on the thread with the GL context, splitting its work over _workers (which mustn't be busy with anything else)
+	//the two only share the GameObjects' shader / texture / model, so one frame can be drawn while the next is updated
+	void BuildSnapshot(FrameSnapshot& _snap);
+	void RenderSnapshot(FrameSnapshot& _snap, WorkerPool* _workers);
+
+	//sort key for a see-through object, furthest from the camera first
+	uint64_t TransparentKey(GameObject* _GO, const mat4& _view, float _farPlane);
 
 	//load from file
 	void Load(ifstream& _file);
@@ -47,6 +91,29 @@ public:
 	//initialise links between items in the scene
 	void Init();
 
+	//destroy everything loaded (GL resources included) ready for the next Load
+	//the memory is kept in the arena so loading again is quick, not while a RenderThread is drawing me
+	void Unload();
+
+	//where everything loaded lives, and how full each type's pool is
+	const SceneArena& GetArena() const { return m_arena; }
+
+	//stress testing: add _count copies of an already initialised GameObject scattered through a cube _spread either side of the origin
+	//they are called NAME_0, NAME_1 etc.
+	void AddCopies(const string& _GOName, int _count, float _spread);
+
+	//and _count randomly coloured point lights reaching _range from where they are
+	void AddPointLights(int _count, float _spread, float _range);
+
+	//what got updated / skipped this frame
+	const SceneStats& GetStats() const { return m_stats; }
+
+	//spatial queries against the bounding boxes of everything drawn in the scene
+	//every GameObject whose box touches the sphere
+	void FindGameObjects(const vec3& _centre, float _radius, std::vector<GameObject*>& _out);
+	//nearest GameObject whose box the ray hits, or nullptr, _hitDist is in multiples of _dir
+	GameObject* RayCast(const vec3& _origin, const vec3& _dir, float _maxDist, float* _hitDist = nullptr);
+
 	void setupCamera();
 
 	void setupMovement();
@@ -65,6 +132,9 @@ protected:
         Camera* GetActiveCamera() const {
             return m_useCamera;
         }
+	//every Camera, Light, Model, Texture, Shader and GameObject below was allocated out of here
+	SceneArena m_arena;
+
 	//data structures containing pointers to all our stuff
 	int m_numCameras = 0;
 	int m_numLights = 0;
@@ -79,6 +149,87 @@ protected:
 	std::list<Shader*>		m_Shaders;
 	std::list<GameObject*> m_GameObjects;
 
+	//name -> handle -> pointer lookups for all of the above
+	NameRegistry<Camera>		m_CameraRegistry;
+	NameRegistry<Light>			m_LightRegistry;
+	NameRegistry<Model>			m_ModelRegistry;
+	NameRegistry<Texture>		m_TextureRegistry;
+	NameRegistry<Shader>		m_ShaderRegistry;
+	NameRegistry<GameObject>	m_GORegistry;
+
+	//every GameObject's position, rotation, scale and world matrix, see TransformStore.h
+	TransformStore m_Transforms;
+
+	//threads for splitting up the per object work in Update, null means do it all on the main thread
+	//also used to decode the models and textures at the end of Load
+	WorkerPool* m_Workers = nullptr;
+
+	//read and upload the files behind every Model, Texture and Shader Load has parsed, see AssetLoader.h
+	void LoadAssets();
+
+	//what the current camera can see this frame, one entry per TransformID
+	Frustum m_frustum;
+	std::vector<uint8_t> m_visible;
+
+	//hierarchy over the world bounds in m_Transforms, refitted every Update and rebuilt when it gets too loose
+	BVH m_bvh;
+	bool m_bvhDirty = true;					//GameObjects have been added, build from scratch next Update
+	std::vector<uint32_t> m_queryResults;	//scratch space for BVH queries
+	std::vector<GameObject*> m_GOByTransform;	//TransformID -> GameObject, to turn query results back into objects
+
+	//BuildSnapshot side
+
+	//everything visible in the opaque pass this frame, sorted by shader / texture / mesh and then front to back
+	RenderQueue m_opaqueQueue;
+	std::vector<std::vector<RenderItem>> m_keyChunks;	//what each thread found to go in it, merged in order
+	std::vector<int> m_chunkCulled;						//and how many it culled
+
+	//everything visible in the transparent pass, back to front
+	//kept between frames as the order hardly changes, so it is refilled in last frame's order and just touched up
+	RenderQueue m_transparentQueue;
+	std::vector<GameObject*> m_transparentOrder;
+
+	//used for Render's own snapshot when there is no render thread
+	FrameSnapshot m_snapshot;
+
+	//RenderSnapshot side
+
+	//a run of the sorted opaque queue sharing instanced shader and texture
+	//instanced batches are one multi draw of m_numCommands commands starting at m_firstCommand in m_indirectBuffer
+	//m_firstSlot is where the first object's matrices go, in m_instanceData if instanced, otherwise counting object blocks
+	struct DrawBatch
+	{
+		size_t m_first;
+		size_t m_count;
+		size_t m_firstCommand;
+		size_t m_numCommands;
+		size_t m_firstSlot;
+		bool m_instanced;
+	};
+	std::vector<DrawBatch> m_batches;
+
+	//the opaque pass's draws, recorded a slice of the queue per thread and replayed in order on the GL thread
+	std::vector<RenderCommandList> m_commandLists;
+
+	//per instance matrices and multi draw commands for this frame's instanced batches, uploaded in one go before any of them are drawn
+	std::vector<InstanceData> m_instanceData;
+	std::vector<DrawElementsIndirectCommand> m_drawCommands;
+	GLuint m_instanceBuffer = 0;
+	GLuint m_indirectBuffer = 0;
+	size_t m_instanceBufferSize = 0; //in bytes
+	size_t m_indirectBufferSize = 0;
+
+	//every light packed up for the shaders, refilled when a snapshot's lights are newer than what was last uploaded
+	LightBuffer m_lightBuffer;
+	unsigned int m_uploadedLightsVersion = 0;
+
+	//sum of all light versions (plus how many there are), changes whenever any light does
+	//and when it does m_lightDataVersion goes up, so snapshots know to copy the lights again
+	unsigned int m_lightsVersion = 0;
+	unsigned int m_lightDataVersion = 1;
+
+	SceneStats m_stats;
+
 	Camera* m_useCamera = nullptr; //current main camera in use
 	int m_useCameraIndex = 0;
 	//TODO: pass down the same keyboard input from main so that we skip through all the cameras
@@ -0,0 +1,58 @@
+#include "SceneArena.h"
+#include <atomic>
+
+size_t SceneArena::NextTypeID()
+{
+	static atomic<size_t> next(0);
+	return next++;
+}
+
+void SceneArena::Clear()
+{
+	//GameObjects are loaded after the things they refer to, so go backwards
+	for (size_t i = m_pools.size(); i-- > 0; )
+	{
+		m_pools[i]->Clear();
+	}
+}
+
+void SceneArena::Release()
+{
+	for (size_t i = m_pools.size(); i-- > 0; )
+	{
+		delete m_pools[i];
+	}
+	m_pools.clear();
+	m_poolsByType.clear();
+}
+
+void SceneArena::GetStats(vector<PoolStats>& _out) const
+{
+	_out.clear();
+	for (size_t i = 0; i < m_pools.size(); i++)
+	{
+		_out.push_back(m_pools[i]->GetStats());
+	}
+}
+
+void SceneArena::PrintStats() const
+{
+	vector<PoolStats> stats;
+	GetStats(stats);
+	for (size_t i = 0; i < stats.size(); i++)
+	{
+		const PoolStats& pool = stats[i];
+		printf("%-24s %7zu live / %7zu slots  %5.1f%% full  %5.1f%% fragmented  %8zu KB\n", pool.m_type, pool.m_live, pool.m_capacity,
+			pool.Occupancy() * 100.0f, pool.Fragmentation() * 100.0f, pool.m_bytes / 1024);
+	}
+}
+
+size_t SceneArena::GetBytes() const
+{
+	size_t bytes = 0;
+	for (size_t i = 0; i < m_pools.size(); i++)
+	{
+		bytes += m_pools[i]->GetStats().m_bytes;
+	}
+	return bytes;
+}
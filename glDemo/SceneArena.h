@@ -0,0 +1,74 @@
+#pragma once
+#include "ObjectPool.h"
+#include <typeinfo>
+#include <vector>
+
+using namespace std;
+
+//everything a Scene loads lives in here, an ObjectPool per concrete type
+//so all the GameObjects of one class sit together in memory and unloading the lot is one Clear
+//the pools keep their memory between Clears, so loading the next manifest into the same arena barely allocates
+class SceneArena
+{
+public:
+
+	SceneArena() {}
+	~SceneArena() { Release(); }
+
+	//T has to be the actual class being made, the object is destroyed as a T
+	template<class T, class... Args>
+	T* New(Args&&... _args)
+	{
+		return Pool<T>().New(std::forward<Args>(_args)...);
+	}
+
+	//free one object early, _object has to have been made with New<T> for this same T
+	template<class T>
+	void Delete(T* _object)
+	{
+		Pool<T>().Delete(_object);
+	}
+
+	//destroy everything (most recently added types first), keeping the memory
+	void Clear();
+
+	//destroy everything and free the memory
+	void Release();
+
+	//one entry per type that has been allocated
+	void GetStats(vector<PoolStats>& _out) const;
+	void PrintStats() const;
+
+	//memory held by every pool
+	size_t GetBytes() const;
+
+protected:
+
+	//a small number for every type anything has made a pool of
+	static size_t NextTypeID();
+	template<class T>
+	static size_t TypeID()
+	{
+		static const size_t id = NextTypeID();
+		return id;
+	}
+
+	template<class T>
+	ObjectPool<T>& Pool()
+	{
+		size_t id = TypeID<T>();
+		if (id >= m_poolsByType.size())
+		{
+			m_poolsByType.resize(id + 1, nullptr);
+		}
+		if (!m_poolsByType[id])
+		{
+			m_poolsByType[id] = new ObjectPool<T>(typeid(T).name());
+			m_pools.push_back(m_poolsByType[id]);
+		}
+		return *(ObjectPool<T>*)m_poolsByType[id];
+	}
+
+	vector<PoolBase*> m_poolsByType;	//indexed by TypeID, null for types this arena hasn't made
+	vector<PoolBase*> m_pools;			//the same pools in the order they were made
+};
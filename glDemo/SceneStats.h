@@ -0,0 +1,53 @@
+#pragma once
+
+//counters for how much work the Scene did (and didn't have to do) this frame
+//reset at the start of every Scene::Update
+struct SceneStats
+{
+	//world matrices rebuilt / left alone because nothing had changed
+	int m_transformsUpdated = 0;
+	int m_transformsSkipped = 0;
+
+	//camera view matrices rebuilt / left alone
+	int m_camerasUpdated = 0;
+	int m_camerasSkipped = 0;
+
+	//camera uniform blocks written (one a frame)
+	int m_cameraUploads = 0;
+
+	//times the light buffer was refilled because a light changed
+	int m_lightUploads = 0;
+
+	//opaque GameObjects drawn / skipped because they were outside the camera's view
+	int m_objectsVisible = 0;
+	int m_objectsCulled = 0;
+
+	//see-through GameObjects drawn, and how many radix passes sorting them needed
+	//(0 when last frame's order only needed touching up)
+	int m_transparentVisible = 0;
+	int m_transparentSortPasses = 0;
+
+	//how many times the render queues switched shader program
+	int m_programBinds = 0;
+
+	//state changing GL calls made by Render / dropped by GLState because GL was already in that state
+	int m_glCallsIssued = 0;
+	int m_glCallsElided = 0;
+
+	//glGetUniformLocation calls while drawing the frame, 0 once every program has its UniformTable
+	int m_uniformLocationQueries = 0;
+
+	//draw calls issued, how many of them were multi draws out of the MeshArena
+	//and how many commands and objects those multi draws covered between them
+	int m_drawCalls = 0;
+	int m_indirectDraws = 0;
+	int m_indirectCommands = 0;
+	int m_instancesDrawn = 0;
+
+	//bounding volume hierarchy upkeep, and how many of its nodes culling and queries looked at
+	int m_bvhRefits = 0;
+	int m_bvhRebuilds = 0;
+	int m_bvhNodesVisited = 0;
+
+	void Reset() { *this = SceneStats(); }
+};
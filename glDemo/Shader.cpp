@@ -1,17 +1,39 @@
 #include "Shader.h"
 #include "shader_setup.h"
 #include "stringHelp.h"
+#include "UniformTable.h"
+#include "GLState.h"
 
 Shader::Shader(ifstream& _file)
 {
-	string fileNameV,fileNameF;
 	StringHelp::String(_file, "NAME", m_name);
-	StringHelp::String(_file, "VERTFILE", fileNameV);
-	StringHelp::String(_file, "FRAGFILE", fileNameF);
+	StringHelp::String(_file, "VERTFILE", m_vertFile);
+	StringHelp::String(_file, "FRAGFILE", m_fragFile);
 
-	m_shaderProg = setupShaders(fileNameV, fileNameF);
+	//optional instanced version of the vertex shader
+	StringHelp::OptionalString(_file, "INSTVERTFILE", m_instVertFile);
+}
+
+void Shader::Upload()
+{
+	m_shaderProg = setupShaders(m_vertFile, m_fragFile);
+
+	if (!m_instVertFile.empty())
+	{
+		m_instancedProg = setupShaders(m_instVertFile, m_fragFile);
+	}
 }
 
 Shader::~Shader()
 {
+	GLuint progs[2] = { m_shaderProg, m_instancedProg };
+	for (int i = 0; i < 2; i++)
+	{
+		if (progs[i])
+		{
+			UniformTable::Remove(progs[i]);
+			GLState::ForgetProgram(progs[i]);
+			glDeleteProgram(progs[i]);
+		}
+	}
 }
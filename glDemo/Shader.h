@@ -6,17 +6,29 @@ using namespace std;
 
 //simple data structure that loads and compiles a shader
 //from its description in the manifest and then links its GLuint handle to its name
+//the constructor only reads the manifest entry, Upload compiles and links the programs on the GL thread
 class Shader
 {
 public:
 	Shader(ifstream& _file);
 	~Shader();
 
+	void Upload();
+
 	GLuint GetProg() { return m_shaderProg; }
 	string GetName() { return m_name; }
 
+	//same fragment shader with a vertex shader that takes its model matrix per instance
+	//0 if the manifest didn't give an INSTVERTFILE, objects using this shader are then always drawn one at a time
+	GLuint GetInstancedProg() { return m_instancedProg; }
+
 protected:
 	string m_name;
-	GLuint m_shaderProg;
+	GLuint m_shaderProg = 0;
+	GLuint m_instancedProg = 0;
+
+	string m_vertFile;
+	string m_fragFile;
+	string m_instVertFile;
 
 };
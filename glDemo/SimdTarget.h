@@ -0,0 +1,12 @@
+#pragma once
+
+//MSVC lets us use any intrinsic anywhere, GCC and Clang need to be told per function
+//put these in front of any function using SSE4.1 or AVX2 intrinsics, and only call them after checking
+//TransformKernels::BestPath() says the CPU can run them
+#if defined(_MSC_VER)
+#define SIMD_TARGET_SSE4
+#define SIMD_TARGET_AVX2
+#else
+#define SIMD_TARGET_SSE4 __attribute__((target("sse4.1")))
+#define SIMD_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
@@ -1,14 +1,13 @@
 #include "Texture.h"
-#include "TextureLoader.h"
+#include "TextureCache.h"
 #include "stringHelp.h"
 
 Texture::Texture(ifstream& _file)
 {
 	string type;
-	string fileName;
 	StringHelp::String(_file, "TYPE", type);
 	StringHelp::String(_file, "NAME", m_name);
-	StringHelp::String(_file, "FILE", fileName);
+	StringHelp::String(_file, "FILE", m_fileName);
 	FREE_IMAGE_FORMAT format = FIF_UNKNOWN;
 
 	if (type == "FIF_BMP")
@@ -170,10 +169,20 @@ Texture::Texture(ifstream& _file)
 	}
 
 
-	m_texID = loadTexture(fileName, format);
+	m_format = format;
+}
+
+void Texture::Decode()
+{
+	TextureCache::Prefetch(m_fileName, m_format);
+}
+
+void Texture::Upload()
+{
+	m_texID = TextureCache::Acquire(m_fileName, m_format);
 }
 
 Texture::~Texture()
 {
-	//TODO: What should I really be doing here?
+	TextureCache::Release(m_texID);
 }
@@ -6,17 +6,25 @@ using namespace std;
 
 //simple data structure that loads a texture using FreeImage
 //from its description in the manifest and then links its GLuint handle to its name
+//the constructor only reads the manifest entry, Decode then reads the image (on any thread) and Upload makes the GL texture
+//both go through the TextureCache, so anything else using the same image shares one texture with me
 class Texture
 {
 public:
 	Texture(ifstream& _file);
 	~Texture();
 
+	void Decode();
+	void Upload();
+
 	GLuint GetTexID() { return m_texID; }
 	string GetName() { return m_name; }
 
 protected:
 	string m_name;
-	GLuint m_texID;
+	GLuint m_texID = 0;
+
+	string m_fileName;
+	FREE_IMAGE_FORMAT m_format = FIF_UNKNOWN;
 
 };
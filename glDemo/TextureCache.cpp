@@ -0,0 +1,297 @@
+#include "TextureCache.h"
+#include "TextureLoader.h"
+#include "TextureStreamer.h"
+#include "MappedFile.h"
+#include "GLState.h"
+#include <mutex>
+#include <condition_variable>
+#include <ctype.h>
+
+using namespace std;
+
+unordered_map<string, TextureCache::Entry*> TextureCache::s_byPath;
+unordered_map<string, TextureCache::Entry*> TextureCache::s_byContent;
+unordered_map<GLuint, TextureCache::Entry*> TextureCache::s_byTexture;
+
+unsigned int TextureCache::s_requests = 0;
+unsigned int TextureCache::s_pathHits = 0;
+unsigned int TextureCache::s_contentHits = 0;
+size_t TextureCache::s_bytesSaved = 0;
+
+static mutex s_mutex;
+static condition_variable s_decoded;	//an entry has finished decoding
+
+string TextureCache::CanonicalPath(const string& _path)
+{
+	//one kind of slash and only one at a time, the manifest doubles them up where main.cpp doesn't
+	string path;
+	for (char c : _path)
+	{
+		if (c == '/')
+		{
+			c = '\\';
+		}
+		//but leave the two at the start of a network path
+		if (c == '\\' && path.size() > 1 && path.back() == '\\')
+		{
+			continue;
+		}
+		path += c;
+	}
+
+	//absolute, with any . and .. worked out
+	char full[MAX_PATH];
+	DWORD length = GetFullPathNameA(path.c_str(), MAX_PATH, full, nullptr);
+	if (length && length < MAX_PATH)
+	{
+		path = full;
+	}
+
+	//windows doesn't care about case so neither do we
+	for (char& c : path)
+	{
+		c = (char)tolower((unsigned char)c);
+	}
+	return path;
+}
+
+string TextureCache::PathKey(const string& _path, FREE_IMAGE_FORMAT _format, GLint _filter, GLint _wrap)
+{
+	return CanonicalPath(_path) + "|" + to_string(_format) + "|" + to_string(_filter) + "|" + to_string(_wrap);
+}
+
+TextureCache::Entry* TextureCache::Find(const string& _pathKey, const string& _path, FREE_IMAGE_FORMAT _format, GLint _filter, GLint _wrap)
+{
+	{
+		lock_guard<mutex> lock(s_mutex);
+		unordered_map<string, Entry*>::iterator it = s_byPath.find(_pathKey);
+		if (it != s_byPath.end())
+		{
+			it->second->m_pins++;
+			return it->second;
+		}
+	}
+
+	//a name we haven't seen, but it could still be an image we have
+	//the file stays mapped to decode from, so hashing it and decoding it only read it from disk once
+	string contentKey;
+	MappedFile file;
+	if (file.Open(_path))
+	{
+		contentKey = to_string(file.Hash()) + ":" + to_string(file.GetSize()) + "|" + to_string(_format) + "|" + to_string(_filter) + "|" + to_string(_wrap);
+	}
+	else
+	{
+		//won't load, but requests for it while it is still here fail together without trying again
+		contentKey = "missing:" + _pathKey;
+	}
+
+	Entry* entry = nullptr;
+	{
+		lock_guard<mutex> lock(s_mutex);
+
+		//another thread may have got here first while we were hashing
+		unordered_map<string, Entry*>::iterator it = s_byPath.find(_pathKey);
+		if (it != s_byPath.end())
+		{
+			it->second->m_pins++;
+			return it->second;
+		}
+		it = s_byContent.find(contentKey);
+		if (it != s_byContent.end())
+		{
+			it->second->m_pathKeys.push_back(_pathKey);
+			it->second->m_pins++;
+			s_byPath[_pathKey] = it->second;
+			return it->second;
+		}
+
+		entry = new Entry;
+		entry->m_decoding = true;
+		entry->m_pins = 1;
+		entry->m_contentKey = contentKey;
+		entry->m_pathKeys.push_back(_pathKey);
+		s_byPath[_pathKey] = entry;
+		s_byContent[contentKey] = entry;
+	}
+
+	FIBITMAP* bitmap = file.IsOpen() ? decodeTexture(file.GetData(), (size_t)file.GetSize(), _format, _path) : decodeTexture(_path, _format);
+	file.Close();
+	{
+		lock_guard<mutex> lock(s_mutex);
+		entry->m_bitmap = bitmap;
+		entry->m_bytes = bitmap ? (size_t)FreeImage_GetWidth(bitmap) * FreeImage_GetHeight(bitmap) * 4 : 0;
+		entry->m_decoding = false;
+	}
+	s_decoded.notify_all();
+	return entry;
+}
+
+void TextureCache::Prefetch(const string& _path, FREE_IMAGE_FORMAT _format, GLint _filter, GLint _wrap)
+{
+	Entry* entry = Find(PathKey(_path, _format, _filter, _wrap), _path, _format, _filter, _wrap);
+
+	//left for the Acquire to come, or a Trim if it never does (not deleted here, this isn't the GL thread)
+	lock_guard<mutex> lock(s_mutex);
+	entry->m_pins--;
+}
+
+GLuint TextureCache::Acquire(const string& _path, FREE_IMAGE_FORMAT _format, GLint _filter, GLint _wrap)
+{
+	string pathKey = PathKey(_path, _format, _filter, _wrap);
+	Entry* entry = Find(pathKey, _path, _format, _filter, _wrap);
+
+	unique_lock<mutex> lock(s_mutex);
+	s_decoded.wait(lock, [entry] { return !entry->m_decoding; });
+	entry->m_pins--;
+	s_requests++;
+
+	if (entry->m_texID)
+	{
+		entry->m_refs++;
+		if (pathKey == entry->m_pathKeys[0])
+		{
+			s_pathHits++;
+		}
+		else
+		{
+			s_contentHits++;
+		}
+		s_bytesSaved += entry->m_bytes;
+		return entry->m_texID;
+	}
+
+	//first Acquire, make the texture (uploadTexture takes the bitmap off our hands)
+	if (entry->m_bitmap)
+	{
+		entry->m_texID = uploadTexture(entry->m_bitmap, _filter, _wrap);
+		entry->m_bitmap = nullptr;
+	}
+	if (!entry->m_texID)
+	{
+		//didn't load, nothing will ever Release it so it goes now unless another request is on its way
+		DestroyIfUnused(entry);
+		return 0;
+	}
+	entry->m_refs = 1;
+	s_byTexture[entry->m_texID] = entry;
+	return entry->m_texID;
+}
+
+void TextureCache::Release(GLuint _texID)
+{
+	if (!_texID)
+	{
+		return;
+	}
+
+	lock_guard<mutex> lock(s_mutex);
+	unordered_map<GLuint, Entry*>::iterator it = s_byTexture.find(_texID);
+	if (it == s_byTexture.end())
+	{
+		return;
+	}
+	it->second->m_refs--;
+	DestroyIfUnused(it->second);
+}
+
+void TextureCache::DestroyIfUnused(Entry* _entry)
+{
+	if (!_entry->m_refs && !_entry->m_pins && !_entry->m_decoding)
+	{
+		Destroy(_entry);
+	}
+}
+
+void TextureCache::Trim()
+{
+	lock_guard<mutex> lock(s_mutex);
+
+	//Destroy takes them out of s_byContent, so pick them out first
+	vector<Entry*> unused;
+	for (unordered_map<string, Entry*>::iterator it = s_byContent.begin(); it != s_byContent.end(); ++it)
+	{
+		if (!it->second->m_refs && !it->second->m_pins && !it->second->m_decoding)
+		{
+			unused.push_back(it->second);
+		}
+	}
+	for (Entry* entry : unused)
+	{
+		Destroy(entry);
+	}
+}
+
+void TextureCache::Destroy(Entry* _entry)
+{
+	for (const string& key : _entry->m_pathKeys)
+	{
+		s_byPath.erase(key);
+	}
+	s_byContent.erase(_entry->m_contentKey);
+	if (_entry->m_texID)
+	{
+		s_byTexture.erase(_entry->m_texID);
+		TextureStreamer::Cancel(_entry->m_texID);
+		GLState::ForgetTexture(_entry->m_texID);
+		glDeleteTextures(1, &_entry->m_texID);
+	}
+	if (_entry->m_bitmap)
+	{
+		FreeImage_Unload(_entry->m_bitmap);
+	}
+	delete _entry;
+}
+
+void TextureCache::Clear()
+{
+	lock_guard<mutex> lock(s_mutex);
+
+	size_t neverAcquired = 0;
+	for (unordered_map<string, Entry*>::iterator it = s_byContent.begin(); it != s_byContent.end(); ++it)
+	{
+		neverAcquired += it->second->m_bitmap ? 1 : 0;
+	}
+	if (neverAcquired)
+	{
+		printf("TEXTURE CACHE : %zu images were decoded but never used \n", neverAcquired);
+	}
+
+	//every entry is in here exactly once
+	while (!s_byContent.empty())
+	{
+		Destroy(s_byContent.begin()->second);
+	}
+}
+
+void TextureCache::PrintStats()
+{
+	lock_guard<mutex> lock(s_mutex);
+	unsigned int hits = s_pathHits + s_contentHits;
+	size_t waiting = 0;
+	for (unordered_map<string, Entry*>::iterator it = s_byContent.begin(); it != s_byContent.end(); ++it)
+	{
+		waiting += it->second->m_bitmap ? 1 : 0;
+	}
+	printf("TEXTURE CACHE : %u requests, %u shared an existing texture (%u same name, %u same image under another name), hit rate %.0f%%, %.1f MB of GPU memory saved, %zu textures held, %zu decoded but not Acquired yet\n",
+		s_requests, hits, s_pathHits, s_contentHits, s_requests ? 100.0 * hits / s_requests : 0.0, s_bytesSaved / (1024.0 * 1024.0), s_byTexture.size(), waiting);
+}
+
+size_t TextureCache::NumTextures()
+{
+	lock_guard<mutex> lock(s_mutex);
+	return s_byTexture.size();
+}
+
+size_t TextureCache::NumImages()
+{
+	lock_guard<mutex> lock(s_mutex);
+	return s_byContent.size();
+}
+
+void TextureCache::ResetStats()
+{
+	lock_guard<mutex> lock(s_mutex);
+	s_requests = s_pathHits = s_contentHits = 0;
+	s_bytesSaved = 0;
+}
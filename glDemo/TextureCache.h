@@ -0,0 +1,80 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+//one GL texture per image, however many things ask for it and under whatever name
+//an image is known by its canonical path (absolute, lower case, one kind of slash) plus its format, filter and wrap
+//a path not seen before is hashed, and if the bytes match an image already here it shares that one too
+//every Acquire adds a reference and every Release takes one away, the texture goes when the last one does
+//an image that fails to load goes as soon as nothing is waiting on it, one Prefetched but never Acquired stays until a Trim
+class TextureCache
+{
+public:
+
+	//decode the image ready for an Acquire later, unless it is already here or on its way
+	//safe to call from any thread, this is the slow part
+	static void Prefetch(const std::string& _path, FREE_IMAGE_FORMAT _format, GLint _filter = GL_LINEAR, GLint _wrap = GL_CLAMP);
+
+	//the shared texture for an image, made now if nothing has made it yet, 0 if it couldn't be loaded
+	//GL thread only, waits if another thread is still decoding it
+	static GLuint Acquire(const std::string& _path, FREE_IMAGE_FORMAT _format, GLint _filter = GL_LINEAR, GLint _wrap = GL_CLAMP);
+
+	//give back a texture from Acquire, anything the cache didn't make is left alone
+	static void Release(GLuint _texID);
+
+	//free every image nothing holds a reference to, ones Prefetched but never Acquired and textures nobody took back up
+	//GL thread only, call once a load's Acquires are all done
+	static void Trim();
+
+	//delete everything still here whoever is holding it, for shutdown while the GL context is still around
+	static void Clear();
+
+	//textures handed out and not all Released yet, and images held in all (decoded ones waiting for an Acquire too)
+	static size_t NumTextures();
+	static size_t NumImages();
+
+	//what "the same image" means, exposed for the curious
+	static std::string CanonicalPath(const std::string& _path);
+
+	//requests, how many shared an existing texture, and the decoding and GPU memory that saved
+	static void PrintStats();
+	static void ResetStats();
+
+protected:
+
+	struct Entry
+	{
+		GLuint m_texID = 0;
+		FIBITMAP* m_bitmap = nullptr;	//decoded, waiting for the first Acquire
+		bool m_decoding = false;		//another thread is decoding it, m_bitmap isn't there yet
+		int m_refs = 0;
+		int m_pins = 0;					//Finds whose Acquire or Prefetch hasn't finished with it yet, it can't go while there are any
+		size_t m_bytes = 0;				//in GPU memory
+		std::string m_contentKey;
+		std::vector<std::string> m_pathKeys;	//every name it has been asked for under
+	};
+
+	//canonical path plus everything else that makes two textures different
+	static std::string PathKey(const std::string& _path, FREE_IMAGE_FORMAT _format, GLint _filter, GLint _wrap);
+
+	//find or make the entry for an image, decoding it here if this is the first anyone has heard of it
+	//may return one still being decoded by another thread, and pins it until the caller is done with it
+	static Entry* Find(const std::string& _pathKey, const std::string& _path, FREE_IMAGE_FORMAT _format, GLint _filter, GLint _wrap);
+
+	static void Destroy(Entry* _entry);
+
+	//delete _entry if nothing is holding or waiting on it, s_mutex must be held
+	static void DestroyIfUnused(Entry* _entry);
+
+	static std::unordered_map<std::string, Entry*> s_byPath;
+	static std::unordered_map<std::string, Entry*> s_byContent;
+	static std::unordered_map<GLuint, Entry*> s_byTexture;
+
+	static unsigned int s_requests;
+	static unsigned int s_pathHits;		//asked for by the same name again
+	static unsigned int s_contentHits;	//a different name for an image already here
+	static size_t s_bytesSaved;			//GPU memory a texture per request would have needed on top
+};
@@ -1,5 +1,6 @@
 
 #include "TextureLoader.h"
+#include "TextureStreamer.h"
 
 using namespace std;
 
@@ -7,56 +8,61 @@ using namespace std;
 // Utility function to load an image using FreeImage, convert to 32 bits-per-pixel (bpp) and setup and return a new texture object based on this.
 GLuint loadTexture(string _filename, FREE_IMAGE_FORMAT _srcImageType) {
 
-	// Load and validate bitmap
-	FIBITMAP* loadedBitmap = FreeImage_Load(_srcImageType, _filename.c_str(), BMP_DEFAULT);
+	return uploadTexture(decodeTexture(_filename, _srcImageType));
+}
+
 
-	if (!loadedBitmap) 
+// Convert to RGBA format, taking the loaded bitmap
+static FIBITMAP* convertTo32Bits(FIBITMAP* _loadedBitmap, const string& _filename) {
+
+	if (!_loadedBitmap) 
 	{
 		cout << "FreeImage: Could not load image " << _filename << endl;
-		return 0;
+		return nullptr;
 	}
 
 	// Comvert to RGBA format
-	FIBITMAP* bitmap32bpp = FreeImage_ConvertTo32Bits(loadedBitmap);
-	FreeImage_Unload(loadedBitmap);
+	FIBITMAP* bitmap32bpp = FreeImage_ConvertTo32Bits(_loadedBitmap);
+	FreeImage_Unload(_loadedBitmap);
 
 	if (!bitmap32bpp) 
 	{
 		cout << "FreeImage: Conversion to 32 bits unsuccessful for image " << _filename << endl;
-		return 0;
+		return nullptr;
 	}
 
-	// Image loaded and converted - setup new texture object
-	GLuint newTexture = 0;
+	return bitmap32bpp;
+}
+
 
-	// If image loaded, setup new texture object in OpenGL
-	glGenTextures(1, &newTexture); // can create more than 1!
+FIBITMAP* decodeTexture(string _filename, FREE_IMAGE_FORMAT _srcImageType) {
+
+	// Load and validate bitmap
+	return convertTo32Bits(FreeImage_Load(_srcImageType, _filename.c_str(), BMP_DEFAULT), _filename);
+}
 
-	if (newTexture) 
+
+FIBITMAP* decodeTexture(const unsigned char* _data, size_t _size, FREE_IMAGE_FORMAT _srcImageType, const string& _name) {
+
+	// FreeImage only reads through the handle, the const is just lost on the way in
+	FIMEMORY* memory = FreeImage_OpenMemory((BYTE*)_data, (DWORD)_size);
+	FIBITMAP* loadedBitmap = memory ? FreeImage_LoadFromMemory(_srcImageType, memory, BMP_DEFAULT) : nullptr;
+	if (memory)
 	{
-		glBindTexture(GL_TEXTURE_2D, newTexture);
-
-		// Setup texture image properties
-		glTexImage2D(
-			GL_TEXTURE_2D,
-			0,
-			GL_RGBA,
-			FreeImage_GetWidth(bitmap32bpp),
-			FreeImage_GetHeight(bitmap32bpp),
-			0,
-			GL_BGRA,
-			GL_UNSIGNED_BYTE,
-			FreeImage_GetBits(bitmap32bpp));
-
-		// Setup texture filter and wrap properties
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+		FreeImage_CloseMemory(memory);
 	}
+	return convertTo32Bits(loadedBitmap, _name);
+}
+
+
+GLuint uploadTexture(FIBITMAP* _bitmap32bpp, GLint _filter, GLint _wrap) {
 
-	// Once the texture has been setup, the image data is copied into OpenGL.  We no longer need the originally loaded image
-	FreeImage_Unload(bitmap32bpp);
+	if (!_bitmap32bpp)
+	{
+		return 0;
+	}
 
-	return newTexture;
-}
\ No newline at end of file
+	// Setup a new texture object with the given filter and wrap properties
+	// the pixels are streamed into it over the next few frames through TextureStreamer's ring, which frees the image once they are all in
+	return TextureStreamer::Queue(_bitmap32bpp, _filter, _wrap);
+}
@@ -3,4 +3,14 @@
 #include "core.h"
 
 // Helper function for loading texture images from disk and setup a texture with defaut properties
+// every call makes a new texture, go through TextureCache to share one with anything else using the same image
 GLuint loadTexture(std::string _filename, FREE_IMAGE_FORMAT _srcImageType);
+
+// The same in two halves, decodeTexture reads the image into a 32 bpp bitmap without touching GL so it can run on any thread
+// uploadTexture then makes the texture object from it (on the GL thread) and takes the bitmap, 0 from either if it failed
+// the texture can be bound straight away but its pixels arrive over the following frames, see TextureStreamer.h
+FIBITMAP* decodeTexture(std::string _filename, FREE_IMAGE_FORMAT _srcImageType);
+
+// decodeTexture from an image already in memory (a MappedFile say), _name is only for the error messages
+FIBITMAP* decodeTexture(const unsigned char* _data, size_t _size, FREE_IMAGE_FORMAT _srcImageType, const std::string& _name);
+GLuint uploadTexture(FIBITMAP* _bitmap32bpp, GLint _filter = GL_LINEAR, GLint _wrap = GL_CLAMP);
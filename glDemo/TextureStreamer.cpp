@@ -0,0 +1,371 @@
+#include "TextureStreamer.h"
+#include "WorkerPool.h"
+#include "GLState.h"
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+
+GLuint TextureStreamer::s_buffer = 0;
+unsigned char* TextureStreamer::s_mapped = nullptr;
+size_t TextureStreamer::s_head = 0;
+size_t TextureStreamer::s_used = 0;
+size_t TextureStreamer::s_frameBudget = 8 * 1024 * 1024;
+deque<TextureStreamer::Region> TextureStreamer::s_regions;
+deque<TextureStreamer::Pending> TextureStreamer::s_queue;
+vector<TextureStreamer::Band> TextureStreamer::s_bands;
+vector<TextureStreamer::Copy> TextureStreamer::s_copies;
+
+size_t TextureStreamer::s_bytesStreamed = 0;
+size_t TextureStreamer::s_texturesDone = 0;
+size_t TextureStreamer::s_framesStreaming = 0;
+size_t TextureStreamer::s_framesRingFull = 0;
+size_t TextureStreamer::s_largestFrame = 0;
+
+//what a texture shows until its rows arrive, BGRA
+static const unsigned char NEUTRAL_TEXEL[4] = { 128, 128, 128, 255 };
+
+void TextureStreamer::Create()
+{
+	//mapped once for good, coherent so the rows we memcpy in are visible to the glTexSubImage2Ds that follow
+	const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+	glGenBuffers(1, &s_buffer);
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, s_buffer);
+	glBufferStorage(GL_PIXEL_UNPACK_BUFFER, RING_BYTES, nullptr, flags);
+	s_mapped = (unsigned char*)glMapBufferRange(GL_PIXEL_UNPACK_BUFFER, 0, RING_BYTES, flags);
+
+	//left bound, every other glTexImage2D would read from it rather than from client memory
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	s_head = 0;
+	s_used = 0;
+}
+
+GLuint TextureStreamer::Queue(FIBITMAP* _bitmap32bpp, GLint _filter, GLint _wrap)
+{
+	if (!_bitmap32bpp)
+	{
+		return 0;
+	}
+
+	GLuint newTexture = 0;
+	glGenTextures(1, &newTexture);
+	if (!newTexture)
+	{
+		FreeImage_Unload(_bitmap32bpp);
+		return 0;
+	}
+
+	Pending pending;
+	pending.m_texID = newTexture;
+	pending.m_bitmap = _bitmap32bpp;
+	pending.m_width = FreeImage_GetWidth(_bitmap32bpp);
+	pending.m_height = FreeImage_GetHeight(_bitmap32bpp);
+	pending.m_pitch = FreeImage_GetPitch(_bitmap32bpp);
+	pending.m_nextRow = 0;
+	if (!pending.m_width)
+	{
+		pending.m_height = 0;
+	}
+
+	//storage now so the texture can be bound straight away, the pixels follow over the next few frames
+	GLState::BindTexture(newTexture);
+	if (pending.m_width && pending.m_height)
+	{
+		glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, pending.m_width, pending.m_height);
+		glClearTexImage(newTexture, 0, GL_BGRA, GL_UNSIGNED_BYTE, NEUTRAL_TEXEL);
+	}
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, _filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, _filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, _wrap);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, _wrap);
+
+	//32 bpp rows are always a multiple of 4 bytes, so FreeImage packs them with nothing in between
+	assert(pending.m_pitch == pending.m_width * 4);
+
+	s_queue.push_back(pending);
+	return newTexture;
+}
+
+void TextureStreamer::Update(WorkerPool* _pool)
+{
+	if (!s_frameBudget)
+	{
+		Flush(_pool);
+		return;
+	}
+	Stream(_pool, s_frameBudget, false);
+}
+
+void TextureStreamer::Flush(WorkerPool* _pool)
+{
+	Stream(_pool, 0, true);
+}
+
+void TextureStreamer::Cancel(GLuint _texID)
+{
+	for (deque<Pending>::iterator it = s_queue.begin(); it != s_queue.end(); ++it)
+	{
+		if (it->m_texID == _texID)
+		{
+			FreeImage_Unload(it->m_bitmap);
+			s_queue.erase(it);
+			return;
+		}
+	}
+}
+
+bool TextureStreamer::Retire(bool _wait)
+{
+	bool retired = false;
+	while (!s_regions.empty())
+	{
+		Region& oldest = s_regions.front();
+		GLenum result = glClientWaitSync(oldest.m_fence, GL_SYNC_FLUSH_COMMANDS_BIT, _wait ? 1000000 : 0);
+		if (result == GL_TIMEOUT_EXPIRED && _wait)
+		{
+			continue;
+		}
+		if (result == GL_WAIT_FAILED)
+		{
+			printf("TEXTURE STREAMING : WAITING ON A FENCE FAILED \n");
+			break;
+		}
+		if (result != GL_ALREADY_SIGNALED && result != GL_CONDITION_SATISFIED)
+		{
+			break;
+		}
+
+		s_used -= oldest.m_bytes;
+		glDeleteSync(oldest.m_fence);
+		s_regions.pop_front();
+
+		//only ever block for one, anything else finished is just a bonus
+		_wait = false;
+		retired = true;
+	}
+
+	//nothing in flight, start from the beginning so the next big band doesn't have to wrap
+	if (s_regions.empty())
+	{
+		s_head = 0;
+		s_used = 0;
+	}
+	return retired;
+}
+
+bool TextureStreamer::Allocate(size_t _bytes, size_t& _offset)
+{
+	size_t start = (s_head + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+	size_t skipped = start - s_head;
+	if (start + _bytes > RING_BYTES)
+	{
+		//doesn't fit before the end, skip what is left and go round to the start
+		start = 0;
+		skipped = RING_BYTES - s_head;
+	}
+
+	//the bytes in use run from s_head - s_used round to s_head, so this much more is free
+	if (s_used + skipped + _bytes > RING_BYTES)
+	{
+		return false;
+	}
+
+	s_used += skipped + _bytes;
+	s_head = start + _bytes;
+	_offset = start;
+	return true;
+}
+
+void TextureStreamer::Stream(WorkerPool* _pool, size_t _budget, bool _wait)
+{
+	if (s_queue.empty())
+	{
+		return;
+	}
+	if (!s_buffer)
+	{
+		Create();
+	}
+
+	Retire(false);
+
+	size_t staged = 0;
+	size_t regionBytes = 0;
+	bool ringFull = false;
+	s_bands.clear();
+
+	for (size_t i = 0; i < s_queue.size() && !ringFull; i++)
+	{
+		Pending& pending = s_queue[i];
+		while (pending.m_nextRow < pending.m_height)
+		{
+			//as many rows as the budget, the band limit and what is left of the texture allow
+			size_t rows = pending.m_height - pending.m_nextRow;
+			rows = min(rows, max<size_t>(1, MAX_BAND_BYTES / pending.m_pitch));
+			if (_budget)
+			{
+				size_t allowed = staged < _budget ? (_budget - staged) / pending.m_pitch : 0;
+				if (!allowed && staged)
+				{
+					break;
+				}
+
+				//always at least a row a frame, however small the budget
+				rows = min(rows, max<size_t>(1, allowed));
+			}
+			size_t bytes = rows * pending.m_pitch;
+
+			size_t before = s_used;
+			size_t offset = 0;
+			if (!Allocate(bytes, offset))
+			{
+				if (!_wait)
+				{
+					ringFull = true;
+					break;
+				}
+
+				//send off what we have so far so waiting on the GPU can free up the ring for the rest
+				if (!s_bands.empty())
+				{
+					Submit(_pool, regionBytes);
+					regionBytes = 0;
+					i -= DropFinished();
+				}
+
+				//if that frees nothing, waiting again won't either, so leave the rest for next time
+				if (!Retire(true))
+				{
+					ringFull = true;
+					break;
+				}
+				continue;
+			}
+			regionBytes += s_used - before;
+
+			Band band;
+			band.m_texID = pending.m_texID;
+			band.m_src = FreeImage_GetBits(pending.m_bitmap) + (size_t)pending.m_nextRow * pending.m_pitch;
+			band.m_offset = offset;
+			band.m_firstRow = pending.m_nextRow;
+			band.m_numRows = (unsigned int)rows;
+			band.m_width = pending.m_width;
+			band.m_pitch = pending.m_pitch;
+			s_bands.push_back(band);
+
+			pending.m_nextRow += (unsigned int)rows;
+			staged += bytes;
+		}
+
+		//over budget
+		if (pending.m_nextRow < pending.m_height && !ringFull)
+		{
+			break;
+		}
+	}
+
+	if (!s_bands.empty())
+	{
+		Submit(_pool, regionBytes);
+	}
+	DropFinished();
+
+	if (staged)
+	{
+		s_bytesStreamed += staged;
+		s_framesStreaming++;
+		s_largestFrame = max(s_largestFrame, staged);
+	}
+	if (ringFull)
+	{
+		s_framesRingFull++;
+	}
+}
+
+void TextureStreamer::Submit(WorkerPool* _pool, size_t _bytes)
+{
+	//cut the bands into pieces for the workers to copy into the ring
+	s_copies.clear();
+	for (const Band& band : s_bands)
+	{
+		size_t size = (size_t)band.m_numRows * band.m_pitch;
+		for (size_t done = 0; done < size; done += COPY_CHUNK)
+		{
+			Copy copy;
+			copy.m_dst = s_mapped + band.m_offset + done;
+			copy.m_src = band.m_src + done;
+			copy.m_bytes = size - done < COPY_CHUNK ? size - done : COPY_CHUNK;
+			s_copies.push_back(copy);
+		}
+	}
+	WorkerPool::ParallelFor(_pool, s_copies.size(), 1, [](size_t _begin, size_t _end, size_t)
+	{
+		for (size_t i = _begin; i < _end; i++)
+		{
+			memcpy(s_copies[i].m_dst, s_copies[i].m_src, s_copies[i].m_bytes);
+		}
+	});
+
+	//with the unpack buffer bound the data argument is an offset into it
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, s_buffer);
+	for (const Band& band : s_bands)
+	{
+		GLState::BindTexture(band.m_texID);
+		glTexSubImage2D(GL_TEXTURE_2D, 0, 0, band.m_firstRow, band.m_width, band.m_numRows, GL_BGRA, GL_UNSIGNED_BYTE, (const void*)band.m_offset);
+	}
+	GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	Region region;
+	region.m_bytes = _bytes;
+	region.m_fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	s_regions.push_back(region);
+	s_bands.clear();
+}
+
+size_t TextureStreamer::DropFinished()
+{
+	size_t dropped = 0;
+	while (!s_queue.empty() && s_queue.front().m_nextRow >= s_queue.front().m_height)
+	{
+		//glTexSubImage2D has already copied out of the ring, and the ring is all the GPU reads, so the bitmap can go
+		FreeImage_Unload(s_queue.front().m_bitmap);
+		s_queue.pop_front();
+		s_texturesDone++;
+		dropped++;
+	}
+	return dropped;
+}
+
+void TextureStreamer::PrintStats()
+{
+	const double MB = 1024.0 * 1024.0;
+	printf("TEXTURE STREAMING : %zu textures %.1f MB over %zu frames (most in one frame %.1f MB, budget %.1f MB), ring full %zu frames, %zu still queued\n",
+		s_texturesDone, s_bytesStreamed / MB, s_framesStreaming, s_largestFrame / MB, s_frameBudget / MB, s_framesRingFull, s_queue.size());
+}
+
+void TextureStreamer::Release()
+{
+	while (!s_queue.empty())
+	{
+		FreeImage_Unload(s_queue.front().m_bitmap);
+		s_queue.pop_front();
+	}
+	while (!s_regions.empty())
+	{
+		glDeleteSync(s_regions.front().m_fence);
+		s_regions.pop_front();
+	}
+	if (s_buffer)
+	{
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, s_buffer);
+		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+		GLState::BindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		GLState::ForgetBuffer(s_buffer);
+		glDeleteBuffers(1, &s_buffer);
+		s_buffer = 0;
+		s_mapped = nullptr;
+	}
+	s_head = 0;
+	s_used = 0;
+}
@@ -0,0 +1,122 @@
+#pragma once
+#include "core.h"
+#include <deque>
+#include <vector>
+
+class WorkerPool;
+
+//fills textures from decoded images a band of rows at a time instead of in one blocking glTexImage2D
+//the rows go through one persistently mapped pixel unpack buffer used as a ring, then glTexSubImage2D copies them into the texture
+//everything staged in a frame is fenced off together, and that part of the ring isn't written again until the GPU is past the fence
+//each frame only moves up to a byte budget, so a 4k texture arrives over a few frames rather than stalling one of them
+//a texture starts out mid grey, so until its last band is in the rows still to come show as grey rather than whatever was in memory
+class TextureStreamer
+{
+public:
+
+	//make the texture object for a 32 bpp bitmap and queue its pixels, the streamer frees the bitmap once it is all uploaded
+	//GL thread only, 0 if _bitmap32bpp is null
+	static GLuint Queue(FIBITMAP* _bitmap32bpp, GLint _filter = GL_LINEAR, GLint _wrap = GL_CLAMP);
+
+	//stage and upload this frame's share of the queue, call once a frame on the GL thread
+	//the copies into the ring are split across _pool (nullptr does them here)
+	static void Update(WorkerPool* _pool);
+
+	//upload everything queued right now whatever the budget, waiting on the GPU if the ring is full
+	//what Update does with no budget, if the GPU can't be waited on the rest is left for the next call
+	static void Flush(WorkerPool* _pool);
+
+	//stop streaming into _texID, for when it is deleted before it has finished
+	static void Cancel(GLuint _texID);
+
+	//bytes staged per frame at most, 0 to Flush everything in the next Update (-texbudget MB)
+	static void SetFrameBudget(size_t _bytes) { s_frameBudget = _bytes; }
+	static size_t GetFrameBudget() { return s_frameBudget; }
+
+	//textures still waiting for some of their pixels
+	static size_t NumQueued() { return s_queue.size(); }
+
+	static void PrintStats();
+
+	static void Release();
+
+protected:
+
+	//a texture on its way up, m_nextRow is the first row not staged yet
+	struct Pending
+	{
+		GLuint m_texID;
+		FIBITMAP* m_bitmap;
+		unsigned int m_width;
+		unsigned int m_height;
+		unsigned int m_pitch;
+		unsigned int m_nextRow;
+	};
+
+	//a part of the ring the GPU may still be reading, one per frame that staged anything
+	struct Region
+	{
+		size_t m_bytes;		//including anything skipped at the end of the ring when it wrapped
+		GLsync m_fence;
+	};
+
+	//rows of one texture staged this frame
+	struct Band
+	{
+		GLuint m_texID;
+		const unsigned char* m_src;
+		size_t m_offset;	//into the ring
+		unsigned int m_firstRow;
+		unsigned int m_numRows;
+		unsigned int m_width;
+		unsigned int m_pitch;
+	};
+
+	//a piece of a band for one worker to memcpy into the ring
+	struct Copy
+	{
+		unsigned char* m_dst;
+		const unsigned char* m_src;
+		size_t m_bytes;
+	};
+
+	static void Create();
+
+	//give back regions the GPU has finished with, _wait blocks on the oldest one if none have finished
+	//false if nothing could be given back (nothing in flight, or waiting failed)
+	static bool Retire(bool _wait);
+
+	//_bytes of the ring, or false if that much isn't free yet
+	static bool Allocate(size_t _bytes, size_t& _offset);
+
+	//stage and upload up to _budget bytes (0 no limit), waiting for room rather than stopping if _wait
+	static void Stream(WorkerPool* _pool, size_t _budget, bool _wait);
+
+	//copy s_bands into the ring, upload them from it and fence off the _bytes of ring they used
+	static void Submit(WorkerPool* _pool, size_t _bytes);
+
+	//free and drop the textures at the front of the queue that are all uploaded, returns how many went
+	static size_t DropFinished();
+
+	static const size_t RING_BYTES = 32 * 1024 * 1024;
+	static const size_t ROW_ALIGNMENT = 64;		//start of each band in the ring
+	static const size_t MAX_BAND_BYTES = RING_BYTES / 4;	//so the ring always holds a few frames' worth
+	static const size_t COPY_CHUNK = 256 * 1024;
+
+	static GLuint s_buffer;
+	static unsigned char* s_mapped;
+	static size_t s_head;			//next byte to write
+	static size_t s_used;			//bytes from the oldest region up to s_head
+	static size_t s_frameBudget;
+	static std::deque<Region> s_regions;
+	static std::deque<Pending> s_queue;
+	static std::vector<Band> s_bands;
+	static std::vector<Copy> s_copies;
+
+	//how it has gone so far
+	static size_t s_bytesStreamed;
+	static size_t s_texturesDone;
+	static size_t s_framesStreaming;	//frames that staged anything
+	static size_t s_framesRingFull;		//frames that stopped short because the GPU still had the ring
+	static size_t s_largestFrame;		//most bytes staged in one frame
+};
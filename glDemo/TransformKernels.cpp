@@ -0,0 +1,385 @@
+#include "TransformKernels.h"
+#include "SimdTarget.h"
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+
+//-1 until BestPath has looked at the CPU
+static int s_bestPath = -1;
+static TransformKernels::Path s_path = TransformKernels::PATH_COUNT;
+
+//polynomial coefficients for sin and cos on [-pi/4, pi/4] (from Cephes sinf / cosf)
+static const float SIN_C0 = -1.6666654611e-1f;
+static const float SIN_C1 = 8.3321608736e-3f;
+static const float SIN_C2 = -1.9515295891e-4f;
+static const float COS_C0 = 4.166664568298827e-2f;
+static const float COS_C1 = -1.388731625493765e-3f;
+static const float COS_C2 = 2.443315711809948e-5f;
+
+static const float DEG_TO_RAD = 0.01745329251994329577f;
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Scalar path
+/////////////////////////////////////////////////////////////////////////////////////
+
+//sine and cosine of an angle in degrees
+//wrap to [-180, 180], pick the nearest quarter turn, and evaluate the polynomials on what is left
+static inline void SinCosDeg(float _deg, float& _s, float& _c)
+{
+	float deg = _deg - 360.0f * nearbyintf(_deg * (1.0f / 360.0f));
+	float q = nearbyintf(deg * (1.0f / 90.0f));
+	float r = (deg - q * 90.0f) * DEG_TO_RAD;
+	int quadrant = (int)q;
+
+	float r2 = r * r;
+	float sr = r + r * r2 * (SIN_C0 + r2 * (SIN_C1 + r2 * SIN_C2));
+	float cr = 1.0f - 0.5f * r2 + r2 * r2 * (COS_C0 + r2 * (COS_C1 + r2 * COS_C2));
+
+	//odd quarter turns swap sin and cos, and the sign follows the quadrant
+	float s = (quadrant & 1) ? cr : sr;
+	float c = (quadrant & 1) ? sr : cr;
+	_s = (quadrant & 2) ? -s : s;
+	_c = ((quadrant + 1) & 2) ? -c : c;
+}
+
+static inline void ComposeOne(const vec3& _pos, const vec3& _rot, const vec3& _scale, mat4& _out)
+{
+	float sx, cx, sy, cy, sz, cz;
+	SinCosDeg(_rot.x, sx, cx);
+	SinCosDeg(_rot.y, sy, cy);
+	SinCosDeg(_rot.z, sz, cz);
+
+	//columns of Rx * Ry * Rz, each scaled by the matching axis of scale
+	_out[0] = vec4(cy * cz * _scale.x, (cx * sz + sx * sy * cz) * _scale.x, (sx * sz - cx * sy * cz) * _scale.x, 0.0f);
+	_out[1] = vec4(-cy * sz * _scale.y, (cx * cz - sx * sy * sz) * _scale.y, (sx * cz + cx * sy * sz) * _scale.y, 0.0f);
+	_out[2] = vec4(sy * _scale.z, -sx * cy * _scale.z, cx * cy * _scale.z, 0.0f);
+	_out[3] = vec4(_pos, 1.0f);
+}
+
+//_indices picks which objects to build, nullptr means all of 0.._count-1
+static void ComposeScalar(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, const uint32_t* _indices, size_t _count)
+{
+	for (size_t i = 0; i < _count; i++)
+	{
+		size_t id = _indices ? _indices[i] : i;
+		ComposeOne(_pos[id], _rot[id], _scale[id], _out[id]);
+	}
+}
+
+//which object each SIMD lane works on
+//the last batch may be short, the spare lanes repeat the final object and don't get stored
+template<int LANES>
+static inline int FillLanes(size_t* _lane, const uint32_t* _indices, size_t _first, size_t _count)
+{
+	int lanes = (int)((_count - _first) < LANES ? (_count - _first) : LANES);
+	for (int l = 0; l < LANES; l++)
+	{
+		size_t i = _first + (l < lanes ? l : lanes - 1);
+		_lane[l] = _indices ? _indices[i] : i;
+	}
+	return lanes;
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// SSE4 path - four objects per iteration, one object per lane
+/////////////////////////////////////////////////////////////////////////////////////
+
+SIMD_TARGET_SSE4 static inline void SinCosDeg4(__m128 _deg, __m128& _s, __m128& _c)
+{
+	const int nearest = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+	__m128 turns = _mm_round_ps(_mm_mul_ps(_deg, _mm_set1_ps(1.0f / 360.0f)), nearest);
+	__m128 deg = _mm_sub_ps(_deg, _mm_mul_ps(turns, _mm_set1_ps(360.0f)));
+	__m128 q = _mm_round_ps(_mm_mul_ps(deg, _mm_set1_ps(1.0f / 90.0f)), nearest);
+	__m128 r = _mm_mul_ps(_mm_sub_ps(deg, _mm_mul_ps(q, _mm_set1_ps(90.0f))), _mm_set1_ps(DEG_TO_RAD));
+	__m128i quadrant = _mm_cvtps_epi32(q);
+
+	__m128 r2 = _mm_mul_ps(r, r);
+
+	__m128 sp = _mm_add_ps(_mm_set1_ps(SIN_C1), _mm_mul_ps(r2, _mm_set1_ps(SIN_C2)));
+	sp = _mm_add_ps(_mm_set1_ps(SIN_C0), _mm_mul_ps(r2, sp));
+	__m128 sr = _mm_add_ps(r, _mm_mul_ps(_mm_mul_ps(r, r2), sp));
+
+	__m128 cp = _mm_add_ps(_mm_set1_ps(COS_C1), _mm_mul_ps(r2, _mm_set1_ps(COS_C2)));
+	cp = _mm_add_ps(_mm_set1_ps(COS_C0), _mm_mul_ps(r2, cp));
+	__m128 cr = _mm_add_ps(_mm_sub_ps(_mm_set1_ps(1.0f), _mm_mul_ps(_mm_set1_ps(0.5f), r2)), _mm_mul_ps(_mm_mul_ps(r2, r2), cp));
+
+	const __m128i one = _mm_set1_epi32(1);
+	const __m128i two = _mm_set1_epi32(2);
+	__m128 swap = _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(quadrant, one), one));
+	__m128 sinSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(quadrant, two), 30));
+	__m128 cosSign = _mm_castsi128_ps(_mm_slli_epi32(_mm_and_si128(_mm_add_epi32(quadrant, one), two), 30));
+
+	_s = _mm_xor_ps(_mm_blendv_ps(sr, cr, swap), sinSign);
+	_c = _mm_xor_ps(_mm_blendv_ps(cr, sr, swap), cosSign);
+}
+
+//transpose four 4-lane registers so each holds one object's column and store them
+SIMD_TARGET_SSE4 static inline void StoreColumn4(__m128 _x, __m128 _y, __m128 _z, __m128 _w, mat4* _out, const size_t* _lane, int _column, int _lanes)
+{
+	_MM_TRANSPOSE4_PS(_x, _y, _z, _w);
+	__m128 cols[4] = { _x, _y, _z, _w };
+	for (int lane = 0; lane < _lanes; lane++)
+	{
+		_mm_storeu_ps(&_out[_lane[lane]][_column][0], cols[lane]);
+	}
+}
+
+//gather one component of four vec3s into a register
+SIMD_TARGET_SSE4 static inline __m128 Load4(const vec3* _src, const size_t* _lane, int _component)
+{
+	return _mm_setr_ps(_src[_lane[0]][_component], _src[_lane[1]][_component], _src[_lane[2]][_component], _src[_lane[3]][_component]);
+}
+
+SIMD_TARGET_SSE4 static void ComposeSSE4(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, const uint32_t* _indices, size_t _count)
+{
+	for (size_t i = 0; i < _count; i += 4)
+	{
+		size_t lane[4];
+		int lanes = FillLanes<4>(lane, _indices, i, _count);
+
+		__m128 sx, cx, sy, cy, sz, cz;
+		SinCosDeg4(Load4(_rot, lane, 0), sx, cx);
+		SinCosDeg4(Load4(_rot, lane, 1), sy, cy);
+		SinCosDeg4(Load4(_rot, lane, 2), sz, cz);
+
+		__m128 scx = Load4(_scale, lane, 0);
+		__m128 scy = Load4(_scale, lane, 1);
+		__m128 scz = Load4(_scale, lane, 2);
+
+		__m128 sxsy = _mm_mul_ps(sx, sy);
+		__m128 cxsy = _mm_mul_ps(cx, sy);
+		__m128 zero = _mm_setzero_ps();
+
+		//column 0
+		__m128 m00 = _mm_mul_ps(_mm_mul_ps(cy, cz), scx);
+		__m128 m10 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(cx, sz), _mm_mul_ps(sxsy, cz)), scx);
+		__m128 m20 = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(sx, sz), _mm_mul_ps(cxsy, cz)), scx);
+		StoreColumn4(m00, m10, m20, zero, _out, lane, 0, lanes);
+
+		//column 1
+		__m128 m01 = _mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(cy, sz)), scy);
+		__m128 m11 = _mm_mul_ps(_mm_sub_ps(_mm_mul_ps(cx, cz), _mm_mul_ps(sxsy, sz)), scy);
+		__m128 m21 = _mm_mul_ps(_mm_add_ps(_mm_mul_ps(sx, cz), _mm_mul_ps(cxsy, sz)), scy);
+		StoreColumn4(m01, m11, m21, zero, _out, lane, 1, lanes);
+
+		//column 2
+		__m128 m02 = _mm_mul_ps(sy, scz);
+		__m128 m12 = _mm_mul_ps(_mm_sub_ps(zero, _mm_mul_ps(sx, cy)), scz);
+		__m128 m22 = _mm_mul_ps(_mm_mul_ps(cx, cy), scz);
+		StoreColumn4(m02, m12, m22, zero, _out, lane, 2, lanes);
+
+		//column 3 is just the position
+		StoreColumn4(Load4(_pos, lane, 0), Load4(_pos, lane, 1), Load4(_pos, lane, 2), _mm_set1_ps(1.0f), _out, lane, 3, lanes);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// AVX2 path - eight objects per iteration
+/////////////////////////////////////////////////////////////////////////////////////
+
+SIMD_TARGET_AVX2 static inline void SinCosDeg8(__m256 _deg, __m256& _s, __m256& _c)
+{
+	const int nearest = _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC;
+
+	__m256 turns = _mm256_round_ps(_mm256_mul_ps(_deg, _mm256_set1_ps(1.0f / 360.0f)), nearest);
+	__m256 deg = _mm256_sub_ps(_deg, _mm256_mul_ps(turns, _mm256_set1_ps(360.0f)));
+	__m256 q = _mm256_round_ps(_mm256_mul_ps(deg, _mm256_set1_ps(1.0f / 90.0f)), nearest);
+	__m256 r = _mm256_mul_ps(_mm256_sub_ps(deg, _mm256_mul_ps(q, _mm256_set1_ps(90.0f))), _mm256_set1_ps(DEG_TO_RAD));
+	__m256i quadrant = _mm256_cvtps_epi32(q);
+
+	__m256 r2 = _mm256_mul_ps(r, r);
+
+	__m256 sp = _mm256_add_ps(_mm256_set1_ps(SIN_C1), _mm256_mul_ps(r2, _mm256_set1_ps(SIN_C2)));
+	sp = _mm256_add_ps(_mm256_set1_ps(SIN_C0), _mm256_mul_ps(r2, sp));
+	__m256 sr = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r, r2), sp));
+
+	__m256 cp = _mm256_add_ps(_mm256_set1_ps(COS_C1), _mm256_mul_ps(r2, _mm256_set1_ps(COS_C2)));
+	cp = _mm256_add_ps(_mm256_set1_ps(COS_C0), _mm256_mul_ps(r2, cp));
+	__m256 cr = _mm256_add_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), _mm256_mul_ps(_mm256_set1_ps(0.5f), r2)), _mm256_mul_ps(_mm256_mul_ps(r2, r2), cp));
+
+	const __m256i one = _mm256_set1_epi32(1);
+	const __m256i two = _mm256_set1_epi32(2);
+	__m256 swap = _mm256_castsi256_ps(_mm256_cmpeq_epi32(_mm256_and_si256(quadrant, one), one));
+	__m256 sinSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(quadrant, two), 30));
+	__m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(_mm256_and_si256(_mm256_add_epi32(quadrant, one), two), 30));
+
+	_s = _mm256_xor_ps(_mm256_blendv_ps(sr, cr, swap), sinSign);
+	_c = _mm256_xor_ps(_mm256_blendv_ps(cr, sr, swap), cosSign);
+}
+
+//4x4 transpose within each 128 bit half, the low half ends up with objects 0-3 and the high half with 4-7
+SIMD_TARGET_AVX2 static inline void StoreColumn8(__m256 _x, __m256 _y, __m256 _z, __m256 _w, mat4* _out, const size_t* _lane, int _column, int _lanes)
+{
+	__m256 t0 = _mm256_unpacklo_ps(_x, _y);
+	__m256 t1 = _mm256_unpacklo_ps(_z, _w);
+	__m256 t2 = _mm256_unpackhi_ps(_x, _y);
+	__m256 t3 = _mm256_unpackhi_ps(_z, _w);
+
+	__m256 cols[4];
+	cols[0] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	cols[1] = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	cols[2] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	cols[3] = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+
+	for (int lane = 0; lane < _lanes; lane++)
+	{
+		__m128 col = lane < 4 ? _mm256_castps256_ps128(cols[lane]) : _mm256_extractf128_ps(cols[lane - 4], 1);
+		_mm_storeu_ps(&_out[_lane[lane]][_column][0], col);
+	}
+}
+
+//gather one component of eight vec3s into a register
+SIMD_TARGET_AVX2 static inline __m256 Load8(const vec3* _src, const size_t* _lane, int _component)
+{
+	return _mm256_setr_ps(_src[_lane[0]][_component], _src[_lane[1]][_component], _src[_lane[2]][_component], _src[_lane[3]][_component],
+		_src[_lane[4]][_component], _src[_lane[5]][_component], _src[_lane[6]][_component], _src[_lane[7]][_component]);
+}
+
+SIMD_TARGET_AVX2 static void ComposeAVX2(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, const uint32_t* _indices, size_t _count)
+{
+	for (size_t i = 0; i < _count; i += 8)
+	{
+		size_t lane[8];
+		int lanes = FillLanes<8>(lane, _indices, i, _count);
+
+		__m256 sx, cx, sy, cy, sz, cz;
+		SinCosDeg8(Load8(_rot, lane, 0), sx, cx);
+		SinCosDeg8(Load8(_rot, lane, 1), sy, cy);
+		SinCosDeg8(Load8(_rot, lane, 2), sz, cz);
+
+		__m256 scx = Load8(_scale, lane, 0);
+		__m256 scy = Load8(_scale, lane, 1);
+		__m256 scz = Load8(_scale, lane, 2);
+
+		__m256 sxsy = _mm256_mul_ps(sx, sy);
+		__m256 cxsy = _mm256_mul_ps(cx, sy);
+		__m256 zero = _mm256_setzero_ps();
+
+		__m256 m00 = _mm256_mul_ps(_mm256_mul_ps(cy, cz), scx);
+		__m256 m10 = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(cx, sz), _mm256_mul_ps(sxsy, cz)), scx);
+		__m256 m20 = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(sx, sz), _mm256_mul_ps(cxsy, cz)), scx);
+		StoreColumn8(m00, m10, m20, zero, _out, lane, 0, lanes);
+
+		__m256 m01 = _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(cy, sz)), scy);
+		__m256 m11 = _mm256_mul_ps(_mm256_sub_ps(_mm256_mul_ps(cx, cz), _mm256_mul_ps(sxsy, sz)), scy);
+		__m256 m21 = _mm256_mul_ps(_mm256_add_ps(_mm256_mul_ps(sx, cz), _mm256_mul_ps(cxsy, sz)), scy);
+		StoreColumn8(m01, m11, m21, zero, _out, lane, 1, lanes);
+
+		__m256 m02 = _mm256_mul_ps(sy, scz);
+		__m256 m12 = _mm256_mul_ps(_mm256_sub_ps(zero, _mm256_mul_ps(sx, cy)), scz);
+		__m256 m22 = _mm256_mul_ps(_mm256_mul_ps(cx, cy), scz);
+		StoreColumn8(m02, m12, m22, zero, _out, lane, 2, lanes);
+
+		StoreColumn8(Load8(_pos, lane, 0), Load8(_pos, lane, 1), Load8(_pos, lane, 2), _mm256_set1_ps(1.0f), _out, lane, 3, lanes);
+	}
+}
+
+/////////////////////////////////////////////////////////////////////////////////////
+// Public API
+/////////////////////////////////////////////////////////////////////////////////////
+
+void TransformKernels::ComposeTRS(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, size_t _count)
+{
+	ComposeTRS(GetPath(), _pos, _rot, _scale, _out, _count);
+}
+
+void TransformKernels::ComposeTRS(Path _path, const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, size_t _count)
+{
+	Compose(_path, _pos, _rot, _scale, _out, nullptr, _count);
+}
+
+void TransformKernels::ComposeTRSIndexed(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, const uint32_t* _indices, size_t _count)
+{
+	Compose(GetPath(), _pos, _rot, _scale, _out, _indices, _count);
+}
+
+void TransformKernels::Compose(Path _path, const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, const uint32_t* _indices, size_t _count)
+{
+	switch (_path)
+	{
+	case PATH_AVX2:
+		ComposeAVX2(_pos, _rot, _scale, _out, _indices, _count);
+		break;
+	case PATH_SSE4:
+		ComposeSSE4(_pos, _rot, _scale, _out, _indices, _count);
+		break;
+	default:
+		ComposeScalar(_pos, _rot, _scale, _out, _indices, _count);
+		break;
+	}
+}
+
+void TransformKernels::ComposeTRSReference(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, size_t _count)
+{
+	for (size_t i = 0; i < _count; i++)
+	{
+		mat4 world = glm::translate(mat4(1.0), _pos[i]);
+		world = glm::rotate(world, glm::radians(_rot[i].x), glm::vec3(1.0f, 0.0f, 0.0f));
+		world = glm::rotate(world, glm::radians(_rot[i].y), glm::vec3(0.0f, 1.0f, 0.0f));
+		world = glm::rotate(world, glm::radians(_rot[i].z), glm::vec3(0.0f, 0.0f, 1.0f));
+
+		_out[i] = glm::scale(world, _scale[i]);
+	}
+}
+
+TransformKernels::Path TransformKernels::BestPath()
+{
+	if (s_bestPath < 0)
+	{
+		bool sse41 = false;
+		bool avx2 = false;
+#ifdef _MSC_VER
+		int info[4];
+		__cpuid(info, 0);
+		int maxLeaf = info[0];
+
+		__cpuid(info, 1);
+		sse41 = (info[2] & (1 << 19)) != 0;
+		bool osxsave = (info[2] & (1 << 27)) != 0;
+		bool avx = (info[2] & (1 << 28)) != 0;
+
+		//the OS also has to be saving the YMM registers for us
+		bool ymmSaved = osxsave && ((_xgetbv(0) & 6) == 6);
+
+		if (maxLeaf >= 7 && avx && ymmSaved)
+		{
+			__cpuidex(info, 7, 0);
+			avx2 = (info[1] & (1 << 5)) != 0;
+		}
+#else
+		__builtin_cpu_init();
+		sse41 = __builtin_cpu_supports("sse4.1") != 0;
+		avx2 = __builtin_cpu_supports("avx2") != 0;
+#endif
+		s_bestPath = avx2 ? PATH_AVX2 : (sse41 ? PATH_SSE4 : PATH_SCALAR);
+	}
+
+	return (Path)s_bestPath;
+}
+
+void TransformKernels::SetPath(Path _path)
+{
+	s_path = _path > BestPath() ? BestPath() : _path;
+}
+
+TransformKernels::Path TransformKernels::GetPath()
+{
+	if (s_path == PATH_COUNT)
+	{
+		s_path = BestPath();
+	}
+	return s_path;
+}
+
+const char* TransformKernels::PathName(Path _path)
+{
+	switch (_path)
+	{
+	case PATH_AVX2: return "AVX2";
+	case PATH_SSE4: return "SSE4";
+	case PATH_SCALAR: return "SCALAR";
+	default: return "UNKNOWN";
+	}
+}
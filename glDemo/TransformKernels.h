@@ -0,0 +1,49 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+
+using namespace glm;
+
+//batched world matrix building for lots of objects at once
+//rather than translate * rotateX * rotateY * rotateZ * scale (five 4x4 multiplies per object)
+//the TRS matrix is written out directly from the sines and cosines of the three Euler angles
+//there are SSE4 (4 objects at a time) and AVX2 (8 at a time) versions plus a plain scalar fallback
+//all of them use the same range reduction and polynomials so they agree with each other
+//and the result for an object never depends on which batch it happened to land in
+class TransformKernels
+{
+public:
+
+	enum Path
+	{
+		PATH_SCALAR = 0,
+		PATH_SSE4,
+		PATH_AVX2,
+		PATH_COUNT
+	};
+
+	//world = T(pos) * Rx(rot.x) * Ry(rot.y) * Rz(rot.z) * S(scale), angles in degrees
+	//matches what GameObject::Tick used to build with glm::translate / rotate / scale
+	static void ComposeTRS(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, size_t _count);
+
+	//same thing using one particular code path, mostly for the benchmark
+	static void ComposeTRS(Path _path, const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, size_t _count);
+
+	//only build the matrices for the objects listed in _indices, everything else in _out is left alone
+	static void ComposeTRSIndexed(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, const uint32_t* _indices, size_t _count);
+
+	//the original per-object glm version, kept as a reference to compare against
+	static void ComposeTRSReference(const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, size_t _count);
+
+	//the fastest path this CPU supports, worked out the first time it is asked for
+	static Path BestPath();
+
+	//force ComposeTRS to use a given path (clamped to what the CPU supports)
+	static void SetPath(Path _path);
+	static Path GetPath();
+
+	static const char* PathName(Path _path);
+
+protected:
+	static void Compose(Path _path, const vec3* _pos, const vec3* _rot, const vec3* _scale, mat4* _out, const uint32_t* _indices, size_t _count);
+};
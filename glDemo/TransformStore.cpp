@@ -0,0 +1,279 @@
+#include "TransformStore.h"
+#include "TransformKernels.h"
+
+TransformStore::TransformStore()
+{
+}
+
+TransformStore::~TransformStore()
+{
+}
+
+TransformID TransformStore::Add()
+{
+	TransformID id = (TransformID)m_pos.size();
+
+	m_pos.push_back(vec3(0.0f));
+	m_rot.push_back(vec3(0.0f));
+	m_scale.push_back(vec3(1.0f));
+	m_rotIncr.push_back(vec3(0.0f));
+	m_local.push_back(mat4(1.0f));
+	m_world.push_back(mat4(1.0f));
+	m_normal.push_back(mat3(1.0f));
+	m_localBounds.push_back(Bounds());
+	m_worldBounds.Resize(m_pos.size());
+	m_dirty.push_back(1);
+	m_updated.push_back(0);
+
+	m_parent.push_back(INVALID_TRANSFORM);
+	m_depth.push_back(0);
+	m_orderDirty = true;
+
+	return id;
+}
+
+void TransformStore::Reserve(size_t _count)
+{
+	m_pos.reserve(_count);
+	m_rot.reserve(_count);
+	m_scale.reserve(_count);
+	m_rotIncr.reserve(_count);
+	m_local.reserve(_count);
+	m_world.reserve(_count);
+	m_normal.reserve(_count);
+	m_localBounds.reserve(_count);
+	m_worldBounds.Reserve(_count);
+	m_dirty.reserve(_count);
+	m_updated.reserve(_count);
+	m_parent.reserve(_count);
+	m_depth.reserve(_count);
+}
+
+void TransformStore::Clear()
+{
+	m_pos.clear();
+	m_rot.clear();
+	m_scale.clear();
+	m_rotIncr.clear();
+	m_local.clear();
+	m_world.clear();
+	m_normal.clear();
+	m_localBounds.clear();
+	m_worldBounds.Resize(0);
+	m_dirty.clear();
+	m_updated.clear();
+	m_parent.clear();
+	m_depth.clear();
+	m_order.clear();
+	m_levelStart.clear();
+	m_orderDirty = false;
+	m_numChildren = 0;
+}
+
+bool TransformStore::SetParent(TransformID _id, TransformID _parent)
+{
+	//walk up from the new parent, if we find ourselves that would be a loop
+	for (TransformID up = _parent; up != INVALID_TRANSFORM; up = m_parent[up])
+	{
+		if (up == _id)
+		{
+			printf("TRANSFORM %u can't be parented to %u, that would make a loop\n", _id, _parent);
+			return false;
+		}
+	}
+
+	if (m_parent[_id] == INVALID_TRANSFORM && _parent != INVALID_TRANSFORM)
+	{
+		m_numChildren++;
+	}
+	else if (m_parent[_id] != INVALID_TRANSFORM && _parent == INVALID_TRANSFORM)
+	{
+		m_numChildren--;
+	}
+
+	m_parent[_id] = _parent;
+	m_dirty[_id] = 1;
+	m_orderDirty = true;
+	return true;
+}
+
+void TransformStore::RebuildOrder()
+{
+	const size_t count = m_pos.size();
+
+	//count children per transform so they can be laid out contiguously (a counting sort on parent)
+	std::vector<uint32_t> childStart(count + 1, 0);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (m_parent[i] != INVALID_TRANSFORM)
+		{
+			childStart[m_parent[i] + 1]++;
+		}
+	}
+	for (size_t i = 0; i < count; i++)
+	{
+		childStart[i + 1] += childStart[i];
+	}
+
+	std::vector<TransformID> children(childStart[count]);
+	std::vector<uint32_t> fill(childStart.begin(), childStart.end() - 1);
+	for (size_t i = 0; i < count; i++)
+	{
+		if (m_parent[i] != INVALID_TRANSFORM)
+		{
+			children[fill[m_parent[i]]++] = (TransformID)i;
+		}
+	}
+
+	//breadth-first from all of the roots, which gives us the nodes grouped by depth
+	m_order.clear();
+	m_levelStart.clear();
+	for (size_t i = 0; i < count; i++)
+	{
+		if (m_parent[i] == INVALID_TRANSFORM)
+		{
+			m_order.push_back((TransformID)i);
+			m_depth[i] = 0;
+		}
+	}
+
+	size_t levelBegin = 0;
+	while (levelBegin < m_order.size())
+	{
+		m_levelStart.push_back(levelBegin);
+		size_t levelEnd = m_order.size();
+		for (size_t o = levelBegin; o < levelEnd; o++)
+		{
+			TransformID id = m_order[o];
+			for (uint32_t c = childStart[id]; c < childStart[id + 1]; c++)
+			{
+				m_order.push_back(children[c]);
+				m_depth[children[c]] = m_depth[id] + 1;
+			}
+		}
+		levelBegin = levelEnd;
+	}
+	m_levelStart.push_back(m_order.size());
+
+	m_orderDirty = false;
+}
+
+void TransformStore::Update(WorkerPool* _pool)
+{
+	const size_t count = m_pos.size();
+
+	if (m_orderDirty)
+	{
+		RebuildOrder();
+	}
+
+	//everything is split into fixed size chunks of TransformIDs, which chunk runs on which thread doesn't matter
+	//as each one only writes to its own transforms, and every transform is built the same way wherever it lands
+	size_t numChunks = (count + UPDATE_CHUNK - 1) / UPDATE_CHUNK;
+	if (m_chunks.size() < numChunks)
+	{
+		m_chunks.resize(numChunks);
+	}
+
+	WorkerPool::ParallelFor(_pool, count, UPDATE_CHUNK, [this](size_t _begin, size_t _end, size_t _chunk)
+	{
+		UpdateChunk(_begin, _end, m_chunks[_chunk]);
+	});
+
+	int numUpdated = 0;
+	for (size_t c = 0; c < numChunks; c++)
+	{
+		numUpdated += m_chunks[c].m_updated;
+	}
+
+	//then everything below the roots, a level at a time so parents are always done first
+	//a child only needs its world matrix rebuilding if it, or something above it, changed
+	//within a level nobody depends on anybody else so each level can be split up too
+	for (size_t level = 1; m_numChildren > 0 && level + 1 < m_levelStart.size(); level++)
+	{
+		const size_t levelBegin = m_levelStart[level];
+		const size_t levelSize = m_levelStart[level + 1] - levelBegin;
+
+		WorkerPool::ParallelFor(_pool, levelSize, UPDATE_CHUNK, [this, levelBegin](size_t _begin, size_t _end, size_t _chunk)
+		{
+			m_chunks[_chunk].m_updated = UpdateChildren(levelBegin + _begin, levelBegin + _end);
+		});
+
+		for (size_t c = 0; c < (levelSize + UPDATE_CHUNK - 1) / UPDATE_CHUNK; c++)
+		{
+			numUpdated += m_chunks[c].m_updated;
+		}
+	}
+
+	m_numUpdated = numUpdated;
+	m_numSkipped = (int)count - numUpdated;
+}
+
+void TransformStore::UpdateChunk(size_t _begin, size_t _end, UpdateScratch& _scratch)
+{
+	const vec3 noSpin(0.0f);
+
+	//spin anything that has a rotation increment and collect everything that needs rebuilding
+	//in the shipped manifest nothing spins, so after the first frame this is all we do
+	_scratch.m_roots.clear();
+	_scratch.m_children.clear();
+	for (size_t i = _begin; i < _end; i++)
+	{
+		if (m_rotIncr[i] != noSpin)
+		{
+			m_rot[i] += m_rotIncr[i];
+			m_dirty[i] = 1;
+		}
+
+		m_updated[i] = m_dirty[i];
+		if (m_dirty[i])
+		{
+			if (m_parent[i] == INVALID_TRANSFORM)
+			{
+				_scratch.m_roots.push_back((uint32_t)i);
+			}
+			else
+			{
+				_scratch.m_children.push_back((uint32_t)i);
+			}
+		}
+	}
+
+	//roots have no parent so their TRS goes straight into the world matrix
+	//children build their local matrix first, both with the batched SIMD kernel
+	TransformKernels::ComposeTRSIndexed(m_pos.data(), m_rot.data(), m_scale.data(), m_world.data(), _scratch.m_roots.data(), _scratch.m_roots.size());
+	TransformKernels::ComposeTRSIndexed(m_pos.data(), m_rot.data(), m_scale.data(), m_local.data(), _scratch.m_children.data(), _scratch.m_children.size());
+
+	for (size_t i = 0; i < _scratch.m_roots.size(); i++)
+	{
+		uint32_t id = _scratch.m_roots[i];
+		m_normal[id] = glm::transpose(glm::inverse(mat3(m_world[id])));
+		m_worldBounds.Set(id, m_localBounds[id], m_world[id]);
+		m_dirty[id] = 0;
+	}
+
+	_scratch.m_updated = (int)_scratch.m_roots.size();
+}
+
+int TransformStore::UpdateChildren(size_t _begin, size_t _end)
+{
+	int numUpdated = 0;
+
+	for (size_t o = _begin; o < _end; o++)
+	{
+		TransformID id = m_order[o];
+		TransformID parent = m_parent[id];
+
+		if (m_dirty[id] || m_updated[parent])
+		{
+			m_world[id] = m_world[parent] * m_local[id];
+			m_normal[id] = glm::transpose(glm::inverse(mat3(m_world[id])));
+			m_worldBounds.Set(id, m_localBounds[id], m_world[id]);
+			m_updated[id] = 1;
+			m_dirty[id] = 0;
+			numUpdated++;
+		}
+	}
+
+	return numUpdated;
+}
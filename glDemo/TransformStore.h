@@ -0,0 +1,137 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include "AlignedAllocator.h"
+#include "WorkerPool.h"
+#include "Bounds.h"
+
+using namespace glm;
+
+//index of one transform in the TransformStore
+typedef uint32_t TransformID;
+const TransformID INVALID_TRANSFORM = 0xffffffff;
+
+//all of the GameObject transforms for a scene, stored as a structure of arrays
+//each property lives in its own contiguous, cache line aligned array indexed by TransformID
+//so the per-frame update is one linear sweep through memory rather than chasing a pointer per object
+//
+//transforms can also be parented to each other
+//pos / rot / scale are then relative to the parent and world = parent world * local
+//the store keeps a breadth-first ordering of everything (roots, then their children, then theirs...)
+//so parents are always finished before their children and a subtree is only revisited if an ancestor moved
+class TransformStore
+{
+public:
+	TransformStore();
+	~TransformStore();
+
+	//make space for a new transform (identity, no spin, no parent) and return its index
+	TransformID Add();
+
+	//grow all of the arrays in one go, for when we know how many objects are coming
+	void Reserve(size_t _count);
+
+	//forget everything
+	void Clear();
+
+	size_t Size() const { return m_pos.size(); }
+
+	//attach _id to _parent (or detach it with INVALID_TRANSFORM)
+	//returns false, and leaves things alone, if this would make a loop
+	bool SetParent(TransformID _id, TransformID _parent);
+	TransformID GetParent(TransformID _id) const { return m_parent[_id]; }
+	int GetDepth(TransformID _id) const { return m_depth[_id]; }
+
+	//spin everything by its rotation increment and rebuild the world (and normal) matrices
+	//of anything that has actually changed, or whose parent has, since the last Update
+	//with a WorkerPool the work is shared out across its threads, the results are identical either way
+	void Update(WorkerPool* _pool = nullptr);
+
+	//how many world matrices the last Update rebuilt, and how many it could leave alone
+	int GetNumUpdated() const { return m_numUpdated; }
+	int GetNumSkipped() const { return m_numSkipped; }
+
+	//did this transform change in the last Update? for anything caching data derived from it
+	bool WasUpdated(TransformID _id) const { return m_updated[_id] != 0; }
+	const uint8_t* UpdatedFlags() const { return m_updated.data(); }
+
+	//getters and setters for one transform, relative to its parent if it has one
+	const vec3& GetPos(TransformID _id) const { return m_pos[_id]; }
+	const vec3& GetRot(TransformID _id) const { return m_rot[_id]; }
+	const vec3& GetScale(TransformID _id) const { return m_scale[_id]; }
+	const vec3& GetRotIncr(TransformID _id) const { return m_rotIncr[_id]; }
+	const mat4& GetLocal(TransformID _id) const { return m_parent[_id] == INVALID_TRANSFORM ? m_world[_id] : m_local[_id]; }
+	const mat4& GetWorld(TransformID _id) const { return m_world[_id]; }
+	const mat3& GetNormalMatrix(TransformID _id) const { return m_normal[_id]; }
+
+	//changing anything marks the transform dirty so its matrices get rebuilt next Update
+	void SetPos(TransformID _id, const vec3& _pos) { m_pos[_id] = _pos; m_dirty[_id] = 1; }
+	void SetRot(TransformID _id, const vec3& _rot) { m_rot[_id] = _rot; m_dirty[_id] = 1; }
+	void SetScale(TransformID _id, const vec3& _scale) { m_scale[_id] = _scale; m_dirty[_id] = 1; }
+	void SetRotIncr(TransformID _id, const vec3& _rotIncr) { m_rotIncr[_id] = _rotIncr; }
+
+	//model space bounds of whatever is drawn with this transform
+	//the world space versions are kept up to date alongside the world matrices
+	void SetLocalBounds(TransformID _id, const Bounds& _bounds) { m_localBounds[_id] = _bounds; m_dirty[_id] = 1; }
+	const Bounds& GetLocalBounds(TransformID _id) const { return m_localBounds[_id]; }
+	const WorldBounds& GetWorldBounds() const { return m_worldBounds; }
+
+	//the raw arrays, for anything that wants to sweep over them itself
+	const vec3* Positions() const { return m_pos.data(); }
+	const vec3* Rotations() const { return m_rot.data(); }
+	const vec3* Scales() const { return m_scale.data(); }
+	const mat4* WorldMatrices() const { return m_world.data(); }
+
+protected:
+
+	//how many transforms each job in Update looks after
+	//a multiple of 64 so no two chunks ever write to the same cache line of the byte sized arrays
+	static const size_t UPDATE_CHUNK = 1024;
+
+	//what one chunk of Update found, each chunk has its own so they never touch each other's
+	struct UpdateScratch
+	{
+		std::vector<uint32_t> m_roots;		//dirty transforms with no parent
+		std::vector<uint32_t> m_children;	//dirty transforms with one
+		int m_updated = 0;
+	};
+
+	//work out m_order, m_depth and m_levelStart again after parents have changed
+	void RebuildOrder();
+
+	//spin, find the dirty ones and build matrices for transforms _begin to _end
+	void UpdateChunk(size_t _begin, size_t _end, UpdateScratch& _scratch);
+
+	//world = parent world * local for m_order[_begin] to m_order[_end], all on the same level
+	//returns how many actually needed it
+	int UpdateChildren(size_t _begin, size_t _end);
+
+	AlignedVector<vec3> m_pos;		//position
+	AlignedVector<vec3> m_rot;		//Euler angles in degrees, applied X then Y then Z
+	AlignedVector<vec3> m_scale;
+	AlignedVector<vec3> m_rotIncr;	//added to m_rot every tick
+
+	AlignedVector<mat4> m_local;	//TRS relative to the parent, only used by transforms that have one
+	AlignedVector<mat4> m_world;	//result of the last Update (for roots this is also their local matrix)
+	AlignedVector<mat3> m_normal;	//inverse transpose of the top 3x3 of m_world, for lighting
+
+	AlignedVector<Bounds> m_localBounds;	//model space, invalid for things that can't be culled
+	WorldBounds m_worldBounds;				//m_localBounds through m_world
+
+	AlignedVector<uint8_t> m_dirty;		//something has changed since the last Update
+	AlignedVector<uint8_t> m_updated;	//rebuilt in the last Update
+
+	//hierarchy
+	std::vector<TransformID> m_parent;		//INVALID_TRANSFORM for roots
+	std::vector<int> m_depth;				//0 for roots, 1 for their children...
+	std::vector<TransformID> m_order;		//every transform, sorted by depth (breadth-first)
+	std::vector<size_t> m_levelStart;		//where each depth starts in m_order, plus one past the end
+	bool m_orderDirty = false;
+	int m_numChildren = 0;					//how many transforms have a parent
+
+	//one per chunk of Update, kept between frames so we aren't reallocating every time
+	std::vector<UpdateScratch> m_chunks;
+
+	int m_numUpdated = 0;
+	int m_numSkipped = 0;
+};
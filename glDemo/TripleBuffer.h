@@ -0,0 +1,44 @@
+#pragma once
+#include <atomic>
+
+using namespace std;
+
+//hands the latest of a stream of T from one thread to another without either ever waiting on a lock
+//the writer fills in Write() and calls Publish(), the reader calls Acquire() and if it returns true Read() is the newest published T
+//there are three copies so each side always has one to itself with the third in the middle waiting to be picked up
+//if the writer publishes twice before the reader acquires, the older one is simply overwritten (the reader always gets the latest)
+template <class T>
+class TripleBuffer
+{
+public:
+
+	//writer side
+	T& Write() { return m_slots[m_back]; }
+	void Publish()
+	{
+		//swap my finished slot into the middle, marked fresh, and take whatever was there to write the next one into
+		m_back = m_middle.exchange(m_back | FRESH, memory_order_acq_rel) & INDEX;
+	}
+
+	//reader side
+	bool Acquire()
+	{
+		if (!(m_middle.load(memory_order_acquire) & FRESH))
+		{
+			return false;
+		}
+		m_front = m_middle.exchange(m_front, memory_order_acq_rel) & INDEX;
+		return true;
+	}
+	T& Read() { return m_slots[m_front]; }
+
+protected:
+
+	static const unsigned int INDEX = 3;
+	static const unsigned int FRESH = 4;	//set in m_middle when it holds something the reader hasn't had yet
+
+	T m_slots[3];
+	unsigned int m_back = 0;			//only touched by the writer
+	atomic<unsigned int> m_middle{ 1 };
+	unsigned int m_front = 2;			//only touched by the reader
+};
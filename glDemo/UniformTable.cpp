@@ -0,0 +1,79 @@
+#include "UniformTable.h"
+#include <algorithm>
+#include <string.h>
+
+using namespace std;
+
+unordered_map<GLuint, UniformTable::Table> UniformTable::s_tables;
+unsigned int UniformTable::s_locationQueries = 0;
+
+void UniformTable::Build(GLuint _prog)
+{
+	Table& table = s_tables[_prog];
+	table.clear();
+
+	GLint count = 0, maxLength = 0;
+	glGetProgramiv(_prog, GL_ACTIVE_UNIFORMS, &count);
+	glGetProgramiv(_prog, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+	vector<char> name(maxLength + 1);
+	for (GLint i = 0; i < count; i++)
+	{
+		GLsizei length = 0;
+		GLint size = 0;
+		GLenum type = 0;
+		glGetActiveUniform(_prog, (GLuint)i, (GLsizei)name.size(), &length, &size, &type, name.data());
+
+		//uniform block members are active uniforms too but don't have a location
+		GLint location = glGetUniformLocation(_prog, name.data());
+		s_locationQueries++;
+		if (location < 0)
+		{
+			continue;
+		}
+
+		//arrays are reported as NAME[0], also let them be found as just NAME
+		Entry entry;
+		entry.m_id = Hash(name.data());
+		entry.m_location = location;
+		table.push_back(entry);
+		if (length > 3 && strcmp(name.data() + length - 3, "[0]") == 0)
+		{
+			name[length - 3] = 0;
+			entry.m_id = Hash(name.data());
+			table.push_back(entry);
+		}
+	}
+
+	sort(table.begin(), table.end(), [](const Entry& _a, const Entry& _b) { return _a.m_id < _b.m_id; });
+
+	//two names with the same hash would quietly find the wrong uniform
+	for (size_t i = 1; i < table.size(); i++)
+	{
+		if (table[i].m_id == table[i - 1].m_id)
+		{
+			printf("UNIFORM NAME HASH CLASH IN PROGRAM %u\n", _prog);
+			assert(0);
+		}
+	}
+}
+
+GLint UniformTable::Find(GLuint _prog, UniformID _id)
+{
+	unordered_map<GLuint, Table>::iterator it = s_tables.find(_prog);
+	if (it == s_tables.end())
+	{
+		//a program that didn't come through setupShaders, build it now rather than guess
+		Build(_prog);
+		it = s_tables.find(_prog);
+	}
+
+	const Table& table = it->second;
+	Table::const_iterator entry = lower_bound(table.begin(), table.end(), _id, [](const Entry& _e, UniformID _id) { return _e.m_id < _id; });
+	return (entry != table.end() && entry->m_id == _id) ? entry->m_location : -1;
+}
+
+void UniformTable::Remove(GLuint _prog)
+{
+	s_tables.erase(_prog);
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include "core.h"
+#include <stdint.h>
+#include <vector>
+#include <unordered_map>
+
+//pre-hashed name of a uniform, work these out once (at load / init) and hang on to them
+typedef uint32_t UniformID;
+
+//every active uniform in a shader program, built once when it is linked
+//lookups are by UniformID so the hot path never builds a string or calls glGetUniformLocation
+class UniformTable
+{
+public:
+
+	//FNV-1a, constexpr so names written in the code can be hashed by the compiler
+	static constexpr UniformID Hash(const char* _name)
+	{
+		UniformID hash = 2166136261u;
+		while (*_name)
+		{
+			hash = (hash ^ (uint8_t)*_name++) * 16777619u;
+		}
+		return hash;
+	}
+	static UniformID Hash(const std::string& _name) { return Hash(_name.c_str()); }
+
+	//enumerate _prog's active uniforms and remember where they are, setupShaders does this after linking
+	static void Build(GLuint _prog);
+
+	//location of a uniform in a program, -1 if the program doesn't have it
+	static GLint Find(GLuint _prog, UniformID _id);
+	static GLint Find(GLuint _prog, const char* _name) { return Find(_prog, Hash(_name)); }
+
+	//forget a program's table (when it is deleted)
+	static void Remove(GLuint _prog);
+
+	//how many times glGetUniformLocation has been called in total, only ever while building tables
+	static unsigned int GetLocationQueries() { return s_locationQueries; }
+
+protected:
+
+	struct Entry
+	{
+		UniformID m_id;
+		GLint m_location;
+	};
+
+	//sorted by m_id
+	typedef std::vector<Entry> Table;
+
+	static std::unordered_map<GLuint, Table> s_tables;
+	static unsigned int s_locationQueries;
+};
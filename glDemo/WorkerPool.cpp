@@ -0,0 +1,132 @@
+#include "WorkerPool.h"
+
+WorkerPool::WorkerPool(int _threads)
+	: m_nextChunk(0), m_chunksDone(0)
+{
+	if (_threads <= 0)
+	{
+		_threads = HardwareThreads();
+	}
+
+	for (int i = 1; i < _threads; i++)
+	{
+		m_workers.push_back(thread(&WorkerPool::WorkerLoop, this));
+	}
+}
+
+WorkerPool::~WorkerPool()
+{
+	{
+		lock_guard<mutex> lock(m_mutex);
+		m_quit = true;
+	}
+	m_wake.notify_all();
+
+	for (size_t i = 0; i < m_workers.size(); i++)
+	{
+		m_workers[i].join();
+	}
+}
+
+int WorkerPool::HardwareThreads()
+{
+	unsigned int count = thread::hardware_concurrency();
+	return count > 0 ? (int)count : 1;
+}
+
+void WorkerPool::ParallelFor(size_t _count, size_t _chunkSize, const function<void(size_t, size_t, size_t)>& _job)
+{
+	if (_count == 0)
+	{
+		return;
+	}
+
+	size_t numChunks = (_count + _chunkSize - 1) / _chunkSize;
+
+	//not worth waking anyone up for
+	if (m_workers.empty() || numChunks == 1)
+	{
+		ParallelFor(nullptr, _count, _chunkSize, _job);
+		return;
+	}
+
+	lock_guard<mutex> call(m_callMutex);
+	{
+		unique_lock<mutex> lock(m_mutex);
+
+		//a worker that woke up late for the last job may still be on its way out
+		m_done.wait(lock, [this] { return m_active == 0; });
+
+		m_job = &_job;
+		m_count = _count;
+		m_chunkSize = _chunkSize;
+		m_numChunks = numChunks;
+		m_chunksDone = 0;
+		m_nextChunk = 0;
+		m_generation++;
+	}
+	m_wake.notify_all();
+
+	RunChunks();
+
+	unique_lock<mutex> lock(m_mutex);
+	m_done.wait(lock, [this] { return m_chunksDone == m_numChunks && m_active == 0; });
+	m_job = nullptr;
+}
+
+void WorkerPool::ParallelFor(WorkerPool* _pool, size_t _count, size_t _chunkSize, const function<void(size_t, size_t, size_t)>& _job)
+{
+	if (_pool)
+	{
+		_pool->ParallelFor(_count, _chunkSize, _job);
+		return;
+	}
+
+	for (size_t begin = 0, chunk = 0; begin < _count; begin += _chunkSize, chunk++)
+	{
+		_job(begin, std::min(begin + _chunkSize, _count), chunk);
+	}
+}
+
+void WorkerPool::WorkerLoop()
+{
+	unsigned int seen = 0;
+
+	while (true)
+	{
+		{
+			unique_lock<mutex> lock(m_mutex);
+			m_wake.wait(lock, [&] { return m_quit || m_generation != seen; });
+			if (m_quit)
+			{
+				return;
+			}
+			seen = m_generation;
+			m_active++;
+		}
+
+		RunChunks();
+
+		{
+			lock_guard<mutex> lock(m_mutex);
+			m_active--;
+		}
+		m_done.notify_all();
+	}
+}
+
+void WorkerPool::RunChunks()
+{
+	while (true)
+	{
+		size_t chunk = m_nextChunk.fetch_add(1);
+		if (chunk >= m_numChunks)
+		{
+			return;
+		}
+
+		size_t begin = chunk * m_chunkSize;
+		(*m_job)(begin, std::min(begin + m_chunkSize, m_count), chunk);
+		m_chunksDone.fetch_add(1);
+	}
+}
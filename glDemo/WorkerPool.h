@@ -0,0 +1,62 @@
+#pragma once
+#include <stddef.h>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <algorithm>
+
+using namespace std;
+
+//a fixed set of worker threads for splitting big loops up across the CPU
+//work is always cut into the same chunks whatever the number of threads
+//so as long as each chunk only writes to its own slice of memory the result can't depend on the thread count
+class WorkerPool
+{
+public:
+
+	//_threads is the total including the thread calling ParallelFor, 0 means one per hardware thread
+	//1 means no workers at all, everything runs on the caller (handy for debugging)
+	WorkerPool(int _threads = 0);
+	~WorkerPool();
+
+	int NumThreads() const { return (int)m_workers.size() + 1; }
+
+	//run _job(begin, end, chunkIndex) for every _chunkSize slice of [0, _count)
+	//the calling thread joins in and this only returns once every chunk is finished
+	//calls from different threads take turns, but a job must not call ParallelFor on the pool it is running on
+	void ParallelFor(size_t _count, size_t _chunkSize, const function<void(size_t, size_t, size_t)>& _job);
+
+	//as above, but with no pool just runs the chunks in order on this thread
+	static void ParallelFor(WorkerPool* _pool, size_t _count, size_t _chunkSize, const function<void(size_t, size_t, size_t)>& _job);
+
+	static int HardwareThreads();
+
+protected:
+
+	void WorkerLoop();
+
+	//grab chunks of the current job until there are none left
+	void RunChunks();
+
+	vector<thread> m_workers;
+
+	mutex m_callMutex;			//held by whoever's job is running
+	mutex m_mutex;
+	condition_variable m_wake;	//a new job is ready (or we are shutting down)
+	condition_variable m_done;	//a worker has finished with the current job
+
+	//the current job, only changed while no workers are active
+	const function<void(size_t, size_t, size_t)>* m_job = nullptr;
+	size_t m_count = 0;
+	size_t m_chunkSize = 0;
+	size_t m_numChunks = 0;
+	atomic<size_t> m_nextChunk;
+	atomic<size_t> m_chunksDone;
+
+	unsigned int m_generation = 0;	//goes up for every job so the workers know there is something new
+	int m_active = 0;				//workers currently looking at the job
+	bool m_quit = false;
+};
@@ -1,6 +1,8 @@
 #pragma once
+#include "UniformTable.h"
 //a useful function that was needed in a few places, so made this mini-helper class
 //it finds the location in the shader program of a given uniform variable
+//from the program's UniformTable, so no glGetUniformLocation call
 class Helper
 {
 public:
@@ -8,7 +10,15 @@ public:
 	static bool SetUniformLocation(unsigned int shader, const char* name, GLint* pLocation)
 
 	{
-		*pLocation = glGetUniformLocation(shader, name);
+		*pLocation = UniformTable::Find(shader, name);
+
+		return (*pLocation >= 0);
+	}
+
+	//same thing with a name that has already been hashed
+	static bool SetUniformLocation(unsigned int shader, UniformID id, GLint* pLocation)
+	{
+		*pLocation = UniformTable::Find(shader, id);
 
 		return (*pLocation >= 0);
 	}
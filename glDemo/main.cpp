@@ -9,6 +9,15 @@
 #include "AIMesh.h"
 #include "Cube.h"
 #include "Scene.h"
+#include "Benchmark.h"
+#include "FrameUniforms.h"
+#include "LightBuffer.h"
+#include "GLState.h"
+#include "RenderThread.h"
+#include "MeshCache.h"
+#include "ObjLoader.h"
+#include "TextureStreamer.h"
+#include "TextureCache.h"
 
 
 using namespace std;
@@ -67,6 +76,23 @@ bool g_CrystalGlow = false; // Tracks whether the crystal is glowing
 //Global Game Object
 Scene* g_Scene = nullptr;
 
+//threads Scene::Update may use, set with -threads N (0 = all of them, 1 = main thread only)
+int g_SceneThreads = 0;
+
+//extra copies of the PLANET GameObject to add for stress testing, set with -stress N
+int g_StressCopies = 0;
+
+//extra point lights to scatter around the scene, set with -lights N
+int g_ExtraLights = 0;
+
+//draw the Scene on its own thread while the main thread updates the next frame, set with -renderthread
+//only the Scene is drawn in this mode, not the examples SPACE flicks between
+bool g_UseRenderThread = false;
+RenderThread* g_RenderThread = nullptr;
+
+//the one directional light above, packed up for the lighting shader
+LightBuffer* g_DLBuffer = nullptr;
+
 // Window size
 const unsigned int g_initWidth = 512;
 const unsigned int g_initHeight = 512;
@@ -77,16 +103,62 @@ const unsigned int g_initHeight = 512;
 // Function prototypes
 void renderScene();
 void updateScene();
+void loadScene();
+void reloadScene();
 void resizeWindow(GLFWwindow* _window, int _width, int _height);
 void keyboardHandler(GLFWwindow* _window, int _key, int _scancode, int _action, int _mods);
 void mouseMoveHandler(GLFWwindow* _window, double _xpos, double _ypos);
 void mouseButtonHandler(GLFWwindow* _window, int _button, int _action, int _mods);
 void mouseScrollHandler(GLFWwindow* _window, double _xoffset, double _yoffset);
 void mouseEnterHandler(GLFWwindow* _window, int _entered);
+void setModelMatrix(const mat4& _model);
 
 
-int main()
+int main(int argc, char* argv[])
 {
+	//glDemo.exe -bench runs the micro benchmarks and quits without opening a window
+	//-threads N sets how many threads the scene update uses
+	//-stress N scatters N more copies of PLANET around the scene
+	//-lights N scatters N point lights around the scene
+	//-renderthread draws the scene on its own thread, a frame behind the update
+	//-nomeshcache imports every model with Assimp and doesn't write the binary mesh cache
+	//-texbudget MB caps how much texture data is uploaded each frame, 0 uploads everything in the first frame (waiting on the GPU if it has to)
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "-threads" && i + 1 < argc)
+		{
+			g_SceneThreads = atoi(argv[++i]);
+		}
+		else if (string(argv[i]) == "-stress" && i + 1 < argc)
+		{
+			g_StressCopies = atoi(argv[++i]);
+		}
+		else if (string(argv[i]) == "-lights" && i + 1 < argc)
+		{
+			g_ExtraLights = atoi(argv[++i]);
+		}
+		else if (string(argv[i]) == "-renderthread")
+		{
+			g_UseRenderThread = true;
+		}
+		else if (string(argv[i]) == "-nomeshcache")
+		{
+			MeshCache::SetEnabled(false);
+		}
+		else if (string(argv[i]) == "-texbudget" && i + 1 < argc)
+		{
+			TextureStreamer::SetFrameBudget((size_t)(atof(argv[++i]) * 1024.0 * 1024.0));
+		}
+	}
+	for (int i = 1; i < argc; i++)
+	{
+		if (string(argv[i]) == "-bench")
+		{
+			Benchmark::RunAll();
+			return 0;
+		}
+	}
+
 	//
 	// 1. Initialisation
 	//
@@ -141,13 +213,13 @@ int main()
 	glPolygonMode(GL_BACK, GL_LINE);
 
 	glFrontFace(GL_CCW);
-	glEnable(GL_CULL_FACE);
+	GLState::Enable(GL_CULL_FACE);
 
-	glEnable(GL_DEPTH_TEST);
+	GLState::Enable(GL_DEPTH_TEST);
 	glDepthFunc(GL_LEQUAL);
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+	GLState::Enable(GL_BLEND);
+	GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 	//
 	// Setup the Example Objects
@@ -199,34 +271,93 @@ int main()
 	//
 
 	g_Scene = new Scene();
+	g_Scene->SetThreadCount(g_SceneThreads);
+	loadScene();
 
-	ifstream manifest;
-	manifest.open("manifest.txt");
-
-	g_Scene->Load(manifest);
-	g_Scene->Init();
+	MeshCache::PrintStats();
+	TextureCache::PrintStats();
 
-	manifest.close();
+	//everything is loaded, the GL context can go over to the render thread now
+	if (g_UseRenderThread)
+	{
+		g_RenderThread = new RenderThread(window, g_Scene);
+	}
 
 
 	//
 	// Main loop
 	// 
 
+	// with a render thread the clock counts updates, so frames on screen are counted from what it has drawn
+	double drawnSince = glfwGetTime();
+	unsigned int drawnBefore = 0;
+	float drawnFPS = 0.0f;
+
 	while (!glfwWindowShouldClose(window))
 	{
 		updateScene();
-		renderScene();						// Render into the current buffer
-		glfwSwapBuffers(window);			// Displays what was just rendered (using double buffering).
+		if (g_RenderThread)
+		{
+			// Hand this frame over to be drawn while we get on with the next one
+			// but not until the last one is being drawn, anything built further ahead would only be thrown away
+			g_RenderThread->WaitForPickup();
+			FrameSnapshot& snapshot = g_RenderThread->GetSnapshot();
+			g_Scene->BuildSnapshot(snapshot);
+			glfwGetFramebufferSize(window, &snapshot.m_width, &snapshot.m_height);
+			g_RenderThread->Submit();
+		}
+		else
+		{
+			renderScene();					// Render into the current buffer
+			glfwSwapBuffers(window);		// Displays what was just rendered (using double buffering).
+		}
 
 		glfwPollEvents();					// Use this version when animating as fast as possible
 
 		// update window title
-		char timingString[256];
-		sprintf_s(timingString, 256, "CIS5013: Average fps: %.0f; Average spf: %f", g_gameClock->averageFPS(), g_gameClock->averageSPF() / 1000.0f);
+		char timingString[512];
+		const SceneStats& stats = g_RenderThread ? g_RenderThread->GetStats() : g_Scene->GetStats();
+		float fps = g_gameClock->averageFPS();
+		float spf = g_gameClock->averageSPF() / 1000.0f;
+		if (g_RenderThread)
+		{
+			double now = glfwGetTime();
+			if (now - drawnSince >= 0.5)
+			{
+				unsigned int drawn = g_RenderThread->GetFramesDrawn();
+				drawnFPS = (float)((drawn - drawnBefore) / (now - drawnSince));
+				drawnBefore = drawn;
+				drawnSince = now;
+			}
+			fps = drawnFPS;
+			spf = drawnFPS > 0.0f ? 1.0f / drawnFPS : 0.0f;
+		}
+		sprintf_s(timingString, 512, "CIS5013: Average fps: %.0f; Average spf: %f; Matrices rebuilt: %d skipped: %d; Drawn: %d culled: %d; Draw calls: %d; Uniform lookups: %d; GL calls: %d elided: %d", fps, spf,
+			stats.m_transformsUpdated, stats.m_transformsSkipped, stats.m_objectsVisible, stats.m_objectsCulled, stats.m_drawCalls, stats.m_uniformLocationQueries, stats.m_glCallsIssued, stats.m_glCallsElided);
 		glfwSetWindowTitle(window, timingString);
 	}
 
+	//get the GL context back from the render thread
+	if (g_RenderThread)
+	{
+		cout << "RENDER THREAD DREW " << g_RenderThread->GetFramesDrawn() << " FRAMES" << endl;
+		delete g_RenderThread;
+		g_RenderThread = nullptr;
+	}
+
+	//the scene's GL resources, and the shared mesh and uniform buffers, have to go while the GL context is still around
+	cout << "SCENE ARENA :" << endl;
+	g_Scene->GetArena().PrintStats();
+	TextureStreamer::PrintStats();
+	delete g_Scene;
+	g_Scene = nullptr;
+	MeshArena::Release();
+	ObjLoader::Release();
+	FrameUniforms::Release();
+	TextureCache::Clear();
+	TextureStreamer::Release();
+	delete g_DLBuffer;
+
 	glfwTerminate();
 
 	if (g_gameClock)
@@ -245,6 +376,12 @@ void renderScene()
 	// Clear the rendering window
 	glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
+	// Start this frame's uniform blocks
+	FrameUniforms::BeginFrame();
+
+	// This frame's share of any textures still on their way up
+	TextureStreamer::Update(g_Scene ? g_Scene->GetWorkers() : nullptr);
+
     bool g_CrystalGlow = false; // Tracks whether the crystal is glowing
 	mat4 cameraTransform = g_mainCamera->projectionTransform() * g_mainCamera->viewTransform();
 
@@ -255,15 +392,9 @@ void renderScene()
 	if (true)
 	{
 		// Render axes 
-		glUseProgram(g_flatColourShader);
-		GLint pLocation;
-		Helper::SetUniformLocation(g_flatColourShader, "viewMatrix", &pLocation);
-		glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&cameraView);
-		Helper::SetUniformLocation(g_flatColourShader, "projMatrix", &pLocation);
-		glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&cameraProjection);
-		Helper::SetUniformLocation(g_flatColourShader, "modelMatrix", &pLocation);
-		mat4 modelTransform = identity<mat4>();
-		glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&modelTransform);
+		GLState::UseProgram(g_flatColourShader);
+		FrameUniforms::SetCamera(cameraView, cameraProjection, vec3(inverse(cameraView)[3]));
+		setModelMatrix(identity<mat4>());
 
 		g_principleAxes->render();
 	}
@@ -272,27 +403,26 @@ void renderScene()
 	{
 	case 0:
 	{
-		glUseProgram(g_texDirLightShader);
+		GLState::UseProgram(g_texDirLightShader);
 
 		GLint pLocation;
-		Helper::SetUniformLocation(g_texDirLightShader, "viewMatrix", &pLocation);
-		glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&cameraView);
-		Helper::SetUniformLocation(g_texDirLightShader, "projMatrix", &pLocation);
-		glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&cameraProjection);
 		Helper::SetUniformLocation(g_texDirLightShader, "texture", &pLocation);
 		glUniform1i(pLocation, 0); // set to point to texture unit 0 for AIMeshes
-		Helper::SetUniformLocation(g_texDirLightShader, "DIRDir", &pLocation);
-		glUniform3fv(pLocation, 1, (GLfloat*)&g_DLdirection);
-		Helper::SetUniformLocation(g_texDirLightShader, "DIRCol", &pLocation);
-		glUniform3fv(pLocation, 1, (GLfloat*)&g_DLcolour);
-		Helper::SetUniformLocation(g_texDirLightShader, "DIRAmb", &pLocation);
-		glUniform3fv(pLocation, 1, (GLfloat*)&g_DLambient);
+		if (!g_DLBuffer)
+		{
+			vector<LightData> lights(1);
+			lights[0].m_posType = vec4(0.0f, 0.0f, 0.0f, (float)LIGHT_DIRECTION);
+			lights[0].m_dirRange = vec4(g_DLdirection, 0.0f);
+			lights[0].m_col = vec4(g_DLcolour, 1.0f);
+			lights[0].m_amb = vec4(g_DLambient, 1.0f);
+			g_DLBuffer = new LightBuffer();
+			g_DLBuffer->Upload(lights);
+		}
+		g_DLBuffer->Bind();
 		if (g_creatureMesh) {
 
 			// Setup transforms
-			Helper::SetUniformLocation(g_texDirLightShader, "modelMatrix", &pLocation);
-			mat4 modelTransform = glm::translate(identity<mat4>(), g_beastPos) * eulerAngleY<float>(glm::radians<float>(g_beastRotation));
-			glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&modelTransform);
+			setModelMatrix(glm::translate(identity<mat4>(), g_beastPos) * eulerAngleY<float>(glm::radians<float>(g_beastRotation)));
 
 			g_creatureMesh->setupTextures();
 			g_creatureMesh->render();
@@ -301,9 +431,7 @@ void renderScene()
 		if (g_wallMesh) {
 
 			// Setup transforms
-			Helper::SetUniformLocation(g_texDirLightShader, "modelMatrix", &pLocation);
-			mat4 modelTransform = glm::translate(identity<mat4>(), g_wallPos) * eulerAngleY<float>(glm::radians<float>(g_wallRotation));
-			glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&modelTransform);
+			setModelMatrix(glm::translate(identity<mat4>(), g_wallPos) * eulerAngleY<float>(glm::radians<float>(g_wallRotation)));
 
 			g_wallMesh->setupTextures();
 			g_wallMesh->render();
@@ -312,9 +440,7 @@ void renderScene()
 		if (g_planetMesh) {
 
 			// Setup transforms
-			Helper::SetUniformLocation(g_texDirLightShader, "modelMatrix", &pLocation);
-			mat4 modelTransform = glm::translate(identity<mat4>(), vec3(4.0, 4.0, 4.0));
-			glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&modelTransform);
+			setModelMatrix(glm::translate(identity<mat4>(), vec3(4.0, 4.0, 4.0)));
 
 			g_planetMesh->setupTextures();
 			g_planetMesh->render();
@@ -323,19 +449,17 @@ void renderScene()
 		
 		if (g_GhostMesh) {
 			// Enable blending for transparency
-			glEnable(GL_BLEND);
-			glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
+			GLState::Enable(GL_BLEND);
+			GLState::BlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
 
 			// Setup transforms
-			Helper::SetUniformLocation(g_texDirLightShader, "modelMatrix", &pLocation);
-			mat4 modelTransform = glm::translate(identity<mat4>(), g_GhostPos) * eulerAngleY<float>(glm::radians<float>(g_GhostRotation));
-			glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&modelTransform);
+			setModelMatrix(glm::translate(identity<mat4>(), g_GhostPos) * eulerAngleY<float>(glm::radians<float>(g_GhostRotation)));
 
 			g_GhostMesh->setupTextures();
 			g_GhostMesh->render();
 
 			// Disable blending after rendering
-			glDisable(GL_BLEND);
+			GLState::Disable(GL_BLEND);
 		}
 		if (g_CrystalMesh) {
 			if (g_CrystalGlow) {
@@ -359,9 +483,7 @@ void renderScene()
 				Helper::SetUniformLocation(g_emissiveShader, "emissiveStrength", &pLocation);
 				glUniform1f(pLocation, emissiveStrength);*/
 
-				Helper::SetUniformLocation(g_texDirLightShader, "modelMatrix", &pLocation);
-				mat4 modelTransform = glm::translate(identity<mat4>(), g_CrystalPos) * eulerAngleY<float>(glm::radians<float>(g_CrystalRotation));
-				glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&modelTransform);
+				setModelMatrix(glm::translate(identity<mat4>(), g_CrystalPos) * eulerAngleY<float>(glm::radians<float>(g_CrystalRotation)));
 				g_CrystalMesh->setupTextures();
 				g_CrystalMesh->render();
 			}
@@ -390,7 +512,7 @@ void renderScene()
 	/*case 1:
 	{
 		// Render cube 
-		glUseProgram(g_flatColourShader);
+		GLState::UseProgram(g_flatColourShader);
 		GLint pLocation;
 		Helper::SetUniformLocation(g_flatColourShader, "viewMatrix", &pLocation);
 		glUniformMatrix4fv(pLocation, 1, GL_FALSE, (GLfloat*)&cameraView);
@@ -407,6 +529,14 @@ void renderScene()
 		g_Scene->Render();
 	}
 
+	FrameUniforms::EndFrame();
+}
+
+
+// Set a model matrix and the normal matrix the lighting shaders expect alongside it as the object uniform block
+void setModelMatrix(const mat4& _model)
+{
+	FrameUniforms::SetObject(_model, transpose(inverse(mat3(_model))));
 }
 
 
@@ -425,6 +555,60 @@ void updateScene()
 }
 
 
+// Load manifest.txt into the Scene, plus whatever -stress and -lights add to it
+void loadScene()
+{
+	ifstream manifest;
+	manifest.open("manifest.txt");
+
+	g_Scene->Load(manifest);
+	g_Scene->Init();
+
+	if (g_StressCopies > 0)
+	{
+		g_Scene->AddCopies("PLANET", g_StressCopies, 200.0f);
+	}
+	if (g_ExtraLights > 0)
+	{
+		g_Scene->AddPointLights(g_ExtraLights, 20.0f, 5.0f);
+	}
+
+	manifest.close();
+}
+
+
+// Unload the Scene and load it again a few times over (R)
+// everything it frees should be reused by the next load, so the arenas and caches must end up exactly as full as they started
+void reloadScene()
+{
+	// Unload deletes GL objects, so this needs the context on this thread
+	if (g_RenderThread)
+	{
+		cout << "RELOAD : NOT WITH -renderthread, THE RENDER THREAD HAS THE GL CONTEXT" << endl;
+		return;
+	}
+
+	const int cycles = 3;
+	const size_t arenaBytes = g_Scene->GetArena().GetBytes();
+	const size_t vertices = MeshArena::NumVertices();
+	const size_t textures = TextureCache::NumTextures();
+	const size_t images = TextureCache::NumImages();
+	for (int cycle = 0; cycle < cycles; cycle++)
+	{
+		g_Scene->Unload();
+		loadScene();
+
+		printf("RELOAD %d : scene arena %zu KB, %zu vertices in the MeshArena, %zu textures and %zu images in the TextureCache\n", cycle + 1,
+			g_Scene->GetArena().GetBytes() / 1024, MeshArena::NumVertices(), TextureCache::NumTextures(), TextureCache::NumImages());
+		if (g_Scene->GetArena().GetBytes() != arenaBytes || MeshArena::NumVertices() != vertices || TextureCache::NumTextures() != textures || TextureCache::NumImages() != images)
+		{
+			printf("RELOAD LEAKED : was scene arena %zu KB, %zu vertices, %zu textures and %zu images before reloading\n", arenaBytes / 1024, vertices, textures, images);
+			assert(0);
+		}
+	}
+}
+
+
 #pragma region Event handler functions
 //none of this is currently passed to the Game object
 //probably a good idea to do that
@@ -437,7 +621,11 @@ void resizeWindow(GLFWwindow* _window, int _width, int _height)
 		g_mainCamera->setAspect((float)_width / (float)_height);
 	}
 
-	glViewport(0, 0, _width, _height);		// Draw into entire window
+	// Draw into entire window, the render thread does this itself when the size in its snapshots changes
+	if (!g_RenderThread) {
+
+		glViewport(0, 0, _width, _height);
+	}
 }
 
 
@@ -467,6 +655,12 @@ void keyboardHandler(GLFWwindow* _window, int _key, int _scancode, int _action,
 			g_CrystalGlow = !g_CrystalGlow; // Toggle the glow state
 			break;
 
+		case GLFW_KEY_R:
+			if (_action == GLFW_PRESS) {
+				reloadScene();
+			}
+			break;
+
 
 			// Camera movement keys
 		case GLFW_KEY_W:
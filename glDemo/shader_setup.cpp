@@ -1,5 +1,6 @@
 
 #include "shader_setup.h"
+#include "UniformTable.h"
 
 using namespace std;
 
@@ -283,7 +284,8 @@ GLuint setupShaders(const string& vsPath, const string& fsPath, ShaderError* err
 		return 0;
 	}
 
-	// Shader program object setup successfully
+	// Shader program object setup successfully, note where all its uniforms are once and for all
+	UniformTable::Build(program);
 
 	if (error_result)
 		*error_result = ShaderError::GLSL_OK;
@@ -30,4 +30,77 @@ public:
 		_file >> dummy >> _out; _file.ignore(255, '\n');
 		cout << _message << " : " << _out << endl;
 	}
+
+	//for fields that only some entries in the manifest have
+	//if the next line starts with _key (with or without the colon) read its value and return true
+	//otherwise leave the file where it was so the next field can be read as normal
+	static bool OptionalString(ifstream& _file, string _key, string& _out)
+	{
+		streampos start = _file.tellg();
+		string key;
+		_file >> key;
+		if (_file && (key == _key || key == _key + ":"))
+		{
+			_file >> _out; _file.ignore(255, '\n');
+			cout << _key << " : " << _out << endl;
+			return true;
+		}
+
+		_file.clear();
+		_file.seekg(start);
+		return false;
+	}
+
+	//same for a single number
+	static bool OptionalFloat(ifstream& _file, string _key, float& _out)
+	{
+		streampos start = _file.tellg();
+		string key;
+		_file >> key;
+		if (_file && (key == _key || key == _key + ":"))
+		{
+			_file >> _out; _file.ignore(255, '\n');
+			cout << _key << " : " << _out << endl;
+			return true;
+		}
+
+		_file.clear();
+		_file.seekg(start);
+		return false;
+	}
+
+	//the manifest's section headers, like "LIGHTS 5", returning the number of entries that follow
+	static int SectionCount(ifstream& _file)
+	{
+		string dummy;
+		int count = 0;
+		_file >> dummy >> count; _file.ignore(256, '\n');
+		return count;
+	}
+
+	//skip the { opening an entry and read its TYPE, the closing } is left for the caller to skip once it has read the rest
+	static string EntryType(ifstream& _file)
+	{
+		string dummy, type;
+		_file.ignore(256, '\n');
+		_file >> dummy >> type; _file.ignore(256, '\n');
+		return type;
+	}
+
+	//skip a whole { ... } entry, returning its NAME if it has one
+	static string SkipEntry(ifstream& _file)
+	{
+		string line, name;
+		getline(_file, line);	//{
+		while (getline(_file, line) && line.find('}') == string::npos)
+		{
+			size_t start = line.find_first_not_of(" \t");
+			if (start != string::npos && line.compare(start, 5, "NAME:") == 0)
+			{
+				name = line.substr(line.find_first_not_of(" \t", start + 5));
+				name.erase(name.find_last_not_of(" \t\r") + 1);
+			}
+		}
+		return name;
+	}
 };